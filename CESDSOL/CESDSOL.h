@@ -4,27 +4,53 @@
 #include "Discretization/StructuredFiniteDifferenceDiscretization.h"
 #include "Grid/DirectProductGrid.h"
 #include "Grid/Grid.h"
+#include "Math/AutotunedSolver.h"
+#include "Math/BandedSolver.h"
+#include "Math/EquilibratedSolver.h"
+#include "Math/FieldSplitPreconditioner.h"
 #include "Math/GoldenSectionSearch.h"
+#include "Math/MixedPrecisionSolver.h"
 #include "Math/ModifiedNewton.h"
+#include "Math/Multigrid/GeometricMultigrid.h"
+#include "Math/Multigrid/SmoothedAggregation.h"
+#include "Math/Native/BiCGSTAB.h"
+#include "Math/Native/BlockILU0.h"
+#include "Math/Native/FGMRES.h"
+#include "Math/Native/ILUK.h"
+#include "Math/Native/SparseLU.h"
+#include "Math/ODE/Tables/Alexander21.h"
+#include "Math/ODE/Tables/AscherRuuthSpiteri21.h"
+#include "Math/ODE/Tables/BlanesMoan4.h"
 #include "Math/ODE/Tables/BogackiShampine32.h"
+#include "Math/ODE/Tables/CarpenterKennedy43.h"
 #include "Math/ODE/Tables/DormandPrince54.h"
 #include "Math/ODE/Tables/DormandPrince853.h"
 #include "Math/ODE/Tables/Euler1.h"
 #include "Math/ODE/Tables/Feagin109.h"
 #include "Math/ODE/Tables/Fehlberg21.h"
 #include "Math/ODE/Tables/Heun21.h"
+#include "Math/ODE/Tables/HoseaShampine23.h"
 #include "Math/ODE/Tables/Midpoint21.h"
 #include "Math/ODE/Tables/OwrenZennaro32.h"
 #include "Math/ODE/Tables/OwrenZennaro43.h"
 #include "Math/ODE/Tables/OwrenZennaro54.h"
 #include "Math/ODE/Tables/Ralston21.h"
 #include "Math/ODE/Tables/RungeKutta4.h"
+#include "Math/ODE/Tables/StormerVerlet2.h"
 #include "Math/ODE/Tables/TanakaYamashita76.h"
 #include "Math/ODE/Tables/Tsitouras54.h"
 #include "Math/ODE/Tables/TsitourasPapakostas87.h"
 #include "Math/ODE/Tables/Verner87.h"
+#include "Math/ODE/Tables/Verwer21.h"
+#include "Math/ODE/Tables/Williamson32.h"
+#include "Math/ODE/Tables/Yoshida4.h"
+#include "Math/ODE/ImplicitRungeKuttaSolver.h"
 #include "Math/ODE/RungeKuttaSolver.h"
+#include "Math/ODE/SymplecticSolver.h"
+#include "Math/PointMajorSolver.h"
+#include "Math/Reordering.h"
 #include "Math/TrivialLineSearcher.h"
+#include "Math/TunedSparseOperator.h"
 #include "Math/VectorOperations.h"
 #include "ParametricSweep/AdaptiveParametricSweeper.h"
 #include "ParametricSweep/FixedStepParametricSweeper.h"
@@ -34,9 +60,11 @@
 
 #if MathLibrary == MKLMath
 #include "Math/MKL/FGMRES.h"
+#include "Math/MKL/FastDiagonalization.h"
 #include "Math/MKL/ILU0.h"
 #include "Math/MKL/ILUT.h"
 #include "Math/MKL/PARDISO.h"
+#include "Math/MKL/PARDISOAnalysisCache.h"
 #endif
 
 #ifdef UseHYPRE
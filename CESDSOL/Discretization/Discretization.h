@@ -1,7 +1,10 @@
 #pragma once
 
+#include "Discretization/TensorProductStencil.h"
 #include "Grid/Grid.h"
 
+#include <optional>
+
 namespace CESDSOL
 {
 	template<size_t DimensionArg, template<typename> typename MatrixTypeArg = CSRMatrix, typename CoordinateTypeArg = double>
@@ -18,6 +21,24 @@ namespace CESDSOL
 			const std::array<CoordinateType, Dimension>& point) const noexcept = 0;
 		[[nodiscard]] virtual Vector<CoordinateType> GetIntegrationWeightsVector(const Grid<Dimension, CoordinateType>& grid) const noexcept = 0;
 
+		// Returns differentiation matrix along single axis acting on points of this axis only, available only for
+		// discretizations on grids with tensor product structure.
+		[[nodiscard]] virtual MatrixType GetAxisDifferentiationMatrix(const Grid<Dimension, CoordinateType>&,
+			size_t, size_t) const noexcept
+		{
+			Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Discretization,
+				"Axis differentiation matrices are not supported by discretization.");
+			return MatrixType();
+		}
+
+		// Returns matrix-free representation of differentiation operator if discretization admits one, otherwise
+		// differentiation matrix is used.
+		[[nodiscard]] virtual std::optional<TensorProductStencil<Dimension, CoordinateType>> GetDifferentiationStencil(
+			const Grid<Dimension, CoordinateType>&, const std::array<size_t, Dimension>&) const noexcept
+		{
+			return std::nullopt;
+		}
+
 		virtual ~Discretization() = default;
 	};
 }
\ No newline at end of file
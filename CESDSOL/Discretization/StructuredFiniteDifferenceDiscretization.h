@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Discretization/Discretization.h"
+#include "Discretization/TensorProductStencil.h"
 #include "Grid/DirectProductGrid.h"
 #include "Math/Concepts.h"
 #include "Math/LinearAlgebra.h"
@@ -14,6 +15,10 @@ namespace CESDSOL
 	class StructuredFiniteDifferenceDiscretizationCalculator
 	{
 	private:
+		// Relative difference of weights below which stencils of neighbouring points are treated as equal, covers
+		// rounding in coordinates of uniform grids.
+		static constexpr double UniformityTolerance = 1e-10;
+
 		template<typename ScalarType, Concepts::Vector InputCollection, Concepts::Vector OutputCollection>
 		constexpr void GenerateFornbergWeights(const InputCollection& grid,
 			OutputCollection& weights, size_t derivativeOrder, ScalarType center = 0) const noexcept
@@ -59,7 +64,7 @@ namespace CESDSOL
 		}
 
 		template<size_t Dimension, typename ScalarType>
-		[[nodiscard]] constexpr CSRMatrix<ScalarType> GetDifferentiationMatrix(const DirectProductGrid<Dimension, ScalarType>& grid, size_t dimensionIndex,
+		[[nodiscard]] AxisStencil<ScalarType> GetAxisStencil(const DirectProductGrid<Dimension, ScalarType>& grid, size_t dimensionIndex,
 			size_t derivativeOrder, size_t stencilSize) const noexcept
 		{
 			const auto dimensionSize = grid.GetDimensionSize(dimensionIndex);
@@ -68,19 +73,23 @@ namespace CESDSOL
 			const auto halfStencil = stencilSize / 2;
 			const auto period = grid.GetPeriod(dimensionIndex);
 
-			auto weights = TwoLevelArray<ScalarType>({ dimensionSize, stencilSize });
+			auto stencil = AxisStencil<ScalarType>{ dimensionIndex, dimensionSize, stencilSize, isPeriodic,
+				Array<ScalarType>(dimensionSize * stencilSize) };
+			auto weights = [&](size_t i) { return std::span(stencil.Weights.data() + i * stencilSize, stencilSize); };
 
 			if (!isPeriodic)
 			{
 				for (size_t i = 0; i < halfStencil; ++i)
 				{
+					auto pointWeights = weights(i);
 					GenerateFornbergWeights(std::span(gridData.data(), stencilSize),
-						weights[i], derivativeOrder, gridData[i]);
+						pointWeights, derivativeOrder, gridData[i]);
 				}
 				for (size_t i = dimensionSize - halfStencil; i < dimensionSize; ++i)
 				{
+					auto pointWeights = weights(i);
 					GenerateFornbergWeights(std::span(gridData.end() - stencilSize, gridData.end()), 
-						weights[i], derivativeOrder, gridData[i]);
+						pointWeights, derivativeOrder, gridData[i]);
 				}
 			}
 			else
@@ -96,7 +105,8 @@ namespace CESDSOL
 					{
 						tmp[j] = gridData[j - halfStencil + i];
 					}
-					GenerateFornbergWeights(tmp, weights[i], derivativeOrder, gridData[i]);
+					auto pointWeights = weights(i);
+					GenerateFornbergWeights(tmp, pointWeights, derivativeOrder, gridData[i]);
 				}
 				for (size_t i = dimensionSize - halfStencil; i < dimensionSize; i++)
 				{
@@ -108,71 +118,56 @@ namespace CESDSOL
 					{
 						tmp[j] = *period + gridData[j - (dimensionSize - i + halfStencil)];
 					}
-					GenerateFornbergWeights(tmp, weights[i], derivativeOrder, gridData[i]);
+					auto pointWeights = weights(i);
+					GenerateFornbergWeights(tmp, pointWeights, derivativeOrder, gridData[i]);
 				}
 			}
 			for (size_t i = halfStencil; i < dimensionSize - halfStencil; i++)
 			{
+				auto pointWeights = weights(i);
 				GenerateFornbergWeights(std::span(gridData.begin() + i - halfStencil, stencilSize), 
-					weights[i], derivativeOrder, gridData[i]);
+					pointWeights, derivativeOrder, gridData[i]);
 			};
+			stencil.CompressUniformInterior(static_cast<ScalarType>(UniformityTolerance));
+			return stencil;
+		}
 
-			const size_t nonzeroCount = std::accumulate(weights.begin(), weights.end(), 0, 
-				[](auto sum, const auto& element) {return sum + CountNonZero(element); }) * 
-				grid.GetSize() / dimensionSize;
-
-			auto result = CSRMatrix<ScalarType>(grid.GetSize(), grid.GetSize(), nonzeroCount);
+		// Nonzero weights of axis stencil for each point of the axis, sorted by index.
+		template<typename ScalarType>
+		struct AxisStencilEntries
+		{
+			Array<size_t> Starts;
+			Array<size_t> Indices;
+			Array<ScalarType> Weights;
+		};
 
-			std::array<size_t, Dimension> tmp;
-			size_t setCount = 0;
-			auto setElement = [&](auto tmpWeight, auto index)
-			{
-				if (std::abs(tmpWeight) > std::numeric_limits<ScalarType>::epsilon())
-				{
-					result.SetValue(setCount, tmpWeight);
-					tmp[dimensionIndex] = index;
-					result.SetColumnIndex(setCount, grid.GetSingleIndexByMultiIndex(tmp));
-					++setCount;
-				};
-			};
-			for (size_t i = 0; i < grid.GetSize(); i++)
+		template<typename ScalarType>
+		[[nodiscard]] AxisStencilEntries<ScalarType> GetAxisStencilEntries(const AxisStencil<ScalarType>& stencil) const noexcept
+		{
+			std::vector<std::pair<size_t, ScalarType>> entries;
+			entries.reserve(stencil.AxisSize * stencil.StencilSize);
+			auto starts = Array<size_t>(stencil.AxisSize + 1);
+			for (size_t i = 0; i < stencil.AxisSize; ++i)
 			{
-				result.SetRowCount(i, setCount);
-				grid.GetMultiIndexBySingleIndex(i, tmp);
-				const size_t directionCoordinate = tmp[dimensionIndex];
-				if (!isPeriodic || (directionCoordinate < dimensionSize - halfStencil && directionCoordinate >= halfStencil))
-				{
-					auto left = (directionCoordinate < halfStencil ? 0 : (directionCoordinate >= dimensionSize - halfStencil ?
-						dimensionSize - stencilSize : directionCoordinate - halfStencil));
-					for (size_t j = 0; j < stencilSize; ++j)
-					{
-						setElement(weights[directionCoordinate][j], left + j);
-					};
-				}
-				else if (directionCoordinate >= dimensionSize - halfStencil)
-				{
-					for (size_t j = dimensionSize - directionCoordinate + halfStencil; j < stencilSize; ++j)
-					{
-						setElement(weights[directionCoordinate][j], j - (dimensionSize - directionCoordinate + halfStencil));
-					}
-					for (size_t j = 0; j < dimensionSize - directionCoordinate + halfStencil; ++j)
-					{
-						setElement(weights[directionCoordinate][j], directionCoordinate - halfStencil + j);
-					};
-				}
-				else
+				const auto firstIndex = stencil.GetFirstIndex(i);
+				const auto* weights = stencil.GetWeights(i);
+				for (size_t j = 0; j < stencil.StencilSize; ++j)
 				{
-					for (size_t j = halfStencil - directionCoordinate; j < stencilSize; ++j)
+					if (AxisStencil<ScalarType>::IsNonZero(weights[j]))
 					{
-						setElement(weights[directionCoordinate][j], j - halfStencil + directionCoordinate);
-					};
-					for (size_t j = 0; j < halfStencil - directionCoordinate; ++j)
-					{
-						setElement(weights[directionCoordinate][j], dimensionSize - halfStencil + directionCoordinate + j);
+						entries.emplace_back(stencil.GetIndex(firstIndex, j), weights[j]);
 					}
 				}
-			};
-
+				std::sort(entries.begin() + starts[i], entries.end(),
+					[](const auto& left, const auto& right) { return left.first < right.first; });
+				starts[i + 1] = entries.size();
+			}
+			auto result = AxisStencilEntries<ScalarType>{ std::move(starts), Array<size_t>(entries.size()), Array<ScalarType>(entries.size()) };
+			for (size_t i = 0; i < entries.size(); ++i)
+			{
+				result.Indices[i] = entries[i].first;
+				result.Weights[i] = entries[i].second;
+			}
 			return result;
 		}
 
@@ -224,37 +219,106 @@ namespace CESDSOL
 		}
 
 	public:
+		// Differentiation matrix is Kronecker product of axis stencils, so every row is filled directly as product of
+		// stencil entries of its point along each differentiated axis. Axes are traversed from the slowest one, so
+		// columns of each row come out sorted.
 		template<size_t Dimension, typename ScalarType>
 		[[nodiscard]] CSRMatrix<ScalarType> GetDifferentiationMatrix(const DirectProductGrid<Dimension, ScalarType>& grid,
 			const std::array<size_t, Dimension>& derivativeOrders, const std::array<size_t, Dimension>& stencilSizes) const noexcept
 		{
-			bool started = false;
-			CSRMatrix<ScalarType> tmp;
-			for (size_t i = 0; i < Dimension; i++)
+			const auto stencil = GetDifferentiationStencil(grid, derivativeOrders, stencilSizes);
+			const auto& axisStencils = stencil.GetAxisStencils();
+			if (axisStencils.empty())
 			{
-				if (derivativeOrders[i] > 0)
+				Logger::Log(MessageType::Warning, MessagePriority::Medium, MessageTag::Discretization,
+					"Trivial differentiation matrix is constructed");
+				return MakeIdentityMatrix<CSRMatrix<ScalarType>>(grid.GetSize());
+			}
+
+			const auto axisCount = axisStencils.size();
+			std::array<AxisStencilEntries<ScalarType>, Dimension> entries;
+			for (size_t i = 0; i < axisCount; ++i)
+			{
+				entries[i] = GetAxisStencilEntries(axisStencils[i]);
+			}
+
+			const auto size = grid.GetSize();
+			auto rowStarts = Array<size_t>(size + 1);
+			ParallelFor(0, size,
+				[&](int64_t i)
 				{
-					if (started)
+					const auto multiIndex = grid.GetMultiIndexBySingleIndex(i);
+					size_t rowLength = 1;
+					for (size_t j = 0; j < axisCount; ++j)
 					{
-						tmp = Multiply(tmp, GetDifferentiationMatrix(grid, i, derivativeOrders[i], stencilSizes[i]));
+						const auto pointIndex = multiIndex[axisStencils[j].AxisIndex];
+						rowLength *= entries[j].Starts[pointIndex + 1] - entries[j].Starts[pointIndex];
 					}
-					else
-					{
-						tmp = GetDifferentiationMatrix(grid, i, derivativeOrders[i], stencilSizes[i]);	
-						started = true;
-					}
-				}
-			}
-			if (started)
+					rowStarts[i + 1] = rowLength;
+				});
+			for (size_t i = 0; i < size; ++i)
 			{
-				return tmp;
+				rowStarts[i + 1] += rowStarts[i];
 			}
-			else
+
+			auto result = CSRMatrix<ScalarType>(size, size, rowStarts[size]);
+			ParallelFor(0, size,
+				[&](int64_t i)
+				{
+					result.SetRowCount(i, rowStarts[i]);
+					if (rowStarts[i] == rowStarts[i + 1])
+					{
+						return;
+					}
+					auto multiIndex = grid.GetMultiIndexBySingleIndex(i);
+					std::array<size_t, Dimension> starts;
+					std::array<size_t, Dimension> ends;
+					for (size_t j = 0; j < axisCount; ++j)
+					{
+						const auto pointIndex = multiIndex[axisStencils[j].AxisIndex];
+						starts[j] = entries[j].Starts[pointIndex];
+						ends[j] = entries[j].Starts[pointIndex + 1];
+					}
+					auto positions = starts;
+					for (size_t position = rowStarts[i]; position < rowStarts[i + 1]; ++position)
+					{
+						ScalarType value = 1;
+						for (size_t j = 0; j < axisCount; ++j)
+						{
+							value *= entries[j].Weights[positions[j]];
+							multiIndex[axisStencils[j].AxisIndex] = entries[j].Indices[positions[j]];
+						}
+						result.SetColumnIndex(position, grid.GetSingleIndexByMultiIndex(multiIndex));
+						result.SetValue(position, value);
+
+						for (size_t j = axisCount; j-- > 0;)
+						{
+							if (++positions[j] < ends[j])
+							{
+								break;
+							}
+							positions[j] = starts[j];
+						}
+					}
+				});
+			return result;
+		}
+
+		template<size_t Dimension, typename ScalarType>
+		[[nodiscard]] TensorProductStencil<Dimension, ScalarType> GetDifferentiationStencil(const DirectProductGrid<Dimension, ScalarType>& grid,
+			const std::array<size_t, Dimension>& derivativeOrders, const std::array<size_t, Dimension>& stencilSizes) const noexcept
+		{
+			std::vector<AxisStencil<ScalarType>> axisStencils;
+			std::array<size_t, Dimension> dimensionSizes;
+			for (size_t i = 0; i < Dimension; i++)
 			{
-				Logger::Log(MessageType::Warning, MessagePriority::Medium, MessageTag::Discretization,
-					"Trivial differentiation matrix is constructed");
-				return MakeIdentityMatrix<CSRMatrix<ScalarType>>(grid.GetSize());
+				dimensionSizes[i] = grid.GetDimensionSize(i);
+				if (derivativeOrders[i] > 0)
+				{
+					axisStencils.push_back(GetAxisStencil(grid, i, derivativeOrders[i], stencilSizes[i]));
+				}
 			}
+			return TensorProductStencil<Dimension, ScalarType>(dimensionSizes, std::move(axisStencils));
 		}
 
 		template<typename ScalarType>
@@ -339,6 +403,13 @@ namespace CESDSOL
 			return StructuredFiniteDifferenceDiscretizationCalculator().GetDifferentiationMatrix(dpGrid, derivativeOrders, stencilSizes);
 		}
 
+		[[nodiscard]] std::optional<TensorProductStencil<Dimension, CoordinateType>> GetDifferentiationStencil(
+			const Grid<Dimension, CoordinateType>& grid, const std::array<size_t, Dimension>& derivativeOrders) const noexcept override
+		{
+			const auto& dpGrid = dynamic_cast<const DirectProductGrid<Dimension, CoordinateType>&>(grid);
+			return StructuredFiniteDifferenceDiscretizationCalculator().GetDifferentiationStencil(dpGrid, derivativeOrders, stencilSizes);
+		}
+
 		[[nodiscard]] SparseVector<CoordinateType> GetInterpolationWeightsVector(const Grid<Dimension, CoordinateType>& grid,
 			const std::array<CoordinateType, Dimension>& point) const noexcept override
 		{
@@ -352,6 +423,16 @@ namespace CESDSOL
 			return StructuredFiniteDifferenceDiscretizationCalculator().GetIntegrationWeightsVector(dpGrid);
 		}
 
+		[[nodiscard]] MatrixType GetAxisDifferentiationMatrix(const Grid<Dimension, CoordinateType>& grid,
+			size_t axisIndex, size_t derivativeOrder) const noexcept override
+		{
+			const auto& dpGrid = dynamic_cast<const DirectProductGrid<Dimension, CoordinateType>&>(grid);
+			const auto axisGrid = DirectProductGrid<1, CoordinateType>(std::array<SingleDimensionalGrid<CoordinateType>, 1>{
+				{ { dpGrid.GetGrid(axisIndex), dpGrid.GetPeriod(axisIndex) } } });
+			return StructuredFiniteDifferenceDiscretizationCalculator().GetDifferentiationMatrix(axisGrid, derivativeOrder,
+				stencilSizes[axisIndex]);
+		}
+
 	private:
 		[[nodiscard]] static std::array<size_t, Dimension> FillStencils(size_t stencilSize) noexcept
 		{
@@ -0,0 +1,353 @@
+#pragma once
+
+#include "Math/Array.h"
+#include "Math/Concepts.h"
+#include "Utils/Parallelism/Parallelism.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+namespace CESDSOL
+{
+	// One-dimensional stencil along single axis of direct product grid. Point i of the axis uses StencilSize
+	// consecutive points starting from GetFirstIndex(i), indices are taken modulo axis size for periodic axes.
+	template<typename ScalarType>
+	struct AxisStencil
+	{
+		size_t AxisIndex = 0;
+		size_t AxisSize = 0;
+		size_t StencilSize = 0;
+		bool IsPeriodic = false;
+		// Weights of the axis points, StencilSize per point. Points in [InteriorStart, InteriorEnd) share single
+		// weight vector stored at position of InteriorStart.
+		Array<ScalarType> Weights;
+		size_t InteriorStart = 0;
+		size_t InteriorEnd = 0;
+
+		// Filter of weights for all sparse representations of the stencil. Comparison is exact, since sweeps apply all
+		// weights and patterns must describe the same operator. Weights vanishing only by rounding are zeroed by
+		// CompressUniformInterior.
+		[[nodiscard]] static bool IsNonZero(ScalarType weight) noexcept
+		{
+			return weight != 0;
+		}
+
+		[[nodiscard]] const ScalarType* GetWeights(size_t pointIndex) const noexcept
+		{
+			if (pointIndex < InteriorStart || InteriorStart == InteriorEnd)
+			{
+				return Weights.data() + pointIndex * StencilSize;
+			}
+			if (pointIndex < InteriorEnd)
+			{
+				return Weights.data() + InteriorStart * StencilSize;
+			}
+			return Weights.data() + (pointIndex + 1 + InteriorStart - InteriorEnd) * StencilSize;
+		}
+
+		// Finds the widest range of points around the axis middle with weights equal up to relative tolerance, as on
+		// uniform grids, and keeps single weight vector for it.
+		void CompressUniformInterior(ScalarType relativeTolerance) noexcept
+		{
+			if (InteriorStart != InteriorEnd || AxisSize == 0)
+			{
+				return;
+			}
+			const auto* reference = Weights.data() + AxisSize / 2 * StencilSize;
+			ScalarType scale = 0;
+			for (size_t j = 0; j < StencilSize; ++j)
+			{
+				scale = std::max(scale, std::abs(reference[j]));
+			}
+			const auto isUniform = [&](size_t pointIndex)
+			{
+				const auto* weights = Weights.data() + pointIndex * StencilSize;
+				for (size_t j = 0; j < StencilSize; ++j)
+				{
+					if (std::abs(weights[j] - reference[j]) > relativeTolerance * scale)
+					{
+						return false;
+					}
+				}
+				return true;
+			};
+			size_t start = AxisSize / 2;
+			while (start > 0 && isUniform(start - 1))
+			{
+				--start;
+			}
+			size_t end = AxisSize / 2 + 1;
+			while (end < AxisSize && isUniform(end))
+			{
+				++end;
+			}
+			if (end - start < 2)
+			{
+				return;
+			}
+
+			auto compressed = Array<ScalarType>((AxisSize + 1 + start - end) * StencilSize);
+			auto* output = std::copy(Weights.data(), Weights.data() + start * StencilSize, compressed.data());
+			for (size_t j = 0; j < StencilSize; ++j)
+			{
+				// Weights vanishing on exactly uniform grid are left only by rounding.
+				*output++ = std::abs(reference[j]) > relativeTolerance * scale ? reference[j] : 0;
+			}
+			std::copy(Weights.data() + end * StencilSize, Weights.end(), output);
+			Weights = std::move(compressed);
+			InteriorStart = start;
+			InteriorEnd = end;
+		}
+
+		// Index of the first stencil point, shifted by axis size for periodic axes to stay nonnegative.
+		[[nodiscard]] size_t GetFirstIndex(size_t pointIndex) const noexcept
+		{
+			const auto halfStencil = StencilSize / 2;
+			if (IsPeriodic)
+			{
+				return pointIndex + AxisSize - halfStencil;
+			}
+			if (pointIndex < halfStencil)
+			{
+				return 0;
+			}
+			if (pointIndex >= AxisSize - halfStencil)
+			{
+				return AxisSize - StencilSize;
+			}
+			return pointIndex - halfStencil;
+		}
+
+		// Returns whether stencil of the point does not wrap around the axis.
+		[[nodiscard]] bool IsContiguous(size_t pointIndex) const noexcept
+		{
+			const auto halfStencil = StencilSize / 2;
+			return !IsPeriodic || (pointIndex >= halfStencil && pointIndex + StencilSize - halfStencil <= AxisSize);
+		}
+
+		[[nodiscard]] size_t GetIndex(size_t firstIndex, size_t stencilIndex) const noexcept
+		{
+			return IsPeriodic ? (firstIndex + stencilIndex) % AxisSize : firstIndex + stencilIndex;
+		}
+	};
+
+	// Matrix-free differentiation operator on direct product grid, product of one-dimensional stencils along
+	// different axes. Only per-axis weight tables are stored, the operator is applied by line sweeps along each axis:
+	// lines along the fastest axis are processed as dot products, along other axes whole blocks of contiguous
+	// points are updated at once, so that inner loops have unit stride and no index arrays are involved.
+	template<size_t DimensionArg, typename ScalarTypeArg = double>
+	class TensorProductStencil
+	{
+	public:
+		static constexpr size_t Dimension = DimensionArg;
+		using ScalarType = ScalarTypeArg;
+
+		TensorProductStencil(const std::array<size_t, Dimension>& aDimensionSizes, std::vector<AxisStencil<ScalarType>> aAxisStencils) noexcept
+			: dimensionSizes(aDimensionSizes)
+			, axisStencils(std::move(aAxisStencils))
+		{
+			size = 1;
+			for (size_t i = Dimension; i-- > 0;)
+			{
+				strides[i] = size;
+				size *= dimensionSizes[i];
+			}
+		}
+
+		[[nodiscard]] size_t Size() const noexcept
+		{
+			return size;
+		}
+
+		[[nodiscard]] const std::vector<AxisStencil<ScalarType>>& GetAxisStencils() const noexcept
+		{
+			return axisStencils;
+		}
+
+		// Returns number of nonzero weights in operator row of the point.
+		[[nodiscard]] size_t GetRowLength(size_t pointIndex) const noexcept
+		{
+			size_t result = 1;
+			for (const auto& stencil : axisStencils)
+			{
+				const auto* weights = stencil.GetWeights(GetAxisPointIndex(stencil, pointIndex));
+				size_t count = 0;
+				for (size_t j = 0; j < stencil.StencilSize; ++j)
+				{
+					if (AxisStencil<ScalarType>::IsNonZero(weights[j]))
+					{
+						++count;
+					}
+				}
+				result *= count;
+			}
+			return result;
+		}
+
+		// Calls body(columnIndex, weight) for every nonzero weight in operator row of the point.
+		template<typename BodyType>
+		void ForEachRowEntry(size_t pointIndex, BodyType&& body) const noexcept
+		{
+			VisitRowEntries(0, pointIndex, pointIndex, ScalarType(1), body);
+		}
+
+		template<Concepts::Vector InputCollection, Concepts::Vector OutputCollection>
+		void Apply(const InputCollection& x, OutputCollection& y) const noexcept
+		{
+			AssertE(x.size() == size && y.size() == size, MessageTag::Math,
+				"Trying to apply stencil to vectors of incompatible sizes.");
+			using ValueType = typename OutputCollection::value_type;
+
+			if (axisStencils.size() == 0)
+			{
+				std::copy(x.data(), x.data() + size, y.data());
+				return;
+			}
+			if (axisStencils.size() == 1)
+			{
+				Sweep(axisStencils[0], x.data(), y.data());
+				return;
+			}
+			if constexpr (std::is_same_v<ValueType, ScalarType>)
+			{
+				SweepAll(x.data(), y.data(), sweepBuffers);
+			}
+			else
+			{
+				auto buffers = std::array<Array<ValueType>, 2>();
+				SweepAll(x.data(), y.data(), buffers);
+			}
+		}
+
+	private:
+		// Number of contiguous points processed by single task in sweeps along slow axes.
+		static constexpr size_t BlockSize = 256;
+
+		[[nodiscard]] size_t GetAxisPointIndex(const AxisStencil<ScalarType>& stencil, size_t pointIndex) const noexcept
+		{
+			return pointIndex / strides[stencil.AxisIndex] % dimensionSizes[stencil.AxisIndex];
+		}
+
+		template<typename BodyType>
+		void VisitRowEntries(size_t stencilIndex, size_t pointIndex, size_t columnIndex, ScalarType weight, BodyType& body) const noexcept
+		{
+			if (stencilIndex == axisStencils.size())
+			{
+				body(columnIndex, weight);
+				return;
+			}
+			const auto& stencil = axisStencils[stencilIndex];
+			const auto axisPointIndex = GetAxisPointIndex(stencil, pointIndex);
+			const auto* weights = stencil.GetWeights(axisPointIndex);
+			const auto firstIndex = stencil.GetFirstIndex(axisPointIndex);
+			for (size_t j = 0; j < stencil.StencilSize; ++j)
+			{
+				if (AxisStencil<ScalarType>::IsNonZero(weights[j]))
+				{
+					const auto shift = stencil.GetIndex(firstIndex, j) - axisPointIndex;
+					VisitRowEntries(stencilIndex + 1, pointIndex, columnIndex + shift * strides[stencil.AxisIndex],
+						weight * weights[j], body);
+				}
+			}
+		}
+
+		// Sweeps along all axes for two or more stencils, intermediate results are kept in the buffers, which are sized
+		// on first use.
+		template<typename ValueType>
+		void SweepAll(const ValueType* x, ValueType* y, std::array<Array<ValueType>, 2>& buffers) const noexcept
+		{
+			if (buffers[0].size() != size)
+			{
+				buffers[0] = Array<ValueType>(size);
+			}
+			if (axisStencils.size() > 2 && buffers[1].size() != size)
+			{
+				buffers[1] = Array<ValueType>(size);
+			}
+			Sweep(axisStencils[0], x, buffers[0].data());
+			for (size_t i = 1; i + 1 < axisStencils.size(); ++i)
+			{
+				Sweep(axisStencils[i], buffers[(i + 1) % 2].data(), buffers[i % 2].data());
+			}
+			Sweep(axisStencils.back(), buffers[axisStencils.size() % 2].data(), y);
+		}
+
+		template<typename ValueType>
+		void Sweep(const AxisStencil<ScalarType>& stencil, const ValueType* x, ValueType* y) const noexcept
+		{
+			const auto axisSize = dimensionSizes[stencil.AxisIndex];
+			const auto stencilSize = stencil.StencilSize;
+			const auto innerSize = strides[stencil.AxisIndex];
+
+			if (innerSize == 1)
+			{
+				ParallelFor(0, size,
+					[&](int64_t index)
+					{
+						const auto pointIndex = static_cast<size_t>(index) % axisSize;
+						const auto* line = x + (index - pointIndex);
+						const auto* weights = stencil.GetWeights(pointIndex);
+						const auto firstIndex = stencil.GetFirstIndex(pointIndex);
+						ValueType sum = 0;
+						if (stencil.IsContiguous(pointIndex))
+						{
+							const auto* source = line + (stencil.IsPeriodic ? firstIndex - axisSize : firstIndex);
+							for (size_t j = 0; j < stencilSize; ++j)
+							{
+								sum += weights[j] * source[j];
+							}
+						}
+						else
+						{
+							for (size_t j = 0; j < stencilSize; ++j)
+							{
+								sum += weights[j] * line[stencil.GetIndex(firstIndex, j)];
+							}
+						}
+						y[index] = sum;
+					});
+				return;
+			}
+
+			const auto blockCount = (innerSize + BlockSize - 1) / BlockSize;
+			ParallelFor(0, size / innerSize * blockCount,
+				[&](int64_t task)
+				{
+					const auto lineIndex = static_cast<size_t>(task) / blockCount;
+					const auto blockStart = static_cast<size_t>(task) % blockCount * BlockSize;
+					const auto blockSize = std::min(BlockSize, innerSize - blockStart);
+					const auto pointIndex = lineIndex % axisSize;
+					const auto* line = x + (lineIndex - pointIndex) * innerSize + blockStart;
+					auto* target = y + lineIndex * innerSize + blockStart;
+					const auto* weights = stencil.GetWeights(pointIndex);
+					const auto firstIndex = stencil.GetFirstIndex(pointIndex);
+
+					const auto* source = line + stencil.GetIndex(firstIndex, 0) * innerSize;
+					for (size_t k = 0; k < blockSize; ++k)
+					{
+						target[k] = weights[0] * source[k];
+					}
+					for (size_t j = 1; j < stencilSize; ++j)
+					{
+						const auto weight = weights[j];
+						source = line + stencil.GetIndex(firstIndex, j) * innerSize;
+						for (size_t k = 0; k < blockSize; ++k)
+						{
+							target[k] += weight * source[k];
+						}
+					}
+				});
+		}
+
+		std::array<size_t, Dimension> dimensionSizes;
+		std::array<size_t, Dimension> strides;
+		std::vector<AxisStencil<ScalarType>> axisStencils;
+		size_t size = 0;
+		// Intermediate results of Apply, kept between calls since the operator is applied on every residual
+		// evaluation. Apply is therefore not safe to call concurrently on the same stencil.
+		mutable std::array<Array<ScalarType>, 2> sweepBuffers;
+	};
+}
\ No newline at end of file
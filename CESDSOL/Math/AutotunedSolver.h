@@ -0,0 +1,313 @@
+#pragma once
+
+#include "Math/CSRMatrixOperations.h"
+#include "Math/LinearAlgebra.h"
+#include "Math/LinearSolver.h"
+#include "Math/Native/FGMRES.h"
+#include "Math/Native/ILUK.h"
+#include "Math/Native/SparseLU.h"
+#if MathLibrary == MKLMath
+#include "Math/MKL/FGMRES.h"
+#include "Math/MKL/ILU0.h"
+#include "Math/MKL/ILUT.h"
+#include "Math/MKL/PARDISO.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace CESDSOL
+{
+	// Named factory of linear solver configuration tried by AutotunedSolver.
+	template<Concepts::CSRMatrix MatrixType>
+	struct LinearSolverCandidate
+	{
+		std::string name;
+		std::function<uptr<LinearSolver<MatrixType, Vector<double>>>()> create;
+	};
+
+	// Linear solver which selects the fastest of candidate configurations on the first matrix. Every candidate solves
+	// the first system several times, time of the last solve is taken as its score, since analysis and pattern
+	// dependent setup are amortized over Newton iterations and only refactorization or preconditioner setup and
+	// iterations are paid for every Jacobian. Candidates which fail or give relative residual above the tolerance are
+	// rejected. The winner is kept with its state and used for all subsequent solves. If decision file is set,
+	// decisions are stored there keyed by problem name, size and number of nonzeros of the matrix, and a stored
+	// decision is used without trials.
+	template<Concepts::CSRMatrix MatrixType>
+	class AutotunedSolver final
+		: public LinearSolver<MatrixType, Vector<double>>
+	{
+	public:
+		using VectorType = Vector<double>;
+		using InnerSolverType = LinearSolver<MatrixType, VectorType>;
+		using CandidateType = LinearSolverCandidate<MatrixType>;
+
+		AutotunedSolver(std::vector<CandidateType> aCandidates, std::string aProblemName = "",
+			std::string aDecisionPath = "") noexcept
+			: candidates(std::move(aCandidates))
+			, problemName(std::move(aProblemName))
+			, decisionPath(std::move(aDecisionPath))
+		{
+			AssertE(!candidates.empty(), MessageTag::LinearSolver, "Autotuned solver requires at least one candidate.");
+		}
+
+		// Empty until the candidate is selected.
+		[[nodiscard]] const std::string& GetSelectedName() const noexcept
+		{
+			return selectedName;
+		}
+
+		bool Solve(const MatrixType& matrix, const VectorType& y, VectorType& x) override
+		{
+			if (!solver)
+			{
+				return Select(matrix, y, x);
+			}
+			return solver->Solve(matrix, y, x);
+		}
+
+		bool SolveMultiple(const MatrixType& matrix, const VectorType& y, VectorType& x, size_t rhsCount) override
+		{
+			return EnsureSelected(matrix) && solver->SolveMultiple(matrix, y, x, rhsCount);
+		}
+
+		bool Factorize(const MatrixType& matrix) override
+		{
+			return EnsureSelected(matrix) && solver->Factorize(matrix);
+		}
+
+		bool SolveFactorized(const VectorType& y, VectorType& x) override
+		{
+			return solver->SolveFactorized(y, x);
+		}
+
+	private:
+		[[nodiscard]] std::string MakeKey(const MatrixType& matrix) const noexcept
+		{
+			return Format("{}:{}:{}", problemName, matrix.RowCount(), matrix.NonZeroCount());
+		}
+
+		[[nodiscard]] std::string LoadDecision(const std::string& key) const noexcept
+		{
+			auto stream = std::ifstream(decisionPath);
+			std::string line;
+			while (std::getline(stream, line))
+			{
+				const auto separator = line.find('\t');
+				if (separator != std::string::npos && line.compare(0, separator, key) == 0 && separator == key.size())
+				{
+					return line.substr(separator + 1);
+				}
+			}
+			return "";
+		}
+
+		// Rewrites the decision file replacing previous decision for the same key.
+		void SaveDecision(const std::string& key, const std::string& name) const noexcept
+		{
+			std::vector<std::string> lines;
+			{
+				auto stream = std::ifstream(decisionPath);
+				std::string line;
+				while (std::getline(stream, line))
+				{
+					if (line.compare(0, key.size() + 1, key + '\t') != 0)
+					{
+						lines.push_back(std::move(line));
+					}
+				}
+			}
+			lines.push_back(key + '\t' + name);
+			auto stream = std::ofstream(decisionPath, std::ios::trunc);
+			for (const auto& line : lines)
+			{
+				stream << line << '\n';
+			}
+			if (!stream)
+			{
+				Logger::Log(MessageType::Warning, MessagePriority::High, MessageTag::LinearSolver,
+					Format("Failed to save linear solver decision to {}.", decisionPath));
+			}
+		}
+
+		// Selection for calls without right hand side uses system with the solution of all ones.
+		bool EnsureSelected(const MatrixType& matrix)
+		{
+			if (solver)
+			{
+				return true;
+			}
+			const size_t size = matrix.RowCount();
+			const auto ones = VectorType(1., size);
+			auto y = VectorType(size);
+			MVMultiply(matrix, ones, y, 1., 0.);
+			auto x = VectorType(0., size);
+			return Select(matrix, y, x);
+		}
+
+		// Uses stored decision or runs trials, x receives the solution found by the selected candidate.
+		bool Select(const MatrixType& matrix, const VectorType& y, VectorType& x)
+		{
+			const auto key = MakeKey(matrix);
+			if (!decisionPath.empty())
+			{
+				const auto name = LoadDecision(key);
+				const auto it = std::find_if(candidates.begin(), candidates.end(),
+					[&](const auto& candidate) { return candidate.name == name; });
+				if (it != candidates.end())
+				{
+					Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+						Format("Using stored linear solver decision {} for {}.", name, key));
+					solver = it->create();
+					selectedName = name;
+					return solver->Solve(matrix, y, x);
+				}
+			}
+			if (!RunTrials(matrix, y, x))
+			{
+				Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::LinearSolver,
+					Format("No linear solver candidate succeeded for {}.", key));
+				return false;
+			}
+			if (!decisionPath.empty())
+			{
+				SaveDecision(key, selectedName);
+			}
+			return true;
+		}
+
+		bool RunTrials(const MatrixType& matrix, const VectorType& y, VectorType& x)
+		{
+			const size_t size = y.size();
+			const double rhsNorm = LinearAlgebra::Norm2(y.data(), size);
+			auto trial = VectorType(size);
+			auto residual = VectorType(size);
+			auto bestSolution = VectorType(size);
+			double bestTime = std::numeric_limits<double>::infinity();
+			std::chrono::high_resolution_clock clock;
+			for (const auto& candidate : candidates)
+			{
+				auto candidateSolver = candidate.create();
+				bool isSuccessful = true;
+				double time = 0;
+				for (size_t trialIndex = 0; trialIndex < trialSolveCount && isSuccessful; ++trialIndex)
+				{
+					LinearAlgebra::Copy(x.data(), trial.data(), size);
+					const auto startTime = clock.now();
+					isSuccessful = candidateSolver->Solve(matrix, y, trial);
+					time = std::chrono::duration<double>(clock.now() - startTime).count();
+				}
+				double relativeResidual = std::numeric_limits<double>::infinity();
+				if (isSuccessful)
+				{
+					LinearAlgebra::Copy(y.data(), residual.data(), size);
+					MVMultiply(matrix, trial, residual, -1., 1.);
+					relativeResidual = LinearAlgebra::Norm2(residual.data(), size) / (rhsNorm > 0 ? rhsNorm : 1.);
+					isSuccessful = relativeResidual <= residualTolerance;
+				}
+				Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+					isSuccessful
+						? Format("Linear solver candidate {} solved the system in {} s with relative residual {}.",
+							candidate.name, time, relativeResidual)
+						: Format("Linear solver candidate {} is rejected.", candidate.name));
+				// Only the best candidate is kept alive to limit memory taken by factors.
+				if (isSuccessful && time < bestTime)
+				{
+					bestTime = time;
+					solver = std::move(candidateSolver);
+					selectedName = candidate.name;
+					LinearAlgebra::Copy(trial.data(), bestSolution.data(), size);
+				}
+			}
+			if (!solver)
+			{
+				return false;
+			}
+			LinearAlgebra::Copy(bestSolution.data(), x.data(), size);
+			Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::LinearSolver,
+				Format("Linear solver {} is selected.", selectedName));
+			return true;
+		}
+
+		std::vector<CandidateType> candidates;
+		std::string problemName;
+		std::string decisionPath;
+
+		uptr<InnerSolverType> solver;
+		std::string selectedName;
+
+		// Solves per candidate, the last one is timed.
+		MakeProperty(trialSolveCount, TrialSolveCount, size_t, 2)
+		MakeProperty(residualTolerance, ResidualTolerance, double, 1e-6)
+	};
+
+	// Default candidates: PARDISO with different orderings, two-level factorization and without CGS, FGMRES with ILU0
+	// and ILUT preconditioners in MKL build; sparse LU with different orderings and FGMRES with ILU(k) otherwise.
+	template<Concepts::CSRMatrix MatrixType>
+	[[nodiscard]] std::vector<LinearSolverCandidate<MatrixType>> MakeDefaultLinearSolverCandidates() noexcept
+	{
+		std::vector<LinearSolverCandidate<MatrixType>> candidates;
+#if MathLibrary == MKLMath
+		if constexpr (std::is_same_v<MatrixType, CSRMatrix<double>>)
+		{
+			using PARDISOType = MKL::PARDISO<double>;
+			candidates.push_back({ "PARDISO parallel nested dissection", []()
+				{
+					return std::make_unique<PARDISOType>();
+				} });
+			candidates.push_back({ "PARDISO minimum degree", []()
+				{
+					auto solver = std::make_unique<PARDISOType>();
+					solver->SetFillInReductionMethod(PARDISOType::FillInReductionMethod::MinimumDegree);
+					return solver;
+				} });
+			candidates.push_back({ "PARDISO without CGS", []()
+				{
+					auto solver = std::make_unique<PARDISOType>();
+					solver->SetUseCGS(false);
+					return solver;
+				} });
+			candidates.push_back({ "PARDISO two-level", []()
+				{
+					auto solver = std::make_unique<PARDISOType>();
+					solver->SetUseDiagonalElementScaling(false);
+					solver->SetUseWeightedMatching(false);
+					solver->SetFactorizationMethod(PARDISOType::FactorizationMethod::ImprovedTwoLevel);
+					return solver;
+				} });
+			candidates.push_back({ "FGMRES+ILU0", []()
+				{
+					return std::make_unique<MKL::FGMRES<MatrixType>>(std::make_unique<MKL::ILU0>());
+				} });
+			candidates.push_back({ "FGMRES+ILUT", []()
+				{
+					return std::make_unique<MKL::FGMRES<MatrixType>>(std::make_unique<MKL::ILUT>());
+				} });
+			return candidates;
+		}
+#endif
+		candidates.push_back({ "SparseLU reverse Cuthill-McKee", []()
+			{
+				return std::make_unique<Native::SparseLU<MatrixType>>(Native::SparseLUOrdering::ReverseCuthillMcKee);
+			} });
+		candidates.push_back({ "SparseLU natural", []()
+			{
+				return std::make_unique<Native::SparseLU<MatrixType>>(Native::SparseLUOrdering::Natural);
+			} });
+		candidates.push_back({ "FGMRES+ILU(0)", []()
+			{
+				return std::make_unique<Native::FGMRES<MatrixType>>(std::make_unique<Native::ILUK<MatrixType>>(0));
+			} });
+		candidates.push_back({ "FGMRES+ILU(1)", []()
+			{
+				return std::make_unique<Native::FGMRES<MatrixType>>(std::make_unique<Native::ILUK<MatrixType>>(1));
+			} });
+		return candidates;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,418 @@
+#pragma once
+
+#include "Math/CSRMatrixOperations.h"
+#include "Math/LinearAlgebra.h"
+#include "Math/LinearSolver.h"
+#include "Math/PointMajorSolver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace CESDSOL
+{
+	// Direct solver for banded matrices with a dense border: the leading block of size RowCount - borderSize is
+	// banded, the last borderSize rows and columns (usually discrete variables) may be arbitrary. Bandwidths are
+	// detected from the pattern. The banded block is factorized by banded LU with partial pivoting in LAPACK band
+	// storage (dgbtrf/dgbtrs with MKL), the border is eliminated through dense Schur complement. For one-dimensional
+	// problems this costs O(n kl (kl + ku)) with very small constant, much less than general sparse factorization.
+	template<Concepts::CSRMatrix MatrixType>
+	class BandedSolver final
+		: public LinearSolver<MatrixType, Vector<double>>
+	{
+	public:
+		using VectorType = Vector<double>;
+
+		BandedSolver(size_t aBorderSize = 0) noexcept
+			: borderSize(aBorderSize)
+		{}
+
+		[[nodiscard]] size_t GetLowerBandwidth() const noexcept
+		{
+			return lowerBandwidth;
+		}
+
+		[[nodiscard]] size_t GetUpperBandwidth() const noexcept
+		{
+			return upperBandwidth;
+		}
+
+		bool Solve(const MatrixType& matrix, const VectorType& y, VectorType& x) override
+		{
+			return SolveMultiple(matrix, y, x, 1);
+		}
+
+		// Banded substitutions are done for all right hand sides in one call.
+		bool SolveMultiple(const MatrixType& matrix, const VectorType& y, VectorType& x, size_t rhsCount) override
+		{
+			Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+				Format("Starting solving system of {} linear equations with {} right hand sides with banded solver.",
+					matrix.RowCount(), rhsCount));
+			std::chrono::high_resolution_clock clock;
+			const auto solutionStartTime = clock.now();
+			if (!Factorize(matrix))
+			{
+				return false;
+			}
+			Substitute(y, x, rhsCount);
+			Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+				Format("Linear system is solved by banded solver in {}", clock.now() - solutionStartTime));
+			return true;
+		}
+
+		bool Factorize(const MatrixType& matrix) override
+		{
+			AssertE(matrix.RowCount() == matrix.ColumnCount() && matrix.RowCount() >= borderSize, MessageTag::LinearSolver,
+				"Matrix size is incompatible with banded solver.");
+			const auto hash = ComputePatternHash(matrix);
+			if (!isPatternActual || hash != patternHash)
+			{
+				Analyze(matrix);
+				patternHash = hash;
+				isPatternActual = true;
+			}
+			return FactorizeBlocks(matrix);
+		}
+
+		bool SolveFactorized(const VectorType& y, VectorType& x) override
+		{
+			Substitute(y, x, 1);
+			return true;
+		}
+
+	private:
+		void Analyze(const MatrixType& matrix) noexcept
+		{
+			bandSize = matrix.RowCount() - borderSize;
+			lowerBandwidth = 0;
+			upperBandwidth = 0;
+			for (size_t row = 0; row < bandSize; ++row)
+			{
+				for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+				{
+					const size_t column = matrix.GetColumnIndex(k);
+					if (column < bandSize)
+					{
+						lowerBandwidth = std::max(lowerBandwidth, row > column ? row - column : 0);
+						upperBandwidth = std::max(upperBandwidth, column > row ? column - row : 0);
+					}
+				}
+			}
+			// Pivoting fills lowerBandwidth additional superdiagonals.
+			bandLeadingDimension = 2 * lowerBandwidth + upperBandwidth + 1;
+			band = Array<double>(bandLeadingDimension * bandSize);
+			pivots = Array<PivotType>(bandSize);
+			upperBorder = Array<double>(bandSize * borderSize);
+			lowerBorder = Array<double>(borderSize * bandSize);
+			schurComplement = Array<double>(borderSize * borderSize);
+			schurPivots = Array<PivotType>(borderSize);
+			Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+				Format("Banded solver detected {} subdiagonals and {} superdiagonals with border of size {}.",
+					lowerBandwidth, upperBandwidth, borderSize));
+		}
+
+		// Element (i, j) of the banded block in column-major band storage.
+		[[nodiscard]] double& BandElement(size_t i, size_t j) noexcept
+		{
+			return band[lowerBandwidth + upperBandwidth + i - j + j * bandLeadingDimension];
+		}
+
+		bool FactorizeBlocks(const MatrixType& matrix) noexcept
+		{
+			const size_t n = bandSize;
+			const size_t m = borderSize;
+			std::fill(band.begin(), band.end(), 0.);
+			std::fill(upperBorder.begin(), upperBorder.end(), 0.);
+			std::fill(lowerBorder.begin(), lowerBorder.end(), 0.);
+			std::fill(schurComplement.begin(), schurComplement.end(), 0.);
+			for (size_t row = 0; row < n + m; ++row)
+			{
+				for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+				{
+					const size_t column = matrix.GetColumnIndex(k);
+					const double value = matrix.GetValue(k);
+					if (row < n && column < n)
+					{
+						BandElement(row, column) += value;
+					}
+					else if (row < n)
+					{
+						upperBorder[(column - n) * n + row] += value;
+					}
+					else if (column < n)
+					{
+						lowerBorder[(row - n) * n + column] += value;
+					}
+					else
+					{
+						schurComplement[(row - n) * m + column - n] += value;
+					}
+				}
+			}
+
+			if (!FactorizeBanded())
+			{
+				Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::LinearSolver,
+					"Banded solver failed: the banded block of the matrix is singular.");
+				return false;
+			}
+			if (m == 0)
+			{
+				return true;
+			}
+			// Z = B^-1 C is kept in place of C, S = E - D Z.
+			SolveBanded(upperBorder.data(), m, n);
+			ParallelFor(0, m, [&](int64_t i)
+				{
+					for (size_t j = 0; j < m; ++j)
+					{
+						schurComplement[i * m + j] -= LinearAlgebra::DotProduct(lowerBorder.data() + i * n, upperBorder.data() + j * n, n);
+					}
+				});
+			if (!FactorizeDense())
+			{
+				Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::LinearSolver,
+					"Banded solver failed: Schur complement of the border is singular.");
+				return false;
+			}
+			return true;
+		}
+
+		void Substitute(const VectorType& y, VectorType& x, size_t rhsCount) noexcept
+		{
+			const size_t n = bandSize;
+			const size_t m = borderSize;
+			std::copy(y.begin(), y.begin() + (n + m) * rhsCount, x.begin());
+			SolveBanded(x.data(), rhsCount, n + m);
+			if (m == 0)
+			{
+				return;
+			}
+			// x2 = S^-1 (y2 - D u), x1 = u - Z x2.
+			for (size_t r = 0; r < rhsCount; ++r)
+			{
+				auto* solution = x.data() + r * (n + m);
+				auto* border = solution + n;
+				for (size_t i = 0; i < m; ++i)
+				{
+					border[i] -= LinearAlgebra::DotProduct(lowerBorder.data() + i * n, solution, n);
+				}
+				SolveDense(border);
+				for (size_t j = 0; j < m; ++j)
+				{
+					LinearAlgebra::AXPY(-border[j], upperBorder.data() + j * n, solution, n);
+				}
+			}
+		}
+
+#if MathLibrary == MKLMath
+		using PivotType = MKL_INT;
+
+		bool FactorizeBanded() noexcept
+		{
+			const auto n = static_cast<MKL_INT>(bandSize);
+			return LAPACKE_dgbtrf(LAPACK_COL_MAJOR, n, n, static_cast<MKL_INT>(lowerBandwidth), static_cast<MKL_INT>(upperBandwidth),
+				band.data(), static_cast<MKL_INT>(bandLeadingDimension), pivots.data()) == 0;
+		}
+
+		// Solves with factorized banded block for rhsCount right hand sides located stride elements apart.
+		void SolveBanded(double* rhs, size_t rhsCount, size_t stride) noexcept
+		{
+			const auto n = static_cast<MKL_INT>(bandSize);
+			LAPACKE_dgbtrs(LAPACK_COL_MAJOR, 'N', n, static_cast<MKL_INT>(lowerBandwidth), static_cast<MKL_INT>(upperBandwidth),
+				static_cast<MKL_INT>(rhsCount), band.data(), static_cast<MKL_INT>(bandLeadingDimension), pivots.data(), rhs,
+				static_cast<MKL_INT>(stride));
+		}
+
+		bool FactorizeDense() noexcept
+		{
+			const auto m = static_cast<MKL_INT>(borderSize);
+			return LAPACKE_dgetrf(LAPACK_ROW_MAJOR, m, m, schurComplement.data(), m, schurPivots.data()) == 0;
+		}
+
+		void SolveDense(double* rhs) noexcept
+		{
+			const auto m = static_cast<MKL_INT>(borderSize);
+			LAPACKE_dgetrs(LAPACK_ROW_MAJOR, 'N', m, 1, schurComplement.data(), m, schurPivots.data(), rhs, 1);
+		}
+#else
+		using PivotType = size_t;
+
+		// Unblocked banded LU with partial pivoting following LAPACK dgbtf2.
+		bool FactorizeBanded() noexcept
+		{
+			const size_t n = bandSize;
+			size_t lastColumn = 0;
+			for (size_t j = 0; j < n; ++j)
+			{
+				const size_t subdiagonalCount = std::min(lowerBandwidth, n - 1 - j);
+				size_t pivot = 0;
+				for (size_t i = 1; i <= subdiagonalCount; ++i)
+				{
+					if (std::abs(BandElement(j + i, j)) > std::abs(BandElement(j + pivot, j)))
+					{
+						pivot = i;
+					}
+				}
+				pivots[j] = j + pivot;
+				const double pivotValue = BandElement(j + pivot, j);
+				if (pivotValue == 0.)
+				{
+					return false;
+				}
+				lastColumn = std::max(lastColumn, std::min(j + upperBandwidth + pivot, n - 1));
+				if (pivot != 0)
+				{
+					for (size_t column = j; column <= lastColumn; ++column)
+					{
+						std::swap(BandElement(j, column), BandElement(j + pivot, column));
+					}
+				}
+				for (size_t i = 1; i <= subdiagonalCount; ++i)
+				{
+					BandElement(j + i, j) /= pivotValue;
+				}
+				for (size_t column = j + 1; column <= lastColumn; ++column)
+				{
+					const double factor = BandElement(j, column);
+					if (factor != 0.)
+					{
+						for (size_t i = 1; i <= subdiagonalCount; ++i)
+						{
+							BandElement(j + i, column) -= BandElement(j + i, j) * factor;
+						}
+					}
+				}
+			}
+			return true;
+		}
+
+		// Solves with factorized banded block for rhsCount right hand sides located stride elements apart.
+		void SolveBanded(double* rhs, size_t rhsCount, size_t stride) noexcept
+		{
+			const size_t n = bandSize;
+			const size_t upperCount = lowerBandwidth + upperBandwidth;
+			ParallelFor(0, rhsCount, [&](int64_t r)
+				{
+					double* b = rhs + r * stride;
+					for (size_t j = 0; j < n; ++j)
+					{
+						if (pivots[j] != j)
+						{
+							std::swap(b[j], b[pivots[j]]);
+						}
+						const size_t subdiagonalCount = std::min(lowerBandwidth, n - 1 - j);
+						for (size_t i = 1; i <= subdiagonalCount; ++i)
+						{
+							b[j + i] -= BandElement(j + i, j) * b[j];
+						}
+					}
+					for (size_t j = n; j-- > 0;)
+					{
+						b[j] /= BandElement(j, j);
+						for (size_t i = j > upperCount ? j - upperCount : 0; i < j; ++i)
+						{
+							b[i] -= BandElement(i, j) * b[j];
+						}
+					}
+				});
+		}
+
+		bool FactorizeDense() noexcept
+		{
+			const size_t m = borderSize;
+			auto* a = schurComplement.data();
+			for (size_t j = 0; j < m; ++j)
+			{
+				size_t pivot = j;
+				for (size_t i = j + 1; i < m; ++i)
+				{
+					if (std::abs(a[i * m + j]) > std::abs(a[pivot * m + j]))
+					{
+						pivot = i;
+					}
+				}
+				schurPivots[j] = pivot;
+				if (a[pivot * m + j] == 0.)
+				{
+					return false;
+				}
+				if (pivot != j)
+				{
+					std::swap_ranges(a + j * m, a + (j + 1) * m, a + pivot * m);
+				}
+				for (size_t i = j + 1; i < m; ++i)
+				{
+					a[i * m + j] /= a[j * m + j];
+					for (size_t k = j + 1; k < m; ++k)
+					{
+						a[i * m + k] -= a[i * m + j] * a[j * m + k];
+					}
+				}
+			}
+			return true;
+		}
+
+		void SolveDense(double* rhs) noexcept
+		{
+			const size_t m = borderSize;
+			const auto* a = schurComplement.data();
+			for (size_t j = 0; j < m; ++j)
+			{
+				std::swap(rhs[j], rhs[schurPivots[j]]);
+			}
+			for (size_t j = 0; j < m; ++j)
+			{
+				for (size_t i = j + 1; i < m; ++i)
+				{
+					rhs[i] -= a[i * m + j] * rhs[j];
+				}
+			}
+			for (size_t j = m; j-- > 0;)
+			{
+				for (size_t k = j + 1; k < m; ++k)
+				{
+					rhs[j] -= a[j * m + k] * rhs[k];
+				}
+				rhs[j] /= a[j * m + j];
+			}
+		}
+#endif
+
+		size_t borderSize;
+		size_t bandSize = 0;
+		size_t lowerBandwidth = 0;
+		size_t upperBandwidth = 0;
+		size_t bandLeadingDimension = 0;
+		// Banded block and its LU factors in column-major band storage.
+		Array<double> band;
+		Array<PivotType> pivots;
+		// Border blocks: columns of C (replaced by B^-1 C after factorization) and rows of D.
+		Array<double> upperBorder;
+		Array<double> lowerBorder;
+		// Schur complement E - D B^-1 C and its dense LU factors.
+		Array<double> schurComplement;
+		Array<PivotType> schurPivots;
+
+		uint64_t patternHash = 0;
+		bool isPatternActual = false;
+	};
+
+	// Creates banded solver for the Jacobian of one-dimensional stationary problem with discrete variables as border.
+	// Multi-field problems are solved in point-major ordering, where the Jacobian is banded with bandwidth about
+	// field count times stencil half-size.
+	template<typename ProblemType>
+	[[nodiscard]] uptr<LinearSolver<typename ProblemType::JacobianMatrixType, Vector<double>>> MakeBandedSolver(
+		const ProblemType& problem) noexcept
+	{
+		using MatrixType = typename ProblemType::JacobianMatrixType;
+
+		const auto& descriptor = problem.GetDescriptor();
+		auto solver = std::make_unique<BandedSolver<MatrixType>>(descriptor.DiscreteEquationCount());
+		if (descriptor.ContinuousEquationCount() <= 1)
+		{
+			return solver;
+		}
+		return MakePointMajorSolver<MatrixType>(problem, uptr<LinearSolver<MatrixType, Vector<double>>>(std::move(solver)));
+	}
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Math/Concepts.h"
 #include "Math/LinearAlgebra.h"
 
 namespace CESDSOL
@@ -17,6 +18,29 @@ namespace CESDSOL
 		return result;
 	}
 
+	// FNV-1a hash of matrix sizes and sparsity pattern, used to detect that only values of a matrix have changed.
+	template<Concepts::CSRMatrix MatrixType>
+	[[nodiscard]] uint64_t ComputePatternHash(const MatrixType& matrix) noexcept
+	{
+		uint64_t hash = 14695981039346656037ull;
+		const auto combine = [&hash](uint64_t value)
+		{
+			hash ^= value;
+			hash *= 1099511628211ull;
+		};
+		combine(matrix.RowCount());
+		combine(matrix.ColumnCount());
+		for (size_t i = 0; i <= matrix.RowCount(); ++i)
+		{
+			combine(matrix.GetRowCount(i));
+		}
+		for (size_t i = 0; i < matrix.NonZeroCount(); ++i)
+		{
+			combine(matrix.GetColumnIndex(i));
+		}
+		return hash;
+	}
+
 	template<Concepts::CSRMatrix MatrixType>
 	std::ostream& operator<<(std::ostream& stream, const MatrixType& matrix) noexcept
 	{
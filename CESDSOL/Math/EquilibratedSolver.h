@@ -0,0 +1,257 @@
+#pragma once
+
+#include "Math/CSRMatrixOperations.h"
+#include "Math/LinearAlgebra.h"
+#include "Math/LinearSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+namespace CESDSOL
+{
+	enum class EquilibrationMethod
+	{
+		// Rows are scaled by their max norms, then columns of the scaled matrix by theirs (as LAPACK dgeequ).
+		MaxNorm,
+		// Rows and columns are scaled simultaneously by square roots of their max norms until all of them are close
+		// to one (D. Ruiz, A scaling algorithm to equilibrate both rows and columns norms in matrices, 2001).
+		Ruiz
+	};
+
+	// Linear solver which solves row and column equilibrated system (R A C) (C^-1 x) = R y with the inner solver.
+	// Systems coupling fields of very different magnitudes become much better conditioned, which improves pivoting
+	// of direct solvers and convergence of Krylov ones. Scales are rounded to powers of two, so scaling itself
+	// introduces no rounding errors. Optionally all rows (and columns) of one field share one scale, which keeps
+	// relative sizes of equations at different points, and scales can be kept while the pattern of the matrix is
+	// unchanged, e.g. during Newton iterations.
+	template<Concepts::CSRMatrix MatrixType>
+	class EquilibratedSolver final
+		: public LinearSolver<MatrixType, Vector<double>>
+	{
+	public:
+		using VectorType = Vector<double>;
+		using InnerSolverType = LinearSolver<MatrixType, VectorType>;
+
+		EquilibratedSolver(uptr<InnerSolverType> aSolver, EquilibrationMethod aMethod = EquilibrationMethod::Ruiz) noexcept
+			: solver(std::move(aSolver))
+			, method(aMethod)
+		{}
+
+		// Makes rows and columns of every continuous field share one scale, discrete unknowns are scaled separately.
+		void SetFieldBlocks(size_t aFieldCount, size_t aPointCount) noexcept
+		{
+			fieldCount = aFieldCount;
+			pointCount = aPointCount;
+			rowScales = VectorType();
+		}
+
+		[[nodiscard]] const VectorType& GetRowScales() const noexcept
+		{
+			return rowScales;
+		}
+
+		[[nodiscard]] const VectorType& GetColumnScales() const noexcept
+		{
+			return columnScales;
+		}
+
+		bool Solve(const MatrixType& matrix, const VectorType& y, VectorType& x) override
+		{
+			UpdateMatrix(matrix);
+			ScaleVectors(y, x, 1);
+			const bool result = solver->Solve(*scaledMatrix, rhs, solution);
+			UnscaleSolution(x, 1);
+			return result;
+		}
+
+		bool SolveMultiple(const MatrixType& matrix, const VectorType& y, VectorType& x, size_t rhsCount) override
+		{
+			UpdateMatrix(matrix);
+			ScaleVectors(y, x, rhsCount);
+			const bool result = solver->SolveMultiple(*scaledMatrix, rhs, solution, rhsCount);
+			UnscaleSolution(x, rhsCount);
+			return result;
+		}
+
+		bool Factorize(const MatrixType& matrix) override
+		{
+			UpdateMatrix(matrix);
+			return solver->Factorize(*scaledMatrix);
+		}
+
+		bool SolveFactorized(const VectorType& y, VectorType& x) override
+		{
+			ScaleVectors(y, x, 1);
+			const bool result = solver->SolveFactorized(rhs, solution);
+			UnscaleSolution(x, 1);
+			return result;
+		}
+
+	private:
+		// Index of the group sharing one scale.
+		[[nodiscard]] size_t GetGroup(size_t index) const noexcept
+		{
+			const size_t continuousCount = fieldCount * pointCount;
+			return index < continuousCount ? index / pointCount : fieldCount + index - continuousCount;
+		}
+
+		[[nodiscard]] static double RoundToPowerOfTwo(double value) noexcept
+		{
+			return value > 0 && std::isfinite(value) ? std::exp2(std::round(std::log2(value))) : 1.;
+		}
+
+		// Computes max norms of rows and columns of R A C grouped by GetGroup.
+		void ComputeGroupNorms(const MatrixType& matrix, Array<double>& rowNorms, Array<double>& columnNorms) const noexcept
+		{
+			std::fill(rowNorms.begin(), rowNorms.end(), 0.);
+			std::fill(columnNorms.begin(), columnNorms.end(), 0.);
+			for (size_t row = 0; row < matrix.RowCount(); ++row)
+			{
+				auto& rowNorm = rowNorms[GetGroup(row)];
+				for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+				{
+					const size_t column = matrix.GetColumnIndex(k);
+					const double value = std::abs(rowScales[row] * matrix.GetValue(k) * columnScales[column]);
+					rowNorm = std::max(rowNorm, value);
+					auto& columnNorm = columnNorms[GetGroup(column)];
+					columnNorm = std::max(columnNorm, value);
+				}
+			}
+		}
+
+		// Multiplies scales of every group by its norm to the power -exponent rounded to power of two, returns false if
+		// no scale changes.
+		bool ApplyGroupFactors(VectorType& scales, Array<double>& norms, double exponent) noexcept
+		{
+			bool isChanged = false;
+			for (auto& norm : norms)
+			{
+				norm = RoundToPowerOfTwo(std::pow(norm, -exponent));
+				isChanged |= norm != 1.;
+			}
+			ParallelFor(0, scales.size(), [&](int64_t i)
+				{
+					scales[i] *= norms[GetGroup(i)];
+				});
+			return isChanged;
+		}
+
+		void ComputeScales(const MatrixType& matrix) noexcept
+		{
+			const size_t size = matrix.RowCount();
+			rowScales = VectorType(1., size);
+			columnScales = VectorType(1., size);
+			const size_t groupCount = fieldCount == 0 ? size : GetGroup(size - 1) + 1;
+			auto rowNorms = Array<double>(groupCount);
+			auto columnNorms = Array<double>(groupCount);
+			size_t iterationCount = 0;
+			if (method == EquilibrationMethod::MaxNorm)
+			{
+				ComputeGroupNorms(matrix, rowNorms, columnNorms);
+				ApplyGroupFactors(rowScales, rowNorms, 1.);
+				ComputeGroupNorms(matrix, rowNorms, columnNorms);
+				ApplyGroupFactors(columnScales, columnNorms, 1.);
+				iterationCount = 1;
+			}
+			else
+			{
+				// Rounded scales stop changing once all norms are within factor of two from one.
+				while (iterationCount < ruizIterationLimit)
+				{
+					ComputeGroupNorms(matrix, rowNorms, columnNorms);
+					const bool isRowChanged = ApplyGroupFactors(rowScales, rowNorms, 0.5);
+					const bool isColumnChanged = ApplyGroupFactors(columnScales, columnNorms, 0.5);
+					if (!isRowChanged && !isColumnChanged)
+					{
+						break;
+					}
+					++iterationCount;
+				}
+			}
+			Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+				Format("Equilibration scales computed in {} iterations.", iterationCount));
+		}
+
+		// Scales the matrix, scales are recomputed unless they are reused for unchanged pattern.
+		void UpdateMatrix(const MatrixType& matrix) noexcept
+		{
+			AssertE(matrix.RowCount() == matrix.ColumnCount() && matrix.RowCount() >= fieldCount * pointCount,
+				MessageTag::LinearSolver, "Matrix size is incompatible with equilibration.");
+			const auto hash = ComputePatternHash(matrix);
+			const bool isPatternChanged = !scaledMatrix || hash != patternHash;
+			if (isPatternChanged)
+			{
+				scaledMatrix.reset();
+				scaledMatrix.emplace(matrix.RowCount(), matrix.ColumnCount(), matrix.NonZeroCount());
+				for (size_t row = 0; row < matrix.RowCount(); ++row)
+				{
+					scaledMatrix->SetRowCount(row, matrix.GetRowCount(row));
+				}
+				ParallelFor(0, matrix.NonZeroCount(), [&](int64_t k)
+					{
+						scaledMatrix->SetColumnIndex(k, matrix.GetColumnIndex(k));
+					});
+				patternHash = hash;
+			}
+			if (isPatternChanged || !reuseScales || rowScales.size() != matrix.RowCount())
+			{
+				ComputeScales(matrix);
+			}
+			ParallelFor(0, matrix.RowCount(), [&](int64_t row)
+				{
+					for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+					{
+						scaledMatrix->SetValue(k, rowScales[row] * matrix.GetValue(k) * columnScales[matrix.GetColumnIndex(k)]);
+					}
+				});
+		}
+
+		void ScaleVectors(const VectorType& y, const VectorType& x, size_t rhsCount) noexcept
+		{
+			const size_t size = rowScales.size();
+			if (rhs.size() != size * rhsCount)
+			{
+				rhs = VectorType(size * rhsCount);
+				solution = VectorType(size * rhsCount);
+			}
+			ParallelFor(0, size, [&](int64_t i)
+				{
+					for (size_t r = 0; r < rhsCount; ++r)
+					{
+						rhs[r * size + i] = rowScales[i] * y[r * size + i];
+						solution[r * size + i] = x[r * size + i] / columnScales[i];
+					}
+				});
+		}
+
+		void UnscaleSolution(VectorType& x, size_t rhsCount) const noexcept
+		{
+			const size_t size = columnScales.size();
+			ParallelFor(0, size, [&](int64_t i)
+				{
+					for (size_t r = 0; r < rhsCount; ++r)
+					{
+						x[r * size + i] = columnScales[i] * solution[r * size + i];
+					}
+				});
+		}
+
+		uptr<InnerSolverType> solver;
+		EquilibrationMethod method;
+		size_t fieldCount = 0;
+		size_t pointCount = 0;
+
+		VectorType rowScales;
+		VectorType columnScales;
+		// Kept in optional since MKL matrices release their handles only on destruction.
+		std::optional<MatrixType> scaledMatrix;
+		uint64_t patternHash = 0;
+		VectorType rhs;
+		VectorType solution;
+
+		// Scales are kept while the pattern of the matrix is unchanged.
+		MakeProperty(reuseScales, ReuseScales, bool, false)
+		MakeProperty(ruizIterationLimit, RuizIterationLimit, size_t, 20)
+	};
+}
\ No newline at end of file
@@ -0,0 +1,443 @@
+#pragma once
+
+#include "Math/LinearAlgebra.h"
+#include "Math/Native/CSRMatrixOperations.h"
+#include "Math/Preconditioner.h"
+
+#include <limits>
+
+namespace CESDSOL
+{
+	enum class FieldSplitType
+	{
+		BlockJacobi,
+		BlockGaussSeidel,
+		SymmetricBlockGaussSeidel,
+		// Block LU with Schur complement of the second block approximated as A11 - A10 diag(A00)^-1 A01,
+		// requires exactly two blocks.
+		Schur
+	};
+
+	// Block preconditioner over a partition of unknowns into blocks (usually groups of fields). Diagonal blocks
+	// are extracted from the full matrix and solved by inner solvers given for every block, coupling between blocks
+	// is either dropped (block Jacobi) or taken into account by block Gauss-Seidel sweeps or Schur complement.
+	template<typename MatrixType>
+	class FieldSplitPreconditioner final
+		: public Preconditioner<MatrixType, Vector<double>>
+	{
+	public:
+		using VectorType = Vector<double>;
+		using InnerSolverType = LinearSolver<MatrixType, VectorType>;
+
+		FieldSplitPreconditioner(FieldSplitType aType = FieldSplitType::BlockGaussSeidel) noexcept
+			: type(aType)
+		{}
+
+		// Adds block formed by the given unknowns, blocks are processed in the order they are added.
+		void AddBlock(Array<size_t> indices, uptr<InnerSolverType> solver) noexcept
+		{
+			std::sort(indices.begin(), indices.end());
+			blocks.push_back({ std::move(indices), std::move(solver) });
+			blockOf = Array<size_t>();
+		}
+
+		[[nodiscard]] size_t BlockCount() const noexcept
+		{
+			return blocks.size();
+		}
+
+		bool Setup(const MatrixType& matrix, const VectorType& y) noexcept override
+		{
+			if (blocks.size() == 0 || (type == FieldSplitType::Schur && blocks.size() != 2))
+			{
+				Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+					"Invalid number of blocks in field split preconditioner.");
+				return false;
+			}
+			if (blockOf.size() != matrix.RowCount() && !MakePartition(matrix.RowCount()))
+			{
+				return false;
+			}
+
+			for (size_t i = 0; i < blocks.size(); ++i)
+			{
+				auto& block = blocks[i];
+				block.matrix = Native::ExtractSubmatrixCSR<MatrixType>(matrix, block.indices, MakeColumnMap(i), block.indices.size());
+				block.rhs = VectorType(block.indices.size());
+				block.solution = VectorType(block.indices.size());
+			}
+			if (type == FieldSplitType::Schur && !SetupSchurComplement(matrix))
+			{
+				return false;
+			}
+
+			// Preconditioners compute their factors in Setup, other inner solvers are factorized once here, so that
+			// every application of the preconditioner only reuses the factorization.
+			for (size_t i = 0; i < blocks.size(); ++i)
+			{
+				auto& block = blocks[i];
+				if (auto* preconditioner = dynamic_cast<Preconditioner<MatrixType, VectorType>*>(block.solver.get()))
+				{
+					block.isFactorized = false;
+					if (!preconditioner->Setup(block.matrix, block.rhs))
+					{
+						Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+							Format("Failed to setup inner solver of block {} in field split preconditioner.", i));
+						return false;
+					}
+				}
+				else
+				{
+					block.isFactorized = block.solver->Factorize(block.matrix);
+					if (!block.isFactorized)
+					{
+						Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+							Format("Failed to factorize inner solver of block {} in field split preconditioner.", i));
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		bool Solve(const MatrixType& matrix, const VectorType& y, VectorType& x) override
+		{
+			std::fill(x.begin(), x.end(), 0.);
+			switch (type)
+			{
+			case FieldSplitType::BlockJacobi:
+				for (size_t i = 0; i < blocks.size(); ++i)
+				{
+					Gather(blocks[i], y);
+					if (!SolveBlock(i, x))
+					{
+						return false;
+					}
+				}
+				return true;
+			case FieldSplitType::BlockGaussSeidel:
+				for (size_t i = 0; i < blocks.size(); ++i)
+				{
+					if (!UpdateBlock(matrix, i, y, x))
+					{
+						return false;
+					}
+				}
+				return true;
+			case FieldSplitType::SymmetricBlockGaussSeidel:
+				for (size_t i = 0; i < blocks.size(); ++i)
+				{
+					if (!UpdateBlock(matrix, i, y, x))
+					{
+						return false;
+					}
+				}
+				for (size_t i = blocks.size() - 1; i-- > 0;)
+				{
+					if (!UpdateBlock(matrix, i, y, x))
+					{
+						return false;
+					}
+				}
+				return true;
+			case FieldSplitType::Schur:
+				return ApplySchur(y, x);
+			}
+			return false;
+		}
+
+	private:
+		using CouplingMatrixType = Native::CSRMatrix<double, size_t, 0>;
+
+		struct Block
+		{
+			Array<size_t> indices;
+			uptr<InnerSolverType> solver;
+			MatrixType matrix;
+			VectorType rhs;
+			VectorType solution;
+			bool isFactorized = false;
+		};
+
+		bool MakePartition(size_t size) noexcept
+		{
+			blockOf = Array<size_t>(std::numeric_limits<size_t>::max(), size);
+			localIndices = Array<size_t>(size);
+			for (size_t i = 0; i < blocks.size(); ++i)
+			{
+				const auto& indices = blocks[i].indices;
+				for (size_t k = 0; k < indices.size(); ++k)
+				{
+					if (indices[k] >= size || blockOf[indices[k]] != std::numeric_limits<size_t>::max())
+					{
+						Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+							"Blocks of field split preconditioner overlap or exceed matrix size.");
+						blockOf = Array<size_t>();
+						return false;
+					}
+					blockOf[indices[k]] = i;
+					localIndices[indices[k]] = k;
+				}
+			}
+			for (size_t i = 0; i < size; ++i)
+			{
+				if (blockOf[i] == std::numeric_limits<size_t>::max())
+				{
+					Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+						"Blocks of field split preconditioner do not cover all unknowns.");
+					blockOf = Array<size_t>();
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Returns map of unknowns to local indices of the given block, unknowns of other blocks are mapped past the end.
+		[[nodiscard]] Array<size_t> MakeColumnMap(size_t blockIndex) const noexcept
+		{
+			auto result = Array<size_t>(localIndices.size());
+			ParallelFor(0, localIndices.size(), [&](int64_t i)
+				{
+					result[i] = blockOf[i] == blockIndex ? localIndices[i] : std::numeric_limits<size_t>::max();
+				});
+			return result;
+		}
+
+		bool SetupSchurComplement(const MatrixType& matrix) noexcept
+		{
+			const auto& first = blocks[0];
+			const auto& second = blocks[1];
+			const auto firstColumns = MakeColumnMap(0);
+			const auto secondColumns = MakeColumnMap(1);
+			upperCoupling = Native::ExtractSubmatrixCSR<CouplingMatrixType>(matrix, first.indices, secondColumns,
+				second.indices.size());
+			lowerCoupling = Native::ExtractSubmatrixCSR<CouplingMatrixType>(matrix, second.indices, firstColumns,
+				first.indices.size());
+
+			auto scaledLowerCoupling = lowerCoupling;
+			for (size_t k = 0; k < scaledLowerCoupling.NonZeroCount(); ++k)
+			{
+				const size_t column = scaledLowerCoupling.GetColumnIndex(k);
+				double diagonal = 0;
+				for (size_t l = first.matrix.GetRowCount(column); l < first.matrix.GetRowCount(column + 1); ++l)
+				{
+					if (static_cast<size_t>(first.matrix.GetColumnIndex(l)) == column)
+					{
+						diagonal = first.matrix.GetValue(l);
+						break;
+					}
+				}
+				if (diagonal == 0)
+				{
+					Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+						"Zero diagonal entry in the first block of Schur complement preconditioner.");
+					return false;
+				}
+				scaledLowerCoupling.SetValue(k, scaledLowerCoupling.GetValue(k) / diagonal);
+			}
+
+			const auto product = Native::MultiplyCSR<CouplingMatrixType>(scaledLowerCoupling, upperCoupling);
+			blocks[1].matrix = Native::AddCSR<MatrixType>(blocks[1].matrix, product, -1.);
+			couplingBuffer = VectorType(std::max(first.indices.size(), second.indices.size()));
+			return true;
+		}
+
+		void Gather(Block& block, const VectorType& y) noexcept
+		{
+			ParallelFor(0, block.indices.size(), [&](int64_t k)
+				{
+					block.rhs[k] = y[block.indices[k]];
+				});
+		}
+
+		bool SolveBlock(size_t blockIndex, VectorType& x)
+		{
+			auto& block = blocks[blockIndex];
+			std::fill(block.solution.begin(), block.solution.end(), 0.);
+			const bool isSolved = block.isFactorized
+				? block.solver->SolveFactorized(block.rhs, block.solution)
+				: block.solver->Solve(block.matrix, block.rhs, block.solution);
+			if (!isSolved)
+			{
+				Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+					Format("Inner solver of block {} failed in field split preconditioner.", blockIndex));
+				return false;
+			}
+			ParallelFor(0, block.indices.size(), [&](int64_t k)
+				{
+					x[block.indices[k]] = block.solution[k];
+				});
+			return true;
+		}
+
+		// Solves block equations with unknowns of other blocks fixed at their current values.
+		bool UpdateBlock(const MatrixType& matrix, size_t blockIndex, const VectorType& y, VectorType& x)
+		{
+			auto& block = blocks[blockIndex];
+			ParallelFor(0, block.indices.size(), [&](int64_t k)
+				{
+					const size_t row = block.indices[k];
+					double value = y[row];
+					for (size_t l = matrix.GetRowCount(row); l < matrix.GetRowCount(row + 1); ++l)
+					{
+						const size_t column = matrix.GetColumnIndex(l);
+						if (blockOf[column] != blockIndex)
+						{
+							value -= matrix.GetValue(l) * x[column];
+						}
+					}
+					block.rhs[k] = value;
+				});
+			return SolveBlock(blockIndex, x);
+		}
+
+		// Applies inverse of [A00 A01; A10 S] lower-upper factorization: x1 = S^-1 (y1 - A10 A00^-1 y0),
+		// x0 = A00^-1 (y0 - A01 x1).
+		bool ApplySchur(const VectorType& y, VectorType& x)
+		{
+			auto& first = blocks[0];
+			auto& second = blocks[1];
+			Gather(first, y);
+			if (!SolveBlock(0, x))
+			{
+				return false;
+			}
+
+			Gather(second, y);
+			Native::CSRMVMultiply(lowerCoupling.GetRowCounts().data(), lowerCoupling.GetColumnIndices().data(),
+				lowerCoupling.GetValues().data(), size_t(0), lowerCoupling.RowCount(), first.solution.data(),
+				couplingBuffer.data(), 1., 0.);
+			LinearAlgebra::AXPY(-1., couplingBuffer.data(), second.rhs.data(), second.indices.size());
+			if (!SolveBlock(1, x))
+			{
+				return false;
+			}
+
+			Gather(first, y);
+			Native::CSRMVMultiply(upperCoupling.GetRowCounts().data(), upperCoupling.GetColumnIndices().data(),
+				upperCoupling.GetValues().data(), size_t(0), upperCoupling.RowCount(), second.solution.data(),
+				couplingBuffer.data(), 1., 0.);
+			LinearAlgebra::AXPY(-1., couplingBuffer.data(), first.rhs.data(), first.indices.size());
+			return SolveBlock(0, x);
+		}
+
+		FieldSplitType type;
+		std::vector<Block> blocks;
+		// Block and index within block of every unknown.
+		Array<size_t> blockOf;
+		Array<size_t> localIndices;
+		CouplingMatrixType upperCoupling;
+		CouplingMatrixType lowerCoupling;
+		VectorType couplingBuffer;
+	};
+
+	// Returns unknowns of the given equations of stationary problem in the Jacobian ordering: continuous equation f
+	// owns values of field f at all grid points, discrete equation d owns the single discrete variable d.
+	template<typename ProblemType>
+	[[nodiscard]] Array<size_t> GetEquationGroupIndices(const ProblemType& problem, const Array<size_t>& equations) noexcept
+	{
+		const auto& descriptor = problem.GetDescriptor();
+		const size_t gridSize = problem.GetGrid().GetSize();
+		const size_t ceCount = descriptor.ContinuousEquationCount();
+
+		size_t size = 0;
+		for (const auto equation : equations)
+		{
+			size += equation < ceCount ? gridSize : 1;
+		}
+		auto result = Array<size_t>(size);
+		size_t position = 0;
+		for (const auto equation : equations)
+		{
+			if (equation < ceCount)
+			{
+				for (size_t point = 0; point < gridSize; ++point)
+				{
+					result[position++] = equation * gridSize + point;
+				}
+			}
+			else
+			{
+				result[position++] = ceCount * gridSize + equation - ceCount;
+			}
+		}
+		return result;
+	}
+
+	// Splits equations of stationary problem into groups which are not coupled through the Jacobian structure
+	// declared by the problem descriptor, that is connected components of equation-variable dependency graph.
+	template<typename ProblemType>
+	[[nodiscard]] std::vector<Array<size_t>> GetCoupledEquationGroups(const ProblemType& problem) noexcept
+	{
+		const auto& descriptor = problem.GetDescriptor();
+		const size_t ceCount = descriptor.ContinuousEquationCount();
+		const size_t eCount = descriptor.EquationCount();
+		const size_t regionCount = problem.GetGrid().GetRegionCount();
+
+		auto parent = Array<size_t>(eCount);
+		for (size_t i = 0; i < eCount; ++i)
+		{
+			parent[i] = i;
+		}
+		const auto find = [&](size_t i)
+		{
+			while (parent[i] != i)
+			{
+				parent[i] = parent[parent[i]];
+				i = parent[i];
+			}
+			return i;
+		};
+
+		for (size_t i = 0; i < eCount; ++i)
+		{
+			for (size_t j = 0; j < eCount; ++j)
+			{
+				if (i == j || find(i) == find(j))
+				{
+					continue;
+				}
+				const size_t derivativeCount = j < ceCount ? descriptor.DerivativeOperatorCount(j) : 0;
+				bool coupled = false;
+				for (size_t k = 0; k <= derivativeCount && !coupled; ++k)
+				{
+					// Discrete equations are defined on the whole grid and have the single region level.
+					const size_t equationRegionCount = i < ceCount ? regionCount : 1;
+					for (size_t region = 0; region < equationRegionCount && !coupled; ++region)
+					{
+						coupled = descriptor.HasJacobianComponent(i, j, k, region);
+					}
+				}
+				if (coupled)
+				{
+					parent[find(i)] = find(j);
+				}
+			}
+		}
+
+		std::vector<Array<size_t>> result;
+		auto groupOf = Array<size_t>(std::numeric_limits<size_t>::max(), eCount);
+		auto groupSizes = std::vector<size_t>();
+		for (size_t i = 0; i < eCount; ++i)
+		{
+			auto& group = groupOf[find(i)];
+			if (group == std::numeric_limits<size_t>::max())
+			{
+				group = groupSizes.size();
+				groupSizes.push_back(0);
+			}
+			++groupSizes[group];
+		}
+		for (const auto size : groupSizes)
+		{
+			result.push_back(Array<size_t>(size));
+		}
+		std::fill(groupSizes.begin(), groupSizes.end(), 0);
+		for (size_t i = 0; i < eCount; ++i)
+		{
+			const size_t group = groupOf[find(i)];
+			result[group][groupSizes[group]++] = i;
+		}
+		return result;
+	}
+}
\ No newline at end of file
@@ -36,5 +36,6 @@ namespace CESDSOL
 #endif
 
 #include "CSRMatrixOperations.h"
+#include "Native/CSRMatrixOperations.h"
 #include "SparseVector.h" 
 #include "SparseVectorOperations.h"
\ No newline at end of file
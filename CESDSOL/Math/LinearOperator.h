@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Math/LinearAlgebra.h"
+
+#include <concepts>
+
+namespace CESDSOL
+{
+	namespace Concepts
+	{
+		// Operator which is able to compute y = A * x without explicitly stored matrix.
+		template<typename OperatorType, typename VectorType>
+		concept MatrixFreeOperator = requires(const OperatorType& op, const VectorType& x, VectorType& y)
+		{
+			op.Apply(x, y);
+		};
+	}
+
+	// y = A * x for both matrix-free operators and explicitly stored matrices.
+	template<typename OperatorType, Concepts::Vector XVectorType, Concepts::Vector YVectorType>
+	void ApplyOperator(const OperatorType& A, const XVectorType& x, YVectorType& y)
+	{
+		if constexpr (Concepts::MatrixFreeOperator<OperatorType, YVectorType>)
+		{
+			A.Apply(x, y);
+		}
+		else
+		{
+			MVMultiply(A, x, y, 1., 0.);
+		}
+	}
+}
\ No newline at end of file
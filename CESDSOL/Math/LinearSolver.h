@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+
 namespace CESDSOL
 {
 	template<typename MatrixType, typename VectorType>
@@ -7,6 +9,46 @@ namespace CESDSOL
 	{
 	public:
 		virtual bool Solve(const MatrixType& matrix, const VectorType& y, VectorType& x) = 0;
+
+		// Solves systems with the same matrix for rhsCount right hand sides stored one after another in y, solutions
+		// are stored the same way in x. Default implementation solves them one by one, direct solvers override it to
+		// traverse factors once for all right hand sides.
+		virtual bool SolveMultiple(const MatrixType& matrix, const VectorType& y, VectorType& x, size_t rhsCount)
+		{
+			const size_t size = y.size() / rhsCount;
+			auto rhs = VectorType(size);
+			auto solution = VectorType(size);
+			for (size_t i = 0; i < rhsCount; ++i)
+			{
+				std::copy(y.begin() + i * size, y.begin() + (i + 1) * size, rhs.begin());
+				std::copy(x.begin() + i * size, x.begin() + (i + 1) * size, solution.begin());
+				if (!Solve(matrix, rhs, solution))
+				{
+					return false;
+				}
+				std::copy(solution.begin(), solution.end(), x.begin() + i * size);
+			}
+			return true;
+		}
+
+		// Factorizes matrix for subsequent SolveFactorized calls, so that repeated solves with the same matrix (e.g.
+		// iterative refinement or stages of implicit integrators) do not repeat the factorization. The matrix must
+		// stay alive and unchanged until the next Factorize call. Default implementation only keeps the matrix,
+		// and SolveFactorized solves from scratch.
+		virtual bool Factorize(const MatrixType& matrix)
+		{
+			factorizedMatrix = &matrix;
+			return true;
+		}
+
+		virtual bool SolveFactorized(const VectorType& y, VectorType& x)
+		{
+			return Solve(*factorizedMatrix, y, x);
+		}
+
 		virtual ~LinearSolver() = default;
+
+	protected:
+		const MatrixType* factorizedMatrix = nullptr;
 	};
 }
\ No newline at end of file
@@ -6,7 +6,9 @@
 
 #include "mkl.h"
 
+#include <algorithm>
 #include <concepts>
+#include <limits>
 
 namespace CESDSOL::MKL
 {
@@ -41,7 +43,7 @@ namespace CESDSOL::MKL
 #define CREATE_CSR_OPERATION(x) mkl_sparse_##x##_create_csr
 			MKL_SPARSE_OPERATION(CREATE_CSR_OPERATION, "CSR matrix construction",
 				&handle, static_cast<sparse_index_base_t>(StartingIndex),
-				static_cast<int>(this->rowCount), static_cast<int>(this->columnCount),
+				static_cast<MKL_INT>(this->rowCount), static_cast<MKL_INT>(this->columnCount),
 				this->rowCounts.data(), this->rowCounts.data() + 1, this->columnIndices.data(), this->values.data());
 #undef CREATE_CSR_OPERATION
 		}
@@ -49,10 +51,15 @@ namespace CESDSOL::MKL
 	public:
 		constexpr CSRMatrix() noexcept = default;
 
-		constexpr CSRMatrix(MKL_INT aRowCount, MKL_INT aColumnCount, MKL_INT nonZeroCount) noexcept
+		CSRMatrix(size_t aRowCount, size_t aColumnCount, size_t nonZeroCount) noexcept
 			: Native::CSRMatrix<ScalarType, MKL_INT, StartingIndex>(aRowCount, aColumnCount, nonZeroCount)
 			, descriptor({ SPARSE_MATRIX_TYPE_GENERAL, SPARSE_FILL_MODE_FULL, SPARSE_DIAG_NON_UNIT })
 		{
+			// Row offsets are stored as MKL_INT, so number of nonzeros bounds all indices of the matrix.
+			constexpr auto MaxIndex = static_cast<size_t>(std::numeric_limits<MKL_INT>::max());
+			AssertE(std::max<size_t>({ aRowCount, aColumnCount, nonZeroCount + StartingIndex }) <= MaxIndex, MessageTag::Math,
+				Format("CSR matrix with {} rows and {} nonzeros exceeds {}-bit MKL indices, enable UseILP64 option.",
+					aRowCount, nonZeroCount, 8 * sizeof(MKL_INT)));
 			CreateHandle();
 		}
 
@@ -116,6 +123,27 @@ namespace CESDSOL::MKL
 			return descriptor;
 		}
 
+		// Passes expected number of matrix-vector products to inspector-executor and lets it build optimized
+		// internal representation. It is not updated on later changes of values, so only matrices with constant
+		// values should be optimized.
+		void Optimize(MKL_INT expectedCallCount) noexcept
+		{
+			auto status = mkl_sparse_set_mv_hint(handle, SPARSE_OPERATION_NON_TRANSPOSE, descriptor, expectedCallCount);
+			if (status == SPARSE_STATUS_SUCCESS)
+			{
+				status = mkl_sparse_set_memory_hint(handle, SPARSE_MEMORY_AGGRESSIVE);
+			}
+			if (status == SPARSE_STATUS_SUCCESS)
+			{
+				status = mkl_sparse_optimize(handle);
+			}
+			if (status != SPARSE_STATUS_SUCCESS)
+			{
+				Logger::Log(MessageType::Warning, MessagePriority::Medium, MessageTag::Math,
+					Format("Sparse matrix optimization: {}.", MKL::SparseStatusMessages[status]));
+			}
+		}
+
 		~CSRMatrix()
 		{
 			if (handle != nullptr)
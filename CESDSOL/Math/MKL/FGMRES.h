@@ -49,12 +49,14 @@ namespace CESDSOL::MKL
 
 			if (preconditioner != nullptr)
 			{
-				if (!preconditioner->Setup(matrix, y)->success)
+				if (!preconditioner->Setup(matrix, y))
 				{
 					Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::LinearSolver,
 						"Failed to setup preconditioner for FGMRES.");
 					return false;
 				}
+				preconditionerRhs = Vector<double>(size);
+				preconditionerSolution = Vector<double>(size);
 			}
 			while (true)
 			{
@@ -69,9 +71,15 @@ namespace CESDSOL::MKL
 				}
 				if (rciRequest == ApplyPreconditionerRCIRequest)
 				{
-					const std::span inSpan(tmp.data() + intParameters[21] - 1, size);
-					std::span outSpan(tmp.data() + intParameters[22] - 1, size);
-					preconditioner->Solve(matrix, inSpan, outSpan);
+					// Preconditioners work with vectors, so work array parts are copied.
+					LinearAlgebra::Copy(tmp.data() + intParameters[21] - 1, preconditionerRhs.data(), size);
+					if (!preconditioner->Solve(matrix, preconditionerRhs, preconditionerSolution))
+					{
+						Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::LinearSolver,
+							"Failed to apply preconditioner in FGMRES.");
+						return false;
+					}
+					LinearAlgebra::Copy(preconditionerSolution.data(), tmp.data() + intParameters[22] - 1, size);
 					continue;
 				}
 				if (rciRequest == SuccessRCIRequest)
@@ -109,7 +117,7 @@ namespace CESDSOL::MKL
 					return false;
 				}
 			}
-			int iterationCount;
+			MKL_INT iterationCount;
 			dfgmres_get(&size, x.data(), y.data(), &rciRequest, intParameters.data(),
 				floatParameters.data(), tmp.data(), &iterationCount);
 			if (rciRequest != SuccessRCIRequest)
@@ -165,6 +173,8 @@ namespace CESDSOL::MKL
 		}
 
 		uptr<Preconditioner<MatrixType, Vector<double>>> preconditioner;
+		Vector<double> preconditionerRhs;
+		Vector<double> preconditionerSolution;
 
 		MakeProperty(exitConditions, ExitConditions, FGMRESExitConditions, FGMRESExitConditions::Everything)
 		MakeProperty(iterationLimit, IterationLimit, size_t, 150)
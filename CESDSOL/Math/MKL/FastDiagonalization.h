@@ -0,0 +1,365 @@
+#pragma once
+
+#include "Grid/DirectProductGrid.h"
+#include "Math/LinearAlgebra.h"
+#include "Math/Preconditioner.h"
+
+#include "mkl.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <optional>
+
+namespace CESDSOL::MKL
+{
+	// Exact inverse of separable operators sum_d I x ... x A_d x ... x I + shift * I on direct product grids, where A_d
+	// acts along axis d only. Every axis operator is diagonalized as A_d = V_d L_d V_d^-1 during setup, application
+	// transforms the field to the eigenbasis, divides by sums of eigenvalues and transforms back, each transform being
+	// a sequence of dense matrix products along single axes. Operators are requested from the provider on every setup,
+	// setup fails if the provider returns none. Fields without separable operator and discrete variables are
+	// preconditioned by matrix diagonal.
+	template<typename MatrixType, size_t Dimension>
+	class FastDiagonalization final
+		: public Preconditioner<MatrixType, Vector<double>>
+	{
+	public:
+		using VectorType = Vector<double>;
+
+		struct SeparableOperator
+		{
+			// Dense row major axis operators, empty if field has no separable operator.
+			std::array<Array<double>, Dimension> axisOperators;
+			double shift = 0;
+			// Points where equation has no derivatives (for example, Dirichlet boundary conditions), preconditioned
+			// by matrix diagonal after the separable solve.
+			Array<size_t> algebraicPoints;
+		};
+
+		using OperatorProvider = std::function<std::optional<Array<SeparableOperator>>()>;
+
+		FastDiagonalization(const std::array<size_t, Dimension>& aAxisSizes, size_t aFieldCount, OperatorProvider aProvider) noexcept
+			: axisSizes(aAxisSizes)
+			, fieldCount(aFieldCount)
+			, provider(std::move(aProvider))
+		{
+			pointCount = 1;
+			for (const auto size : axisSizes)
+			{
+				pointCount *= size;
+			}
+		}
+
+		bool Setup(const MatrixType& matrix, const VectorType& y) noexcept override
+		{
+			const auto providedOperators = provider();
+			if (!providedOperators)
+			{
+				Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+					"Failed to get separable operators for fast diagonalization preconditioner.");
+				return false;
+			}
+			const auto& operators = *providedOperators;
+			AssertE(operators.size() == fieldCount, MessageTag::Preconditioner,
+				"Separable operator provider returned operators for wrong number of fields.");
+
+			fields = Array<FieldData>(fieldCount);
+			for (size_t field = 0; field < fieldCount; ++field)
+			{
+				if (operators[field].axisOperators[0].size() == 0)
+				{
+					continue;
+				}
+				auto& data = fields[field];
+				for (size_t axis = 0; axis < Dimension; ++axis)
+				{
+					if (!Diagonalize(operators[field].axisOperators[axis], axisSizes[axis], data, axis))
+					{
+						Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+							Format("Failed to diagonalize operator of field {} along axis {}.", field, axis));
+						return false;
+					}
+				}
+				data.algebraicPoints = operators[field].algebraicPoints;
+				data.inverseEigenvalues = Array<double>(pointCount);
+				const double shift = operators[field].shift;
+				ParallelFor(0, pointCount, [&](int64_t point)
+					{
+						double value = shift;
+						size_t remainder = point;
+						for (size_t axis = Dimension; axis-- > 0;)
+						{
+							value += data.eigenvalues[axis][remainder % axisSizes[axis]];
+							remainder /= axisSizes[axis];
+						}
+						data.inverseEigenvalues[point] = std::abs(value) > singularityThreshold ? 1. / value : 0.;
+					});
+			}
+
+			inverseDiagonal = Array<double>(matrix.RowCount());
+			ParallelFor(0, matrix.RowCount(), [&](int64_t row)
+				{
+					for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+					{
+						if (static_cast<int64_t>(matrix.GetColumnIndex(k)) == row && matrix.GetValue(k) != 0)
+						{
+							inverseDiagonal[row] = 1. / matrix.GetValue(k);
+						}
+					}
+				});
+			firstBuffer = VectorType(pointCount);
+			secondBuffer = VectorType(pointCount);
+			return true;
+		}
+
+		bool Solve(const MatrixType& matrix, const VectorType& y, VectorType& x) override
+		{
+			for (size_t field = 0; field < fieldCount; ++field)
+			{
+				const size_t offset = field * pointCount;
+				const auto& data = fields[field];
+				if (data.inverseEigenvalues.size() == 0)
+				{
+					ParallelFor(offset, offset + pointCount, [&](int64_t i)
+						{
+							x[i] = inverseDiagonal[i] * y[i];
+						});
+					continue;
+				}
+
+				Transform(data.inverseEigenvectors, y.data() + offset, firstBuffer.data(), secondBuffer.data());
+				ParallelFor(0, pointCount, [&](int64_t i)
+					{
+						firstBuffer[i] *= data.inverseEigenvalues[i];
+					});
+				Transform(data.eigenvectors, firstBuffer.data(), x.data() + offset, secondBuffer.data());
+				ParallelFor(0, data.algebraicPoints.size(), [&](int64_t i)
+					{
+						const size_t row = offset + data.algebraicPoints[i];
+						x[row] = inverseDiagonal[row] * y[row];
+					});
+			}
+			ParallelFor(fieldCount * pointCount, y.size(), [&](int64_t i)
+				{
+					x[i] = inverseDiagonal[i] * y[i];
+				});
+			return true;
+		}
+
+	private:
+		struct FieldData
+		{
+			std::array<Array<double>, Dimension> eigenvalues;
+			std::array<Array<double>, Dimension> eigenvectors;
+			std::array<Array<double>, Dimension> inverseEigenvectors;
+			Array<double> inverseEigenvalues;
+			Array<size_t> algebraicPoints;
+		};
+
+		bool Diagonalize(const Array<double>& axisOperator, size_t size, FieldData& data, size_t axis) noexcept
+		{
+			const MKL_INT n = static_cast<MKL_INT>(size);
+			auto matrix = axisOperator;
+			auto realParts = Array<double>(size);
+			auto imaginaryParts = Array<double>(size);
+			auto eigenvectors = Array<double>(size * size);
+			if (LAPACKE_dgeev(LAPACK_ROW_MAJOR, 'N', 'V', n, matrix.data(), n, realParts.data(), imaginaryParts.data(),
+				nullptr, n, eigenvectors.data(), n) != 0)
+			{
+				return false;
+			}
+			double spectralRadius = 0;
+			for (size_t i = 0; i < size; ++i)
+			{
+				spectralRadius = std::max(spectralRadius, std::hypot(realParts[i], imaginaryParts[i]));
+			}
+			for (size_t i = 0; i < size; ++i)
+			{
+				if (std::abs(imaginaryParts[i]) > complexityThreshold * spectralRadius)
+				{
+					Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+						"Axis operator has complex eigenvalues, fast diagonalization is not applicable.");
+					return false;
+				}
+			}
+
+			auto inverse = eigenvectors;
+			auto pivots = Array<MKL_INT>(size);
+			if (LAPACKE_dgetrf(LAPACK_ROW_MAJOR, n, n, inverse.data(), n, pivots.data()) != 0
+				|| LAPACKE_dgetri(LAPACK_ROW_MAJOR, n, inverse.data(), n, pivots.data()) != 0)
+			{
+				return false;
+			}
+			data.eigenvalues[axis] = std::move(realParts);
+			data.eigenvectors[axis] = std::move(eigenvectors);
+			data.inverseEigenvectors[axis] = std::move(inverse);
+			return true;
+		}
+
+		// Applies tensor product of the given axis matrices to the field. Axis d contraction treats the field as
+		// array of outer x n_d x inner blocks and multiplies every n_d x inner block by n_d x n_d matrix.
+		void Transform(const std::array<Array<double>, Dimension>& matrices, const double* input, double* output,
+			double* buffer) const noexcept
+		{
+			const double* source = input;
+			size_t outer = 1;
+			for (size_t axis = 0; axis < Dimension; ++axis)
+			{
+				const size_t size = axisSizes[axis];
+				const size_t inner = pointCount / (outer * size);
+				double* target = (Dimension - axis) % 2 == 1 ? output : buffer;
+				const double* matrix = matrices[axis].data();
+				ParallelFor(0, outer, [&](int64_t block)
+					{
+						cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, static_cast<MKL_INT>(size),
+							static_cast<MKL_INT>(inner), static_cast<MKL_INT>(size), 1., matrix, static_cast<MKL_INT>(size),
+							source + block * size * inner, static_cast<MKL_INT>(inner), 0.,
+							target + block * size * inner, static_cast<MKL_INT>(inner));
+					});
+				source = target;
+				outer *= size;
+			}
+		}
+
+		std::array<size_t, Dimension> axisSizes;
+		size_t pointCount;
+		size_t fieldCount;
+		OperatorProvider provider;
+
+		Array<FieldData> fields;
+		Array<double> inverseDiagonal;
+		VectorType firstBuffer;
+		VectorType secondBuffer;
+
+		MakeProperty(complexityThreshold, ComplexityThreshold, double, 1e-8)
+		MakeProperty(singularityThreshold, SingularityThreshold, double, 1e-14)
+	};
+
+	// Makes fast diagonalization preconditioner for diagonal Jacobian blocks of stationary problem on direct product
+	// grid. On every setup the separable part of equation f with respect to field f is extracted: nonzero coefficients
+	// of derivative operators acting along single axis are averaged over other axes and multiply rows of the axis
+	// differentiation matrices, coefficient of the field value is averaged into the shift over points where the
+	// equation has derivatives. Remaining points (usually boundary conditions) are treated as algebraic.
+	template<typename ProblemType>
+	[[nodiscard]] auto MakeFastDiagonalization(const ProblemType& problem)
+	{
+		constexpr size_t Dimension = ProblemType::Dimension;
+		using GridType = DirectProductGrid<Dimension, typename ProblemType::CoordinateType>;
+		using PreconditionerType = FastDiagonalization<typename ProblemType::JacobianMatrixType, Dimension>;
+		using SeparableOperator = typename PreconditionerType::SeparableOperator;
+
+		const auto* grid = dynamic_cast<const GridType*>(&problem.GetGrid());
+		AssertE(grid != nullptr, MessageTag::Preconditioner, "Fast diagonalization requires problem on direct product grid.");
+		std::array<size_t, Dimension> axisSizes;
+		for (size_t axis = 0; axis < Dimension; ++axis)
+		{
+			axisSizes[axis] = grid->GetDimensionSize(axis);
+		}
+		const size_t fieldCount = problem.GetDescriptor().ContinuousEquationCount();
+
+		auto provider = [&problem, axisSizes, fieldCount]() -> std::optional<Array<SeparableOperator>>
+		{
+			const auto& descriptor = problem.GetDescriptor();
+			const size_t pointCount = problem.GetGrid().GetSize();
+			auto result = Array<SeparableOperator>(fieldCount);
+			auto averages = Array<double>();
+			auto counts = Array<size_t>();
+			for (size_t field = 0; field < fieldCount; ++field)
+			{
+				auto& separableOperator = result[field];
+				auto isDifferential = Array<bool>(pointCount);
+				for (size_t k = 1; k <= descriptor.DerivativeOperatorCount(field); ++k)
+				{
+					const auto& coefficients = problem.GetJacobianComponent(field, field, k);
+					const auto& orders = descriptor.GetDerivativeOperator(field, k - 1);
+					const size_t axis = std::find_if(orders.begin(), orders.end(), [](size_t order) { return order > 0; }) - orders.begin();
+					if (coefficients.size() == 0 || axis == Dimension
+						|| std::count_if(orders.begin(), orders.end(), [](size_t order) { return order > 0; }) != 1)
+					{
+						continue;
+					}
+					if (separableOperator.axisOperators[0].size() == 0)
+					{
+						for (size_t i = 0; i < Dimension; ++i)
+						{
+							separableOperator.axisOperators[i] = Array<double>(axisSizes[i] * axisSizes[i]);
+						}
+					}
+
+					size_t stride = 1;
+					for (size_t i = axis + 1; i < Dimension; ++i)
+					{
+						stride *= axisSizes[i];
+					}
+					averages = Array<double>(axisSizes[axis]);
+					counts = Array<size_t>(axisSizes[axis]);
+					for (size_t point = 0; point < pointCount; ++point)
+					{
+						if (coefficients[point] != 0)
+						{
+							const size_t index = (point / stride) % axisSizes[axis];
+							averages[index] += coefficients[point];
+							++counts[index];
+							isDifferential[point] = true;
+						}
+					}
+					const auto differentiationMatrix = problem.GetDiscretizer().GetAxisDifferentiationMatrix(problem.GetGrid(),
+						axis, orders[axis]);
+					auto& axisOperator = separableOperator.axisOperators[axis];
+					for (size_t row = 0; row < axisSizes[axis]; ++row)
+					{
+						if (counts[row] == 0)
+						{
+							continue;
+						}
+						if (differentiationMatrix.GetRowCount(row) == differentiationMatrix.GetRowCount(row + 1))
+						{
+							Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+								Format("Differentiation matrix along axis {} has no entries in row {}, fast diagonalization of field {} is impossible.",
+									axis, row, field));
+							return std::nullopt;
+						}
+						const double average = averages[row] / counts[row];
+						for (size_t l = differentiationMatrix.GetRowCount(row); l < differentiationMatrix.GetRowCount(row + 1); ++l)
+						{
+							axisOperator[row * axisSizes[axis] + differentiationMatrix.GetColumnIndex(l)] +=
+								average * differentiationMatrix.GetValue(l);
+						}
+					}
+				}
+
+				const auto& valueCoefficients = problem.GetJacobianComponent(field, field, 0);
+				if (separableOperator.axisOperators[0].size() == 0)
+				{
+					continue;
+				}
+				size_t differentialPointCount = 0;
+				for (size_t point = 0; point < pointCount; ++point)
+				{
+					if (isDifferential[point])
+					{
+						separableOperator.shift += valueCoefficients.size() > 0 ? valueCoefficients[point] : 0.;
+						++differentialPointCount;
+					}
+				}
+				if (differentialPointCount == 0)
+				{
+					Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+						Format("Equation of field {} has no points with derivatives, fast diagonalization is impossible.", field));
+					return std::nullopt;
+				}
+				separableOperator.shift /= differentialPointCount;
+				separableOperator.algebraicPoints = Array<size_t>(pointCount - differentialPointCount);
+				for (size_t point = 0, position = 0; point < pointCount; ++point)
+				{
+					if (!isDifferential[point])
+					{
+						separableOperator.algebraicPoints[position++] = point;
+					}
+				}
+			}
+			return result;
+		};
+		return std::make_unique<PreconditionerType>(axisSizes, fieldCount, std::move(provider));
+	}
+}
\ No newline at end of file
@@ -58,7 +58,7 @@ namespace CESDSOL::MKL
 	
 	void ILU0::SetNormalizeZeroDiagonal(bool value) noexcept
 	{
-		intParameters[30] = static_cast<int>(value);
+		intParameters[30] = static_cast<MKL_INT>(value);
 	}
 	
 	void ILU0::SetZeroDiagonalThreshold(double value) noexcept
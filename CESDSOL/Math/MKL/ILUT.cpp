@@ -73,7 +73,7 @@ namespace CESDSOL::MKL
 
 	void ILUT::SetNormalizeZeroDiagonal(bool value) noexcept
 	{
-		intParameters[30] = static_cast<int>(value);
+		intParameters[30] = static_cast<MKL_INT>(value);
 	}
 
 	void ILUT::SetZeroDiagonalNormalizer(double value) noexcept
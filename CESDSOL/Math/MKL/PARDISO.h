@@ -2,6 +2,7 @@
 
 #include "Math/MKL/Concepts.h"
 #include "Math/MKL/CSRMatrix.h"
+#include "Math/MKL/PARDISOAnalysisCache.h"
 #include "Math/LinearAlgebra.h"
 #include "Math/LinearSolver.h"
 #include "Utils/Aliases.h"
@@ -10,6 +11,7 @@
 
 #include <chrono>
 #include <concepts>
+#include <memory>
 
 namespace CESDSOL::MKL
 {
@@ -64,6 +66,11 @@ namespace CESDSOL::MKL
 		double cgsTolerance = 1e-6;
 		Array<MKL_INT> permutation;
 
+		std::shared_ptr<PARDISOAnalysisCache> analysisCache;
+		uint64_t analysisPatternHash = 0;
+		// Pattern of the matrix of the last successful analysis phase.
+		uint64_t analyzedPatternHash = 0;
+
 		static constexpr MKL_INT MklMatrixType = std::is_same_v<ScalarType, c32> || std::is_same_v<ScalarType, c64>
 			? static_cast<MKL_INT>(PardisoMatrixType::ComplexNonsymmetric)
 			: static_cast<MKL_INT>(PardisoMatrixType::RealNonsymmetric);
@@ -72,6 +79,85 @@ namespace CESDSOL::MKL
 		static constexpr MKL_INT RhsCount = 1;
 		static constexpr MKL_INT MessageLevel = 0;
 
+		bool Solve(const MatrixType& matrix, const VectorType& y, VectorType& x, MKL_INT rhsCount) noexcept
+		{
+			Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver, Format("Starting solving system of {} linear equations with {} right hand sides with PARDISO.", matrix.RowCount(), rhsCount));
+			std::chrono::high_resolution_clock clock;
+			const auto solutionStartTime = clock.now();
+			const bool result = RunPhase(matrix, y.data(), x.data(), rhsCount);
+			if (result)
+			{
+				SetSolutionPhase(SolutionPhase::FactorizationSolveIterativeRefinement);
+				Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver, 
+					Format("Linear system is solved by PARDISO in {}", clock.now() - solutionStartTime).c_str());
+			}
+			return result;
+		}
+
+		// Runs current solution phase for the matrix, right hand sides and solutions are not accessed by phases
+		// without solve.
+		bool RunPhase(const MatrixType& matrix, ScalarType* y, ScalarType* x, MKL_INT rhsCount) noexcept
+		{
+			MKL_INT error;
+			if (equationCount != EmptyInternalMatrix)
+			{
+				AssertE(equationCount == matrix.RowCount(), MessageTag::LinearSolver, "Inconsistent nonzero count in matrix for PARDISO to solve.");
+			}
+			else
+			{
+				equationCount = static_cast<MKL_INT>(matrix.RowCount());
+			}
+			const auto permutationMode = GetPermutationMode();
+			const bool isCachedAnalysis = analysisCache != nullptr && IsAnalysisPhase()
+				&& permutationMode != PermutationMode::UserProvided;
+			if (isCachedAnalysis)
+			{
+				PrepareCachedAnalysis(matrix);
+			}
+			pardiso(internalData, &MaxFactorCount, &MatrixNumber, &MklMatrixType, &currentPhase, &equationCount,
+				matrix.GetValues().data(), matrix.GetRowCounts().data(), matrix.GetColumnIndices().data(),
+				permutation.data(), &rhsCount, intParameters, &MessageLevel,
+				y, x, &error);
+			NotifyError(error);
+			if (error == 0 && IsAnalysisPhase())
+			{
+				analyzedPatternHash = isCachedAnalysis ? analysisPatternHash : ComputePatternHash(matrix);
+			}
+			if (isCachedAnalysis)
+			{
+				if (error == 0 && GetPermutationMode() == PermutationMode::Calculated)
+				{
+					analysisCache->Store(analysisPatternHash, permutation);
+				}
+				SetPermutationMode(permutationMode);
+			}
+			return error == 0;
+		}
+
+		[[nodiscard]] bool IsAnalysisPhase() const noexcept
+		{
+			return currentPhase == static_cast<MKL_INT>(SolutionPhase::AnalysisFactorization)
+				|| currentPhase == static_cast<MKL_INT>(SolutionPhase::AnalysisFactorizationSolveIterativeRefinement);
+		}
+
+		// Takes permutation for the pattern from the cache, or requests PARDISO to return computed one.
+		void PrepareCachedAnalysis(const MatrixType& matrix) noexcept
+		{
+			analysisPatternHash = ComputePatternHash(matrix);
+			if (auto cached = analysisCache->Find(analysisPatternHash, matrix.RowCount()))
+			{
+				permutation = std::move(*cached);
+				SetPermutationMode(PermutationMode::UserProvided);
+				Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+					"PARDISO uses cached fill-reducing permutation.");
+			}
+			else
+			{
+				permutation = Array<MKL_INT>(matrix.RowCount());
+				SetPermutationMode(PermutationMode::Calculated);
+			}
+		}
+
 		void SetSolutionPhase(SolutionPhase phase) noexcept
 		{
 			currentPhase = static_cast<MKL_INT>(phase);
@@ -194,6 +280,23 @@ namespace CESDSOL::MKL
 			intParameters[4] = static_cast<MKL_INT>(mode);
 		}
 
+		[[nodiscard]] PermutationMode GetPermutationMode() const noexcept
+		{
+			return static_cast<PermutationMode>(intParameters[4]);
+		}
+
+		// Analysis of matrices with patterns present in the cache uses stored permutations and skips reordering,
+		// permutations computed by this solver are added to the cache. Ignored with user provided permutation.
+		void SetAnalysisCache(std::shared_ptr<PARDISOAnalysisCache> cache) noexcept
+		{
+			analysisCache = std::move(cache);
+		}
+
+		[[nodiscard]] const std::shared_ptr<PARDISOAnalysisCache>& GetAnalysisCache() const noexcept
+		{
+			return analysisCache;
+		}
+
 		[[nodiscard]] const Array<MKL_INT>& GetPermutation() const noexcept
 		{
 			return permutation;
@@ -270,6 +373,21 @@ namespace CESDSOL::MKL
 			intParameters[24] = static_cast<MKL_INT>(strategy);
 		}
 
+		// Lets PARDISO merge rows and columns with patterns similar at least by the given percentage into variable
+		// size blocks, which gives larger supernodes for multi-field systems in point-major ordering. Zero disables it.
+		void SetVBSRThreshold(MKL_INT threshold) noexcept
+		{
+			if (threshold < 0 || threshold > 100)
+			{
+				Logger::Log(MessageType::Warning, MessagePriority::High, MessageTag::LinearSolver,
+					Format("Trying to set invalid VBSR threshold {} for PARDISO solver.", threshold));
+			}
+			else
+			{
+				intParameters[36] = -threshold;
+			}
+		}
+
 		PARDISO() noexcept
 		{
 			pardisoinit(internalData, &MklMatrixType, intParameters);
@@ -293,34 +411,43 @@ namespace CESDSOL::MKL
 
 		bool Solve(const MatrixType& matrix, const VectorType& y, VectorType& x) noexcept override
 		{
-			Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver, Format("Starting solving system of {} linear equations with PARDISO.", matrix.RowCount()));
-			std::chrono::high_resolution_clock clock;
-			const auto solutionStartTime = clock.now();
-			MKL_INT error;
-			if (equationCount != EmptyInternalMatrix)
-			{
-				AssertE(equationCount == matrix.RowCount(), MessageTag::LinearSolver, "Inconsistent nonzero count in matrix for PARDISO to solve.");
-			}
-			else
-			{
-				equationCount = static_cast<MKL_INT>(matrix.RowCount());
-			}
-			pardiso(internalData, &MaxFactorCount, &MatrixNumber, &MklMatrixType, &currentPhase, &equationCount,
-				matrix.GetValues().data(), matrix.GetRowCounts().data(), matrix.GetColumnIndices().data(),
-				permutation.data(), &RhsCount, intParameters, &MessageLevel,
-				y.data(), x.data(), &error);
-			NotifyError(error);
-			if (error == 0)
+			return Solve(matrix, y, x, RhsCount);
+		}
+
+		// All right hand sides are passed to PARDISO at once, so substitutions traverse factors once for the whole block.
+		bool SolveMultiple(const MatrixType& matrix, const VectorType& y, VectorType& x, size_t rhsCount) noexcept override
+		{
+			return Solve(matrix, y, x, static_cast<MKL_INT>(rhsCount));
+		}
+
+		// Analysis is repeated only when the pattern differs from the analyzed one, as in native solvers.
+		bool Factorize(const MatrixType& matrix) noexcept override
+		{
+			if (equationCount != EmptyInternalMatrix && equationCount != static_cast<MKL_INT>(matrix.RowCount()))
 			{
-				SetSolutionPhase(SolutionPhase::FactorizationSolveIterativeRefinement);
-				Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver, 
-					Format("Linear system is solved by PARDISO in {}", clock.now() - solutionStartTime).c_str());
+				ResetSolutionData();
 			}
-			return error == 0;
-		};
+			const bool isAnalyzed = equationCount != EmptyInternalMatrix && ComputePatternHash(matrix) == analyzedPatternHash;
+			SetSolutionPhase(isAnalyzed ? SolutionPhase::Factor : SolutionPhase::AnalysisFactorization);
+			this->factorizedMatrix = &matrix;
+			const bool result = RunPhase(matrix, nullptr, nullptr, RhsCount);
+			SetSolutionPhase(result || isAnalyzed
+				? SolutionPhase::FactorizationSolveIterativeRefinement
+				: SolutionPhase::AnalysisFactorizationSolveIterativeRefinement);
+			return result;
+		}
+
+		bool SolveFactorized(const VectorType& y, VectorType& x) noexcept override
+		{
+			SetSolutionPhase(SolutionPhase::SolveIterativeRefinement);
+			const bool result = RunPhase(*this->factorizedMatrix, y.data(), x.data(), RhsCount);
+			SetSolutionPhase(SolutionPhase::FactorizationSolveIterativeRefinement);
+			return result;
+		}
 
 		void ResetSolutionData() noexcept
 		{
+			this->factorizedMatrix = nullptr;
 			if (equationCount != EmptyInternalMatrix)
 			{
 				MKL_INT error;
@@ -0,0 +1,86 @@
+#include "Math/MKL/PARDISOAnalysisCache.h"
+
+#include "Serialization/Serializer.h"
+
+namespace CESDSOL::MKL
+{
+	namespace
+	{
+		constexpr uint32_t CacheMagicNumber = 0x41505343;
+		constexpr uint32_t CacheVersion = 1;
+	}
+
+	std::optional<Array<MKL_INT>> PARDISOAnalysisCache::Find(uint64_t patternHash, size_t size) const noexcept
+	{
+		std::lock_guard lock(mutex);
+		const auto entry = entries.find(patternHash);
+		if (entry == entries.end() || entry->second.size() != size)
+		{
+			return std::nullopt;
+		}
+		return entry->second;
+	}
+
+	void PARDISOAnalysisCache::Store(uint64_t patternHash, const Array<MKL_INT>& permutation) noexcept
+	{
+		std::lock_guard lock(mutex);
+		entries.insert_or_assign(patternHash, permutation);
+	}
+
+	size_t PARDISOAnalysisCache::EntryCount() const noexcept
+	{
+		std::lock_guard lock(mutex);
+		return entries.size();
+	}
+
+	void PARDISOAnalysisCache::Save(const std::string& path) const noexcept
+	{
+		std::lock_guard lock(mutex);
+		auto stream = Serializer::OpenFileForWrite(path);
+		Serializer::Write(stream, CacheMagicNumber);
+		Serializer::Write(stream, CacheVersion);
+		Serializer::Write(stream, static_cast<uint32_t>(sizeof(MKL_INT)));
+		Serializer::Write(stream, entries.size());
+		for (const auto& [hash, permutation] : entries)
+		{
+			Serializer::Write(stream, hash);
+			Serializer::Write(stream, permutation.size());
+			stream.write(reinterpret_cast<const char*>(permutation.data()), permutation.size() * sizeof(MKL_INT));
+		}
+		Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::Serialization,
+			Format("PARDISO analysis cache with {} entries saved to {}.", entries.size(), path));
+	}
+
+	bool PARDISOAnalysisCache::Load(const std::string& path) noexcept
+	{
+		if (!Serializer::fs::exists(path))
+		{
+			Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::Serialization,
+				Format("PARDISO analysis cache file {} does not exist.", path));
+			return false;
+		}
+		auto stream = Serializer::OpenFileForRead(path);
+		if (Serializer::Read<uint32_t>(stream) != CacheMagicNumber || Serializer::Read<uint32_t>(stream) > CacheVersion
+			|| Serializer::Read<uint32_t>(stream) != sizeof(MKL_INT))
+		{
+			Logger::Log(MessageType::Warning, MessagePriority::High, MessageTag::Serialization,
+				Format("File {} is not compatible PARDISO analysis cache.", path));
+			return false;
+		}
+		const auto entryCount = Serializer::Read<size_t>(stream);
+		std::lock_guard lock(mutex);
+		for (size_t i = 0; i < entryCount && stream.good(); ++i)
+		{
+			const auto hash = Serializer::Read<uint64_t>(stream);
+			auto permutation = Array<MKL_INT>(Serializer::Read<size_t>(stream));
+			stream.read(reinterpret_cast<char*>(permutation.data()), permutation.size() * sizeof(MKL_INT));
+			if (stream.good())
+			{
+				entries.insert_or_assign(hash, std::move(permutation));
+			}
+		}
+		Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::Serialization,
+			Format("PARDISO analysis cache with {} entries loaded from {}.", entries.size(), path));
+		return stream.good();
+	}
+}
\ No newline at end of file
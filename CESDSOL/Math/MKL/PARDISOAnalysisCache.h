@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Math/Array.h"
+
+#include "mkl.h"
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace CESDSOL::MKL
+{
+	// Fill-reducing permutations computed by PARDISO analysis, keyed by pattern hash of the matrix. Solvers sharing the
+	// cache take the permutation for already seen pattern instead of repeating nested dissection reordering, which
+	// dominates analysis time for large problems. The cache can be shared between threads and saved to file to be
+	// reused by later runs; files are compatible only between builds with the same size of MKL_INT.
+	class PARDISOAnalysisCache
+	{
+	public:
+		[[nodiscard]] std::optional<Array<MKL_INT>> Find(uint64_t patternHash, size_t size) const noexcept;
+
+		void Store(uint64_t patternHash, const Array<MKL_INT>& permutation) noexcept;
+
+		[[nodiscard]] size_t EntryCount() const noexcept;
+
+		void Save(const std::string& path) const noexcept;
+
+		// Adds entries from the file to the cache, returns false if the file is absent or incompatible.
+		bool Load(const std::string& path) noexcept;
+
+	private:
+		mutable std::mutex mutex;
+		std::unordered_map<uint64_t, Array<MKL_INT>> entries;
+	};
+}
\ No newline at end of file
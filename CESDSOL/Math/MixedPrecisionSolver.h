@@ -0,0 +1,168 @@
+#pragma once
+
+#include "Math/CSRMatrixOperations.h"
+#include "Math/LinearAlgebra.h"
+#include "Math/LinearSolver.h"
+#include "Math/Native/SparseLU.h"
+#if MathLibrary == MKLMath
+#include "Math/MKL/PARDISO.h"
+#endif
+
+#include <chrono>
+#include <optional>
+#include <type_traits>
+
+namespace CESDSOL
+{
+	// Linear solver which factorizes the matrix in single precision and recovers double precision accuracy by
+	// iterative refinement: residual y - A x is computed in double precision with the original matrix, corrections are
+	// found with the single precision factorization, which is computed once per solve. Factors take half of the memory
+	// and are roughly twice faster to compute and apply, refinement converges in a few iterations while condition
+	// number of the matrix is well below 1e7. Inner solver either works with single precision copy of the matrix
+	// (e.g. MKL::PARDISO<f32>), or takes the matrix as is and stores factors in single precision
+	// (e.g. Native::SparseLU<MatrixType, f32>).
+	template<Concepts::CSRMatrix MatrixType, typename InnerMatrixType = MatrixType>
+	class MixedPrecisionSolver final
+		: public LinearSolver<MatrixType, Vector<double>>
+	{
+	public:
+		using VectorType = Vector<double>;
+		using InnerScalarType = typename InnerMatrixType::value_type;
+		using InnerVectorType = Vector<InnerScalarType>;
+		using InnerSolverType = LinearSolver<InnerMatrixType, InnerVectorType>;
+
+		MixedPrecisionSolver(uptr<InnerSolverType> aSolver) noexcept
+			: solver(std::move(aSolver))
+		{}
+
+		bool Solve(const MatrixType& matrix, const VectorType& y, VectorType& x) override
+		{
+			Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+				Format("Starting solving system of {} linear equations with mixed precision solver.", matrix.RowCount()));
+			std::chrono::high_resolution_clock clock;
+			const auto solutionStartTime = clock.now();
+			if (!Factorize(matrix) || !SolveFactorized(y, x))
+			{
+				return false;
+			}
+			Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+				Format("Linear system is solved by mixed precision solver in {}", clock.now() - solutionStartTime));
+			return true;
+		}
+
+		bool Factorize(const MatrixType& matrix) override
+		{
+			this->factorizedMatrix = &matrix;
+			if constexpr (IsConverted)
+			{
+				UpdateMatrix(matrix);
+				return solver->Factorize(*innerMatrix);
+			}
+			else
+			{
+				return solver->Factorize(matrix);
+			}
+		}
+
+		// Initial guess is ignored, as with direct solvers.
+		bool SolveFactorized(const VectorType& y, VectorType& x) override
+		{
+			const auto& matrix = *this->factorizedMatrix;
+			const size_t size = y.size();
+			if (residual.size() != size)
+			{
+				residual = VectorType(size);
+				innerRhs = InnerVectorType(size);
+				correction = InnerVectorType(size);
+			}
+			LinearAlgebra::Fill(x.data(), size, 0.);
+			LinearAlgebra::Copy(y.data(), residual.data(), size);
+			const double rhsNorm = LinearAlgebra::Norm2(y.data(), size);
+			double previousNorm = rhsNorm;
+			for (size_t iteration = 0;; ++iteration)
+			{
+				const double residualNorm = LinearAlgebra::Norm2(residual.data(), size);
+				if (residualNorm <= relativeTolerance * rhsNorm)
+				{
+					Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+						Format("Mixed precision refinement converged in {} iterations.", iteration));
+					return true;
+				}
+				if (iteration == maxIterationCount || (iteration > 1 && residualNorm > stagnationRatio * previousNorm))
+				{
+					Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::LinearSolver,
+						Format("Mixed precision refinement stopped after {} iterations with relative residual {}, the matrix "
+							"may be too ill-conditioned for single precision factorization.", iteration, residualNorm / rhsNorm));
+					return false;
+				}
+				previousNorm = residualNorm;
+
+				LinearAlgebra::Copy(residual.data(), innerRhs.data(), size);
+				LinearAlgebra::Fill(correction.data(), size, InnerScalarType(0));
+				if (!solver->SolveFactorized(innerRhs, correction))
+				{
+					return false;
+				}
+				LinearAlgebra::AXPY(1., correction.data(), x.data(), size);
+				LinearAlgebra::Copy(y.data(), residual.data(), size);
+				MVMultiply(matrix, x, residual, -1., 1.);
+			}
+		}
+
+	private:
+		static constexpr bool IsConverted = !std::is_same_v<MatrixType, InnerMatrixType>;
+
+		// Copies the matrix to inner precision, the pattern is copied only when it changes.
+		void UpdateMatrix(const MatrixType& matrix) noexcept
+		{
+			const auto hash = ComputePatternHash(matrix);
+			if (!innerMatrix || hash != patternHash)
+			{
+				innerMatrix.reset();
+				innerMatrix.emplace(matrix.RowCount(), matrix.ColumnCount(), matrix.NonZeroCount());
+				for (size_t row = 0; row < matrix.RowCount(); ++row)
+				{
+					innerMatrix->SetRowCount(row, matrix.GetRowCount(row));
+				}
+				ParallelFor(0, matrix.NonZeroCount(), [&](int64_t k)
+					{
+						innerMatrix->SetColumnIndex(k, matrix.GetColumnIndex(k));
+					});
+				patternHash = hash;
+			}
+			ParallelFor(0, matrix.NonZeroCount(), [&](int64_t k)
+				{
+					innerMatrix->SetValue(k, static_cast<InnerScalarType>(matrix.GetValue(k)));
+				});
+		}
+
+		uptr<InnerSolverType> solver;
+		// Kept in optional since MKL matrices release their handles only on destruction.
+		std::optional<InnerMatrixType> innerMatrix;
+		uint64_t patternHash = 0;
+
+		VectorType residual;
+		InnerVectorType innerRhs;
+		InnerVectorType correction;
+
+		MakeProperty(relativeTolerance, RelativeTolerance, double, 1e-10)
+		MakeProperty(maxIterationCount, MaxIterationCount, size_t, 10)
+		// Refinement is stopped when residual decreases slower than by this factor per iteration.
+		MakeProperty(stagnationRatio, StagnationRatio, double, 0.5)
+	};
+
+	// Creates mixed precision solver for the Jacobian of stationary problem: PARDISO with single precision factors
+	// in MKL build, sparse LU with single precision factors otherwise.
+	template<typename ProblemType>
+	[[nodiscard]] uptr<LinearSolver<typename ProblemType::JacobianMatrixType, Vector<double>>> MakeMixedPrecisionSolver(
+		const ProblemType& problem) noexcept
+	{
+		using MatrixType = typename ProblemType::JacobianMatrixType;
+
+#if MathLibrary == MKLMath
+		return std::make_unique<MixedPrecisionSolver<MatrixType, CSRMatrix<f32>>>(std::make_unique<MKL::PARDISO<f32>>());
+#else
+		return std::make_unique<MixedPrecisionSolver<MatrixType>>(std::make_unique<Native::SparseLU<MatrixType, f32>>());
+#endif
+	}
+}
\ No newline at end of file
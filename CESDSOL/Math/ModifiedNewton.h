@@ -36,6 +36,18 @@ namespace CESDSOL
 	private:
 		uptr<CurrentLinearSolver> linearSolver;
 		uptr<CurrentLineSearcher> lineSearcher;
+		const Vector<typename ProblemType::FieldType>* meritScales = nullptr;
+
+		[[nodiscard]] auto CalculateMerit(ProblemType& problem, const Vector<typename ProblemType::FieldType>& scales) const noexcept
+		{
+			if (scales.size() == 0)
+			{
+				return problem.GetMerit();
+			}
+			auto equations = problem.GetEquations().Flatten();
+			LinearAlgebra::Multiply(equations.data(), scales.data(), equations.data(), equations.size());
+			return problem.GetDescriptor().CalculateMerit(equations);
+		}
 		
 	public:		
 		MakeProperty(exitConditions, ExitConditions, MNExitConditions, MNExitConditions::MeritGoalReached
@@ -68,6 +80,15 @@ namespace CESDSOL
 			, lineSearcher(std::move(aLineSearcher))
 		{}
 
+		// Exit conditions use merit of equations multiplied by the given row scales, e.g. of EquilibratedSolver, so that
+		// equations of all fields contribute comparably. Scales must outlive the solver, empty scales are ignored. Scales
+		// are copied after the first linear solve and kept for the whole solution, so that merits of all iterations are
+		// comparable even if the linear solver recomputes them for every Jacobian.
+		void SetMeritScales(const Vector<typename ProblemType::FieldType>* scales) noexcept
+		{
+			meritScales = scales;
+		}
+
 		uptr<typename NonlinearSolver<ProblemType>::OutputInfo>
 			Solve(ProblemType& problem) const noexcept override
 		{
@@ -76,6 +97,7 @@ namespace CESDSOL
 			auto tmp = Vector<ValueType>(problem.DOFCount());
 			ValueType oldMerit = 0, oldSolutionNorm;
 			Vector<ValueType> oldSolution;
+			Vector<ValueType> frozenMeritScales;
 			std::chrono::high_resolution_clock clock;
 			size_t iterationCount = 0;
 
@@ -93,6 +115,10 @@ namespace CESDSOL
 						Format("Stopping modified Newton solution due to linear solver failure after {} iterations.", iterationCount + 1));
 					return std::make_unique<OutputInfo>(false, oldMerit, iterationCount);
 				}
+				if (iterationCount == 0 && meritScales != nullptr)
+				{
+					frozenMeritScales = *meritScales;
+				}
 
 				Scale(-1, tmp);
 				const auto result = lineSearcher->Solve(problem, tmp);
@@ -103,7 +129,7 @@ namespace CESDSOL
 					return std::make_unique<OutputInfo>(false, oldMerit, iterationCount);
 				}
 
-				const auto merit = problem.GetMerit();
+				const auto merit = CalculateMerit(problem, frozenMeritScales);
 				const auto solutionNorm = problem.CalculateSolutionNorm();
 				if (exitConditions & MNExitConditions::MeritGoalReached && merit < meritGoal)
 				{
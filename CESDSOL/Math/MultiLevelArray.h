@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <numeric>
 #include <span>
+#include <utility>
 
 namespace CESDSOL
 {
@@ -175,6 +176,13 @@ namespace CESDSOL
 			Flatten() = std::move(other);
 			return *this;
 		}
+
+		// Exchanges storage with the array in O(1), the array must have the same number of elements.
+		void Swap(Array<ScalarType>& other) noexcept
+		{
+			ShiftLevels(other.data() - Flatten().data());
+			std::swap(Flatten(), other);
+		}
 	};
 
 	template<typename ScalarType>
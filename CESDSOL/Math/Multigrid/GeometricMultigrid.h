@@ -0,0 +1,305 @@
+#pragma once
+
+#include "Grid/DirectProductGrid.h"
+#include "Math/Multigrid/Multigrid.h"
+
+#include <functional>
+
+namespace CESDSOL
+{
+	// Geometric multigrid on direct product grids. Coarse grids are made by taking every other point along each
+	// axis which is long enough, prolongation is the tensor product of one-dimensional linear interpolations
+	// applied to every continuous field, discrete variables are passed between levels as is. Coarse operators
+	// are Galerkin products unless coarse operator provider is set, in which case it is expected to return
+	// operator rediscretized on the given coarse grid (for example, Jacobian of the same problem on this grid). Rows of
+	// such operators are scaled by their inverse norms when row scaling of the finest operator is on.
+	template<typename MatrixType, size_t Dimension, typename CoordinateType = double>
+	class GeometricMultigrid final
+		: public MultigridPreconditioner<MatrixType>
+	{
+	private:
+		using Base = MultigridPreconditioner<MatrixType>;
+		using typename Base::TransferMatrixType;
+		using AxisGrids = std::array<SingleDimensionalGrid<CoordinateType>, Dimension>;
+
+	public:
+		using GridType = DirectProductGrid<Dimension, CoordinateType>;
+		using CoarseOperatorProvider = std::function<MatrixType(size_t levelIndex, const GridType& grid)>;
+
+		GeometricMultigrid(const GridType& grid, size_t aFieldCount, size_t aDiscreteVariableCount = 0) noexcept
+			: fieldCount(aFieldCount)
+			, discreteVariableCount(aDiscreteVariableCount)
+		{
+			for (size_t i = 0; i < Dimension; ++i)
+			{
+				fineGrids[i] = { grid.GetGrid(i), grid.GetPeriod(i) };
+			}
+		}
+
+		void SetCoarseOperatorProvider(CoarseOperatorProvider aProvider) noexcept
+		{
+			provider = std::move(aProvider);
+		}
+
+	protected:
+		bool UpdateHierarchy(const MatrixType& matrix) noexcept override
+		{
+			if (this->levels.size() > 0)
+			{
+				return true;
+			}
+
+			auto grids = Array<AxisGrids>(maxLevelCount);
+			grids[0] = fineGrids;
+			size_t levelCount = 1;
+			while (levelCount < maxLevelCount && DOFCount(grids[levelCount - 1]) > coarseSizeLimit)
+			{
+				bool coarsened = false;
+				for (size_t axis = 0; axis < Dimension; ++axis)
+				{
+					const auto& fine = grids[levelCount - 1][axis];
+					if (fine.points.size() >= minimalCoarsenedAxisSize)
+					{
+						grids[levelCount][axis] = { CoarsenAxis(fine), fine.period };
+						coarsened = true;
+					}
+					else
+					{
+						grids[levelCount][axis] = fine;
+					}
+				}
+				if (!coarsened)
+				{
+					break;
+				}
+				++levelCount;
+			}
+
+			if (matrix.RowCount() != DOFCount(fineGrids))
+			{
+				Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+					"Matrix size is incompatible with the grid passed to geometric multigrid.");
+				return false;
+			}
+
+			this->levels = Array<typename Base::Level>(levelCount);
+			coarseGrids = Array<sptr<GridType>>(levelCount);
+			for (size_t levelIndex = 0; levelIndex < levelCount; ++levelIndex)
+			{
+				auto& level = this->levels[levelIndex];
+				level.pointCount = PointCount(grids[levelIndex]);
+				level.fieldCount = fieldCount;
+				if (levelIndex + 1 < levelCount)
+				{
+					level.prolongation = MakeProlongation(grids[levelIndex], grids[levelIndex + 1]);
+					level.restriction = Native::TransposeCSR<TransferMatrixType>(level.prolongation);
+				}
+				if (levelIndex > 0 && provider)
+				{
+					coarseGrids[levelIndex] = std::make_shared<GridType>(AxisGrids(grids[levelIndex]));
+				}
+			}
+			return true;
+		}
+
+		[[nodiscard]] MatrixType MakeCoarseOperator(size_t levelIndex) noexcept override
+		{
+			if (provider)
+			{
+				auto result = provider(levelIndex, *coarseGrids[levelIndex]);
+				this->ScaleCoarseRows(result);
+				return result;
+			}
+			return Base::MakeCoarseOperator(levelIndex);
+		}
+
+	private:
+		[[nodiscard]] static size_t PointCount(const AxisGrids& grids) noexcept
+		{
+			size_t result = 1;
+			for (const auto& grid : grids)
+			{
+				result *= grid.points.size();
+			}
+			return result;
+		}
+
+		[[nodiscard]] size_t DOFCount(const AxisGrids& grids) const noexcept
+		{
+			return PointCount(grids) * fieldCount + discreteVariableCount;
+		}
+
+		// Keeps points with even indices and the last point of non-periodic axis.
+		[[nodiscard]] static Vector<CoordinateType> CoarsenAxis(const SingleDimensionalGrid<CoordinateType>& grid) noexcept
+		{
+			const size_t size = grid.points.size();
+			const bool keepLast = !grid.period.has_value() && size % 2 == 0;
+			auto result = Vector<CoordinateType>((size + 1) / 2 + (keepLast ? 1 : 0));
+			for (size_t i = 0; i < (size + 1) / 2; ++i)
+			{
+				result[i] = grid.points[2 * i];
+			}
+			if (keepLast)
+			{
+				result[result.size() - 1] = grid.points[size - 1];
+			}
+			return result;
+		}
+
+		struct InterpolationStencil
+		{
+			std::array<size_t, 2> indices;
+			std::array<double, 2> weights;
+			size_t size;
+		};
+
+		// Linear interpolation weights of fine points by coarse points of one axis.
+		[[nodiscard]] static Array<InterpolationStencil> MakeAxisInterpolation(const SingleDimensionalGrid<CoordinateType>& fine,
+			const SingleDimensionalGrid<CoordinateType>& coarse) noexcept
+		{
+			const size_t fineSize = fine.points.size();
+			const size_t coarseSize = coarse.points.size();
+			auto result = Array<InterpolationStencil>(fineSize);
+			if (fineSize == coarseSize)
+			{
+				for (size_t i = 0; i < fineSize; ++i)
+				{
+					result[i] = { { i, 0 }, { 1., 0. }, 1 };
+				}
+				return result;
+			}
+
+			size_t left = 0;
+			for (size_t i = 0; i < fineSize; ++i)
+			{
+				while (left + 1 < coarseSize && coarse.points[left + 1] <= fine.points[i])
+				{
+					++left;
+				}
+				if (coarse.points[left] == fine.points[i])
+				{
+					result[i] = { { left, 0 }, { 1., 0. }, 1 };
+					continue;
+				}
+				size_t right = left + 1;
+				CoordinateType rightPoint;
+				if (right < coarseSize)
+				{
+					rightPoint = coarse.points[right];
+				}
+				else
+				{
+					right = 0;
+					rightPoint = coarse.points[0] + *fine.period;
+				}
+				const double t = static_cast<double>((fine.points[i] - coarse.points[left]) / (rightPoint - coarse.points[left]));
+				result[i] = { { left, right }, { 1. - t, t }, 2 };
+			}
+			return result;
+		}
+
+		[[nodiscard]] TransferMatrixType MakeProlongation(const AxisGrids& fine, const AxisGrids& coarse) const noexcept
+		{
+			std::array<Array<InterpolationStencil>, Dimension> stencils;
+			for (size_t axis = 0; axis < Dimension; ++axis)
+			{
+				stencils[axis] = MakeAxisInterpolation(fine[axis], coarse[axis]);
+			}
+
+			const size_t finePointCount = PointCount(fine);
+			const size_t coarsePointCount = PointCount(coarse);
+			auto pointRowLengths = Array<size_t>(finePointCount + 1);
+			ParallelFor(0, finePointCount, [&](int64_t point)
+				{
+					size_t length = 1;
+					size_t remainder = point;
+					for (size_t axis = Dimension; axis-- > 0;)
+					{
+						length *= stencils[axis][remainder % fine[axis].points.size()].size;
+						remainder /= fine[axis].points.size();
+					}
+					pointRowLengths[point + 1] = length;
+				});
+			for (size_t i = 0; i < finePointCount; ++i)
+			{
+				pointRowLengths[i + 1] += pointRowLengths[i];
+			}
+
+			const size_t pointNonZeroCount = pointRowLengths[finePointCount];
+			auto result = TransferMatrixType(finePointCount * fieldCount + discreteVariableCount,
+				coarsePointCount * fieldCount + discreteVariableCount, pointNonZeroCount * fieldCount + discreteVariableCount);
+			ParallelFor(0, finePointCount, [&](int64_t point)
+				{
+					std::array<const InterpolationStencil*, Dimension> pointStencils;
+					size_t remainder = point;
+					for (size_t axis = Dimension; axis-- > 0;)
+					{
+						pointStencils[axis] = &stencils[axis][remainder % fine[axis].points.size()];
+						remainder /= fine[axis].points.size();
+					}
+
+					const size_t length = pointRowLengths[point + 1] - pointRowLengths[point];
+					for (size_t entry = 0; entry < length; ++entry)
+					{
+						size_t column = 0;
+						double weight = 1;
+						size_t code = entry;
+						for (size_t axis = Dimension; axis-- > 0;)
+						{
+							const auto& stencil = *pointStencils[axis];
+							const size_t local = code % stencil.size;
+							code /= stencil.size;
+							weight *= stencil.weights[local];
+							size_t stride = 1;
+							for (size_t inner = axis + 1; inner < Dimension; ++inner)
+							{
+								stride *= coarse[inner].points.size();
+							}
+							column += stencil.indices[local] * stride;
+						}
+						for (size_t field = 0; field < fieldCount; ++field)
+						{
+							const size_t position = field * pointNonZeroCount + pointRowLengths[point] + entry;
+							result.SetColumnIndex(position, field * coarsePointCount + column);
+							result.SetValue(position, weight);
+						}
+					}
+					for (size_t field = 0; field < fieldCount; ++field)
+					{
+						result.SetRowCount(field * finePointCount + point, field * pointNonZeroCount + pointRowLengths[point]);
+					}
+				});
+			for (size_t i = 0; i < discreteVariableCount; ++i)
+			{
+				const size_t position = pointNonZeroCount * fieldCount + i;
+				result.SetRowCount(finePointCount * fieldCount + i, position);
+				result.SetColumnIndex(position, coarsePointCount * fieldCount + i);
+				result.SetValue(position, 1.);
+			}
+			return result;
+		}
+
+		AxisGrids fineGrids;
+		Array<sptr<GridType>> coarseGrids;
+		CoarseOperatorProvider provider;
+		size_t fieldCount;
+		size_t discreteVariableCount;
+
+		MakeProperty(maxLevelCount, MaximumLevelCount, size_t, 20)
+		MakeProperty(coarseSizeLimit, CoarseSizeLimit, size_t, 1000)
+		MakeProperty(minimalCoarsenedAxisSize, MinimalCoarsenedAxisSize, size_t, 5)
+	};
+
+	template<typename ProblemType>
+	[[nodiscard]] auto MakeGeometricMultigrid(const ProblemType& problem)
+	{
+		using GridType = DirectProductGrid<ProblemType::Dimension, typename ProblemType::CoordinateType>;
+		using MultigridType = GeometricMultigrid<typename ProblemType::JacobianMatrixType, ProblemType::Dimension,
+			typename ProblemType::CoordinateType>;
+
+		const auto* grid = dynamic_cast<const GridType*>(&problem.GetGrid());
+		AssertE(grid != nullptr, MessageTag::Preconditioner, "Geometric multigrid requires problem on direct product grid.");
+		return std::make_unique<MultigridType>(*grid, problem.GetDescriptor().ContinuousEquationCount(),
+			problem.GetDescriptor().DiscreteEquationCount());
+	}
+}
\ No newline at end of file
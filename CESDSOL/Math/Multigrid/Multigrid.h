@@ -0,0 +1,515 @@
+#pragma once
+
+#include "Math/LinearAlgebra.h"
+#include "Math/LinearSolver.h"
+#include "Math/Native/FusedVectorOperations.h"
+#include "Math/Preconditioner.h"
+#include "Utils/Parallelism/Parallelism.h"
+
+#include <cmath>
+
+namespace CESDSOL
+{
+	enum class MultigridCycle
+	{
+		V,
+		W,
+		F
+	};
+
+	// Dense LU factorization with partial pivoting, used as the coarsest level solver.
+	class DenseLU
+	{
+	public:
+		template<Concepts::CSRMatrix MatrixType>
+		bool Factorize(const MatrixType& matrix) noexcept
+		{
+			size = matrix.RowCount();
+			factors = Array<double>(size * size);
+			pivots = Array<size_t>(size);
+			for (size_t i = 0; i < size; ++i)
+			{
+				for (size_t k = matrix.GetRowCount(i); k < matrix.GetRowCount(i + 1); ++k)
+				{
+					factors[i * size + matrix.GetColumnIndex(k)] += matrix.GetValue(k);
+				}
+			}
+
+			for (size_t j = 0; j < size; ++j)
+			{
+				size_t pivot = j;
+				for (size_t i = j + 1; i < size; ++i)
+				{
+					if (std::abs(factors[i * size + j]) > std::abs(factors[pivot * size + j]))
+					{
+						pivot = i;
+					}
+				}
+				pivots[j] = pivot;
+				if (factors[pivot * size + j] == 0)
+				{
+					return false;
+				}
+				if (pivot != j)
+				{
+					std::swap_ranges(factors.begin() + j * size, factors.begin() + (j + 1) * size, factors.begin() + pivot * size);
+				}
+				const auto inversePivot = 1. / factors[j * size + j];
+				ParallelFor(j + 1, size, [&](int64_t i)
+					{
+						auto* row = factors.data() + i * size;
+						const auto* pivotRow = factors.data() + j * size;
+						row[j] *= inversePivot;
+						const auto multiplier = row[j];
+						for (size_t k = j + 1; k < size; ++k)
+						{
+							row[k] -= multiplier * pivotRow[k];
+						}
+					});
+			}
+			return true;
+		}
+
+		void Solve(const Vector<double>& y, Vector<double>& x) const noexcept
+		{
+			Native::Copy(y.data(), x.data(), size);
+			for (size_t j = 0; j < size; ++j)
+			{
+				std::swap(x[j], x[pivots[j]]);
+			}
+			for (size_t i = 0; i < size; ++i)
+			{
+				for (size_t k = 0; k < i; ++k)
+				{
+					x[i] -= factors[i * size + k] * x[k];
+				}
+			}
+			for (size_t i = size; i-- > 0;)
+			{
+				for (size_t k = i + 1; k < size; ++k)
+				{
+					x[i] -= factors[i * size + k] * x[k];
+				}
+				x[i] /= factors[i * size + i];
+			}
+		}
+
+	private:
+		Array<double> factors;
+		Array<size_t> pivots;
+		size_t size = 0;
+	};
+
+	// Damped Jacobi smoother with blocks coupling all fields at a single point. Unknowns are expected in field-major
+	// order: first fieldCount * pointCount continuous unknowns, then discrete ones, which are smoothed pointwise.
+	class PointBlockJacobiSmoother
+	{
+	public:
+		template<Concepts::CSRMatrix MatrixType>
+		void Setup(const MatrixType& matrix, size_t aPointCount, size_t aFieldCount) noexcept
+		{
+			pointCount = aPointCount;
+			fieldCount = aFieldCount;
+			discreteCount = matrix.RowCount() - pointCount * fieldCount;
+			const size_t blockSize = fieldCount * fieldCount;
+			blockInverses = Array<double>(pointCount * blockSize);
+			discreteInverses = Array<double>(discreteCount);
+
+			ParallelBlock([&]()
+				{
+					auto block = Array<double>(blockSize);
+					ForInParallelBlock(0, pointCount, [&](int64_t point)
+						{
+							std::fill(block.begin(), block.end(), 0.);
+							for (size_t a = 0; a < fieldCount; ++a)
+							{
+								const size_t row = a * pointCount + point;
+								for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+								{
+									const size_t column = matrix.GetColumnIndex(k);
+									if (column < pointCount * fieldCount && column % pointCount == static_cast<size_t>(point))
+									{
+										block[a * fieldCount + column / pointCount] += matrix.GetValue(k);
+									}
+								}
+							}
+							InvertBlock(block, blockInverses.data() + point * blockSize);
+						});
+				});
+			for (size_t i = 0; i < discreteCount; ++i)
+			{
+				const size_t row = pointCount * fieldCount + i;
+				double diagonal = 0;
+				for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+				{
+					if (matrix.GetColumnIndex(k) == row)
+					{
+						diagonal += matrix.GetValue(k);
+					}
+				}
+				discreteInverses[i] = diagonal != 0 ? 1. / diagonal : 0.;
+			}
+		}
+
+		// x += damping * B^-1 * r.
+		void Apply(const Vector<double>& r, Vector<double>& x, double damping) const noexcept
+		{
+			const size_t blockSize = fieldCount * fieldCount;
+			ParallelFor(0, pointCount, [&](int64_t point)
+				{
+					const auto* inverse = blockInverses.data() + point * blockSize;
+					for (size_t a = 0; a < fieldCount; ++a)
+					{
+						double sum = 0;
+						for (size_t b = 0; b < fieldCount; ++b)
+						{
+							sum += inverse[a * fieldCount + b] * r[b * pointCount + point];
+						}
+						x[a * pointCount + point] += damping * sum;
+					}
+				});
+			const size_t offset = pointCount * fieldCount;
+			for (size_t i = 0; i < discreteCount; ++i)
+			{
+				x[offset + i] += damping * discreteInverses[i] * r[offset + i];
+			}
+		}
+
+	private:
+		// Gauss-Jordan inversion, falls back to the inverse of the diagonal for singular blocks.
+		void InvertBlock(Array<double>& block, double* inverse) const noexcept
+		{
+			const size_t n = fieldCount;
+			for (size_t i = 0; i < n; ++i)
+			{
+				for (size_t j = 0; j < n; ++j)
+				{
+					inverse[i * n + j] = i == j ? 1. : 0.;
+				}
+			}
+			auto diagonal = Array<double>(n);
+			for (size_t i = 0; i < n; ++i)
+			{
+				diagonal[i] = block[i * n + i];
+			}
+
+			for (size_t j = 0; j < n; ++j)
+			{
+				size_t pivot = j;
+				for (size_t i = j + 1; i < n; ++i)
+				{
+					if (std::abs(block[i * n + j]) > std::abs(block[pivot * n + j]))
+					{
+						pivot = i;
+					}
+				}
+				if (block[pivot * n + j] == 0)
+				{
+					for (size_t i = 0; i < n; ++i)
+					{
+						for (size_t k = 0; k < n; ++k)
+						{
+							inverse[i * n + k] = i == k && diagonal[i] != 0 ? 1. / diagonal[i] : 0.;
+						}
+					}
+					return;
+				}
+				for (size_t k = 0; k < n; ++k)
+				{
+					std::swap(block[j * n + k], block[pivot * n + k]);
+					std::swap(inverse[j * n + k], inverse[pivot * n + k]);
+				}
+				const auto inversePivot = 1. / block[j * n + j];
+				for (size_t k = 0; k < n; ++k)
+				{
+					block[j * n + k] *= inversePivot;
+					inverse[j * n + k] *= inversePivot;
+				}
+				for (size_t i = 0; i < n; ++i)
+				{
+					if (i != j)
+					{
+						const auto multiplier = block[i * n + j];
+						for (size_t k = 0; k < n; ++k)
+						{
+							block[i * n + k] -= multiplier * block[j * n + k];
+							inverse[i * n + k] -= multiplier * inverse[j * n + k];
+						}
+					}
+				}
+			}
+		}
+
+		Array<double> blockInverses;
+		Array<double> discreteInverses;
+		size_t pointCount = 0;
+		size_t fieldCount = 0;
+		size_t discreteCount = 0;
+	};
+
+	// Base class for multigrid preconditioners. Derived classes build grid transfer operators, this class
+	// computes Galerkin coarse operators R * A * P with R = P^T, sets up smoothers and performs cycles.
+	template<typename MatrixType>
+	class MultigridPreconditioner : public Preconditioner<MatrixType, Vector<double>>
+	{
+	public:
+		using TransferMatrixType = Native::CSRMatrix<double, size_t, 0>;
+
+		bool Setup(const MatrixType& matrix, const Vector<double>& y) noexcept override
+		{
+			const auto* fineMatrix = &matrix;
+			if (rowScaling)
+			{
+				ScaleRows(matrix);
+				fineMatrix = &scaledMatrix;
+			}
+			if (!UpdateHierarchy(*fineMatrix))
+			{
+				Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+					"Failed to build multigrid hierarchy.");
+				return false;
+			}
+
+			levels[0].matrix = fineMatrix;
+			for (size_t levelIndex = 0; levelIndex < levels.size(); ++levelIndex)
+			{
+				auto& level = levels[levelIndex];
+				if (levelIndex > 0 && !level.isOperatorActual)
+				{
+					level.ownedMatrix = MakeCoarseOperator(levelIndex);
+					level.matrix = &level.ownedMatrix;
+				}
+				level.isOperatorActual = false;
+				level.smoother.Setup(*level.matrix, level.pointCount, level.fieldCount);
+				const size_t size = level.matrix->RowCount();
+				if (level.residual.size() != size)
+				{
+					level.residual = Vector<double>(size);
+					level.rhs = Vector<double>(size);
+					level.solution = Vector<double>(size);
+				}
+			}
+
+			const auto& coarsest = *levels[levels.size() - 1].matrix;
+			useCoarseLU = false;
+			if (coarseSolver == nullptr && coarsest.RowCount() <= denseCoarseSizeLimit)
+			{
+				useCoarseLU = coarseLU.Factorize(coarsest);
+				if (!useCoarseLU)
+				{
+					Logger::Log(MessageType::Warning, MessagePriority::High, MessageTag::Preconditioner,
+						"Coarsest multigrid operator is singular, smoothing will be used instead.");
+				}
+			}
+			Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::Preconditioner,
+				Format("Multigrid hierarchy has {} levels, coarsest level has {} unknowns.", levels.size(), coarsest.RowCount()));
+			return true;
+		}
+
+		bool Solve(const MatrixType& matrix, const Vector<double>& y, Vector<double>& x) override
+		{
+			std::fill(x.begin(), x.end(), 0.);
+			const auto* rhs = &y;
+			if (rowScaling)
+			{
+				LinearAlgebra::Multiply(rowScales.data(), y.data(), scaledRhs.data(), y.size());
+				rhs = &scaledRhs;
+			}
+			for (size_t i = 0; i < cycleCount; ++i)
+			{
+				if (!RunCycle(0, *rhs, x, cycle))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void SetCoarseSolver(uptr<LinearSolver<MatrixType, Vector<double>>> aCoarseSolver) noexcept
+		{
+			coarseSolver = std::move(aCoarseSolver);
+		}
+
+		[[nodiscard]] size_t LevelCount() const noexcept
+		{
+			return levels.size();
+		}
+
+	protected:
+		struct Level
+		{
+			const MatrixType* matrix = nullptr;
+			MatrixType ownedMatrix;
+			// Interpolation from the next coarser level to this one and its transpose.
+			TransferMatrixType prolongation;
+			TransferMatrixType restriction;
+			PointBlockJacobiSmoother smoother;
+			size_t pointCount = 0;
+			size_t fieldCount = 0;
+			Vector<double> residual;
+			Vector<double> rhs;
+			Vector<double> solution;
+			// Set by derived classes which compute coarse operator while building hierarchy.
+			bool isOperatorActual = false;
+		};
+
+		// Creates levels with pointCount, fieldCount and transfer operators set. The finest level is levels[0]
+		// and matrix is its (possibly scaled) operator.
+		virtual bool UpdateHierarchy(const MatrixType& matrix) noexcept = 0;
+
+		[[nodiscard]] virtual MatrixType MakeCoarseOperator(size_t levelIndex) noexcept
+		{
+			const auto& fine = levels[levelIndex - 1];
+			return Native::MultiplyCSR<MatrixType>(fine.restriction,
+				Native::MultiplyCSR<TransferMatrixType>(*fine.matrix, fine.prolongation));
+		}
+
+		// Scales rows of coarse operator which is not computed from the finest one in the same way as rows of the
+		// finest operator are scaled, so that all levels of the hierarchy describe the same scaled system.
+		void ScaleCoarseRows(MatrixType& matrix) const noexcept
+		{
+			if (!rowScaling)
+			{
+				return;
+			}
+			ParallelFor(0, matrix.RowCount(), [&](int64_t row)
+				{
+					const double scale = GetInverseRowNorm(matrix, row);
+					for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+					{
+						matrix.SetValue(k, scale * matrix.GetValue(k));
+					}
+				});
+		}
+
+		Array<Level> levels;
+
+	private:
+		[[nodiscard]] static double GetInverseRowNorm(const MatrixType& matrix, size_t row) noexcept
+		{
+			double norm = 0;
+			for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+			{
+				norm = std::max(norm, std::abs(static_cast<double>(matrix.GetValue(k))));
+			}
+			return norm > 0 ? 1. / norm : 1.;
+		}
+
+		// Finest level operator is scaled by inverse row norms, so that rows of equations with different scales
+		// (for example, boundary conditions and differential equations with 1 / h^2 coefficients) are balanced
+		// before coarse operators are built.
+		void ScaleRows(const MatrixType& matrix) noexcept
+		{
+			const size_t size = matrix.RowCount();
+			const auto hash = ComputePatternHash(matrix);
+			if (hash != scaledPatternHash)
+			{
+				scaledMatrix = matrix;
+				scaledPatternHash = hash;
+				rowScales = Vector<double>(size);
+				scaledRhs = Vector<double>(size);
+			}
+			ParallelFor(0, size, [&](int64_t row)
+				{
+					rowScales[row] = GetInverseRowNorm(matrix, row);
+					for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+					{
+						scaledMatrix.SetValue(k, rowScales[row] * matrix.GetValue(k));
+					}
+				});
+		}
+
+		void Smooth(Level& level, const Vector<double>& b, Vector<double>& x, size_t stepCount) const noexcept
+		{
+			for (size_t step = 0; step < stepCount; ++step)
+			{
+				ComputeResidual(level, b, x);
+				level.smoother.Apply(level.residual, x, smootherDamping);
+			}
+		}
+
+		void ComputeResidual(Level& level, const Vector<double>& b, const Vector<double>& x) const noexcept
+		{
+			MVMultiply(*level.matrix, x, level.residual, 1., 0.);
+			Native::AXPBY(1., b.data(), -1., level.residual.data(), b.size());
+		}
+
+		bool RunCycle(size_t levelIndex, const Vector<double>& b, Vector<double>& x, MultigridCycle type)
+		{
+			auto& level = levels[levelIndex];
+			if (levelIndex + 1 == levels.size())
+			{
+				return SolveCoarsest(level, b, x);
+			}
+
+			Smooth(level, b, x, preSmoothingSteps);
+			ComputeResidual(level, b, x);
+
+			auto& coarse = levels[levelIndex + 1];
+			const auto& restriction = level.restriction;
+			Native::CSRMVMultiply(restriction.GetRowCounts().data(), restriction.GetColumnIndices().data(),
+				restriction.GetValues().data(), restriction.StartingIndex, restriction.RowCount(),
+				level.residual.data(), coarse.rhs.data(), 1., 0.);
+			std::fill(coarse.solution.begin(), coarse.solution.end(), 0.);
+
+			bool success = true;
+			switch (type)
+			{
+			case MultigridCycle::V:
+				success = RunCycle(levelIndex + 1, coarse.rhs, coarse.solution, MultigridCycle::V);
+				break;
+			case MultigridCycle::W:
+				success = RunCycle(levelIndex + 1, coarse.rhs, coarse.solution, MultigridCycle::W)
+					&& RunCycle(levelIndex + 1, coarse.rhs, coarse.solution, MultigridCycle::W);
+				break;
+			case MultigridCycle::F:
+				success = RunCycle(levelIndex + 1, coarse.rhs, coarse.solution, MultigridCycle::F)
+					&& RunCycle(levelIndex + 1, coarse.rhs, coarse.solution, MultigridCycle::V);
+				break;
+			}
+			if (!success)
+			{
+				return false;
+			}
+
+			const auto& prolongation = level.prolongation;
+			Native::CSRMVMultiply(prolongation.GetRowCounts().data(), prolongation.GetColumnIndices().data(),
+				prolongation.GetValues().data(), prolongation.StartingIndex, prolongation.RowCount(),
+				coarse.solution.data(), x.data(), 1., 1.);
+			Smooth(level, b, x, postSmoothingSteps);
+			return true;
+		}
+
+		bool SolveCoarsest(Level& level, const Vector<double>& b, Vector<double>& x)
+		{
+			if (coarseSolver != nullptr)
+			{
+				return coarseSolver->Solve(*level.matrix, b, x);
+			}
+			if (useCoarseLU)
+			{
+				coarseLU.Solve(b, x);
+				return true;
+			}
+			Smooth(level, b, x, coarseSmoothingSteps);
+			return true;
+		}
+
+		uptr<LinearSolver<MatrixType, Vector<double>>> coarseSolver;
+		MatrixType scaledMatrix;
+		uint64_t scaledPatternHash = 0;
+		Vector<double> rowScales;
+		Vector<double> scaledRhs;
+		DenseLU coarseLU;
+		bool useCoarseLU = false;
+
+		MakeProperty(cycle, Cycle, MultigridCycle, MultigridCycle::V)
+		MakeProperty(cycleCount, CycleCount, size_t, 1)
+		MakeProperty(preSmoothingSteps, PreSmoothingSteps, size_t, 2)
+		MakeProperty(postSmoothingSteps, PostSmoothingSteps, size_t, 2)
+		MakeProperty(coarseSmoothingSteps, CoarseSmoothingSteps, size_t, 20)
+		MakeProperty(smootherDamping, SmootherDamping, double, 0.7)
+		MakeProperty(denseCoarseSizeLimit, DenseCoarseSizeLimit, size_t, 2000)
+		MakeProperty(rowScaling, RowScaling, bool, true)
+	};
+}
\ No newline at end of file
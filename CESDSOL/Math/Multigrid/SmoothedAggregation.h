@@ -0,0 +1,386 @@
+#pragma once
+
+#include "Math/Multigrid/Multigrid.h"
+
+namespace CESDSOL
+{
+	// Smoothed aggregation algebraic multigrid. Unknowns are grouped into points as in field-major Jacobians of
+	// problems (fieldCount continuous fields over pointCount points followed by discrete variables). Points are
+	// aggregated by strength of their coupling blocks, near-nullspace is spanned by constant vectors of every
+	// field, so each aggregate gives one coarse unknown per field. Discrete variables are kept on all levels
+	// as is. Tentative prolongation is smoothed by one damped Jacobi step with damping 4 / (3 * rho(D^-1 * A)).
+	// Hierarchy is reused while sparsity pattern of matrix does not change, in which case only coarse operators
+	// are recomputed on setup.
+	template<typename MatrixType>
+	class SmoothedAggregation final
+		: public MultigridPreconditioner<MatrixType>
+	{
+	private:
+		using Base = MultigridPreconditioner<MatrixType>;
+		using typename Base::TransferMatrixType;
+
+	public:
+		SmoothedAggregation(size_t aFieldCount = 1, size_t aDiscreteVariableCount = 0) noexcept
+			: fieldCount(aFieldCount)
+			, discreteVariableCount(aDiscreteVariableCount)
+		{}
+
+	protected:
+		bool UpdateHierarchy(const MatrixType& matrix) noexcept override
+		{
+			if (matrix.RowCount() < discreteVariableCount || (matrix.RowCount() - discreteVariableCount) % fieldCount != 0)
+			{
+				Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+					"Matrix size is incompatible with field count passed to smoothed aggregation.");
+				return false;
+			}
+
+			const auto hash = ComputePatternHash(matrix);
+			if (reuseHierarchy && hash == patternHash && this->levels.size() > 0)
+			{
+				return true;
+			}
+			patternHash = hash;
+
+			Array<typename Base::Level> levels(maxLevelCount);
+			levels[0].matrix = &matrix;
+			levels[0].pointCount = (matrix.RowCount() - discreteVariableCount) / fieldCount;
+			levels[0].fieldCount = fieldCount;
+			size_t levelCount = 1;
+			while (levelCount < maxLevelCount)
+			{
+				auto& fine = levels[levelCount - 1];
+				if (fine.matrix->RowCount() <= coarseSizeLimit)
+				{
+					break;
+				}
+
+				size_t aggregateCount;
+				const auto aggregates = Aggregate(*fine.matrix, fine.pointCount, fine.fieldCount, aggregateCount);
+				if (aggregateCount == 0 || aggregateCount > maxCoarseningRatio * fine.pointCount)
+				{
+					break;
+				}
+
+				const auto tentative = MakeTentativeProlongation(aggregates, aggregateCount, fine.pointCount, fine.fieldCount);
+				fine.prolongation = SmoothProlongation(*fine.matrix, tentative, fine.pointCount * fine.fieldCount);
+				fine.restriction = Native::TransposeCSR<TransferMatrixType>(fine.prolongation);
+
+				auto& coarse = levels[levelCount];
+				coarse.pointCount = aggregateCount;
+				coarse.fieldCount = fine.fieldCount;
+				coarse.ownedMatrix = Native::MultiplyCSR<MatrixType>(fine.restriction,
+					Native::MultiplyCSR<TransferMatrixType>(*fine.matrix, fine.prolongation));
+				coarse.matrix = &coarse.ownedMatrix;
+				coarse.isOperatorActual = true;
+				++levelCount;
+			}
+
+			this->levels = Array<typename Base::Level>(levelCount);
+			for (size_t i = 0; i < levelCount; ++i)
+			{
+				std::swap(this->levels[i], levels[i]);
+				if (i > 0)
+				{
+					this->levels[i].matrix = &this->levels[i].ownedMatrix;
+				}
+			}
+			this->levels[levelCount - 1].prolongation = TransferMatrixType();
+			this->levels[levelCount - 1].restriction = TransferMatrixType();
+			return true;
+		}
+
+	private:
+		// Returns aggregate index for every point, uses the classical three phase greedy algorithm over the graph
+		// of strongly coupled points.
+		[[nodiscard]] Array<size_t> Aggregate(const MatrixType& matrix, size_t pointCount, size_t blockSize,
+			size_t& aggregateCount) const noexcept
+		{
+			const size_t continuousSize = pointCount * blockSize;
+			auto diagonal = Array<double>(pointCount);
+			auto graphRowLengths = Array<size_t>(pointCount + 1);
+
+			// Point coupling strength is the sum of absolute values of all entries of the coupling block.
+			const auto forEachCoupling = [&](size_t point, auto&& body)
+			{
+				for (size_t field = 0; field < blockSize; ++field)
+				{
+					const size_t row = field * pointCount + point;
+					for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+					{
+						const size_t column = matrix.GetColumnIndex(k);
+						if (column < continuousSize)
+						{
+							body(column % pointCount, std::abs(matrix.GetValue(k)));
+						}
+					}
+				}
+			};
+			ParallelFor(0, pointCount, [&](int64_t point)
+				{
+					forEachCoupling(point, [&](size_t neighbour, double value)
+						{
+							if (neighbour == static_cast<size_t>(point))
+							{
+								diagonal[point] += value;
+							}
+						});
+				});
+
+			// Accumulator is zero for all points outside of the call, visited neighbours are marked by sign change.
+			const auto forEachStrongNeighbour = [&](size_t point, Array<double>& accumulator, auto&& body)
+			{
+				forEachCoupling(point, [&](size_t neighbour, double value)
+					{
+						if (neighbour != point)
+						{
+							accumulator[neighbour] += value;
+						}
+					});
+				forEachCoupling(point, [&](size_t neighbour, double)
+					{
+						if (accumulator[neighbour] > 0)
+						{
+							if (accumulator[neighbour] > strengthThreshold * std::sqrt(diagonal[point] * diagonal[neighbour]))
+							{
+								body(neighbour);
+							}
+							accumulator[neighbour] = -accumulator[neighbour];
+						}
+					});
+				forEachCoupling(point, [&](size_t neighbour, double)
+					{
+						accumulator[neighbour] = 0;
+					});
+			};
+			ParallelBlock([&]()
+				{
+					auto accumulator = Array<double>(pointCount);
+					ForInParallelBlock(0, pointCount, [&](int64_t point)
+						{
+							size_t length = 0;
+							forEachStrongNeighbour(point, accumulator, [&](size_t) { ++length; });
+							graphRowLengths[point + 1] = length;
+						});
+				});
+			for (size_t i = 0; i < pointCount; ++i)
+			{
+				graphRowLengths[i + 1] += graphRowLengths[i];
+			}
+			auto graphColumns = Array<size_t>(graphRowLengths[pointCount]);
+			ParallelBlock([&]()
+				{
+					auto accumulator = Array<double>(pointCount);
+					ForInParallelBlock(0, pointCount, [&](int64_t point)
+						{
+							size_t position = graphRowLengths[point];
+							forEachStrongNeighbour(point, accumulator, [&](size_t neighbour) { graphColumns[position++] = neighbour; });
+						});
+				});
+
+			constexpr size_t Unaggregated = std::numeric_limits<size_t>::max();
+			auto result = Array<size_t>(Unaggregated, pointCount);
+			aggregateCount = 0;
+			for (size_t point = 0; point < pointCount; ++point)
+			{
+				if (result[point] != Unaggregated || graphRowLengths[point + 1] == graphRowLengths[point])
+				{
+					continue;
+				}
+				bool isFree = true;
+				for (size_t k = graphRowLengths[point]; k < graphRowLengths[point + 1] && isFree; ++k)
+				{
+					isFree = result[graphColumns[k]] == Unaggregated;
+				}
+				if (isFree)
+				{
+					result[point] = aggregateCount;
+					for (size_t k = graphRowLengths[point]; k < graphRowLengths[point + 1]; ++k)
+					{
+						result[graphColumns[k]] = aggregateCount;
+					}
+					++aggregateCount;
+				}
+			}
+
+			auto firstPhase = Array<size_t>(result);
+			for (size_t point = 0; point < pointCount; ++point)
+			{
+				if (result[point] != Unaggregated)
+				{
+					continue;
+				}
+				for (size_t k = graphRowLengths[point]; k < graphRowLengths[point + 1]; ++k)
+				{
+					if (firstPhase[graphColumns[k]] != Unaggregated)
+					{
+						result[point] = firstPhase[graphColumns[k]];
+						break;
+					}
+				}
+			}
+
+			for (size_t point = 0; point < pointCount; ++point)
+			{
+				if (result[point] != Unaggregated)
+				{
+					continue;
+				}
+				result[point] = aggregateCount;
+				for (size_t k = graphRowLengths[point]; k < graphRowLengths[point + 1]; ++k)
+				{
+					if (result[graphColumns[k]] == Unaggregated)
+					{
+						result[graphColumns[k]] = aggregateCount;
+					}
+				}
+				++aggregateCount;
+			}
+			return result;
+		}
+
+		// Piecewise constant interpolation from aggregates for every field, columns are orthonormal.
+		[[nodiscard]] TransferMatrixType MakeTentativeProlongation(const Array<size_t>& aggregates, size_t aggregateCount,
+			size_t pointCount, size_t blockSize) const noexcept
+		{
+			auto aggregateSizes = Array<size_t>(aggregateCount);
+			for (const auto aggregate : aggregates)
+			{
+				++aggregateSizes[aggregate];
+			}
+
+			const size_t continuousSize = pointCount * blockSize;
+			auto result = TransferMatrixType(continuousSize + discreteVariableCount,
+				aggregateCount * blockSize + discreteVariableCount, continuousSize + discreteVariableCount);
+			ParallelFor(0, continuousSize, [&](int64_t row)
+				{
+					const size_t field = row / pointCount;
+					const size_t aggregate = aggregates[row % pointCount];
+					result.SetRowCount(row, row);
+					result.SetColumnIndex(row, field * aggregateCount + aggregate);
+					result.SetValue(row, 1. / std::sqrt(static_cast<double>(aggregateSizes[aggregate])));
+				});
+			for (size_t i = 0; i < discreteVariableCount; ++i)
+			{
+				result.SetRowCount(continuousSize + i, continuousSize + i);
+				result.SetColumnIndex(continuousSize + i, aggregateCount * blockSize + i);
+				result.SetValue(continuousSize + i, 1.);
+			}
+			return result;
+		}
+
+		// P = (I - omega * D^-1 * A) * T, smoothing is restricted to continuous unknowns, so that coupling with
+		// discrete variables does not produce dense columns. Rows of discrete variables are not smoothed and stay
+		// identity injections.
+		[[nodiscard]] TransferMatrixType SmoothProlongation(const MatrixType& matrix, const TransferMatrixType& tentative,
+			size_t continuousSize) const noexcept
+		{
+			const size_t size = matrix.RowCount();
+			auto inverseDiagonal = Array<double>(size);
+			auto rowLengths = Array<size_t>(size + 1);
+			ParallelFor(0, size, [&](int64_t row)
+				{
+					size_t length = 1;
+					for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+					{
+						const size_t column = matrix.GetColumnIndex(k);
+						if (column == static_cast<size_t>(row))
+						{
+							if (static_cast<size_t>(row) < continuousSize)
+							{
+								inverseDiagonal[row] += matrix.GetValue(k);
+							}
+						}
+						else if (static_cast<size_t>(row) < continuousSize && column < continuousSize)
+						{
+							++length;
+						}
+					}
+					inverseDiagonal[row] = inverseDiagonal[row] != 0 ? 1. / inverseDiagonal[row] : 0.;
+					rowLengths[row + 1] = length;
+				});
+			for (size_t i = 0; i < size; ++i)
+			{
+				rowLengths[i + 1] += rowLengths[i];
+			}
+
+			// Scaled operator D^-1 * A restricted to continuous unknowns, diagonal entry goes first in every row.
+			auto scaled = TransferMatrixType(size, size, rowLengths[size]);
+			ParallelFor(0, size, [&](int64_t row)
+				{
+					size_t position = rowLengths[row];
+					scaled.SetRowCount(row, position);
+					scaled.SetColumnIndex(position, row);
+					scaled.SetValue(position++, 0.);
+					for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+					{
+						const size_t column = matrix.GetColumnIndex(k);
+						if (column == static_cast<size_t>(row))
+						{
+							scaled.SetValue(rowLengths[row], scaled.GetValue(rowLengths[row]) + inverseDiagonal[row] * matrix.GetValue(k));
+						}
+						else if (static_cast<size_t>(row) < continuousSize && column < continuousSize)
+						{
+							scaled.SetColumnIndex(position, column);
+							scaled.SetValue(position++, inverseDiagonal[row] * matrix.GetValue(k));
+						}
+					}
+				});
+
+			const double omega = 4. / (3. * EstimateSpectralRadius(scaled));
+			ParallelFor(0, size, [&](int64_t row)
+				{
+					for (size_t k = rowLengths[row]; k < rowLengths[row + 1]; ++k)
+					{
+						const double value = -omega * scaled.GetValue(k);
+						scaled.SetValue(k, k == rowLengths[row] ? 1. + value : value);
+					}
+				});
+			return Native::MultiplyCSR<TransferMatrixType>(scaled, tentative);
+		}
+
+		[[nodiscard]] double EstimateSpectralRadius(const TransferMatrixType& matrix) const noexcept
+		{
+			const size_t size = matrix.RowCount();
+			auto x = Vector<double>(size);
+			auto y = Vector<double>(size);
+			for (size_t i = 0; i < size; ++i)
+			{
+				x[i] = 1. + static_cast<double>(i % 7) / 7.;
+			}
+			double radius = 1;
+			for (size_t iteration = 0; iteration < powerIterationCount; ++iteration)
+			{
+				const double norm = Native::ParallelNorm2(x.data(), size);
+				if (norm == 0)
+				{
+					break;
+				}
+				Native::ParallelScale(1. / norm, x.data(), size);
+				Native::CSRMVMultiply(matrix.GetRowCounts().data(), matrix.GetColumnIndices().data(), matrix.GetValues().data(),
+					matrix.StartingIndex, size, x.data(), y.data(), 1., 0.);
+				radius = Native::ParallelNorm2(y.data(), size);
+				std::swap(x, y);
+			}
+			return radius > 0 ? radius : 1.;
+		}
+
+		size_t fieldCount;
+		size_t discreteVariableCount;
+		uint64_t patternHash = 0;
+
+		MakeProperty(maxLevelCount, MaximumLevelCount, size_t, 20)
+		MakeProperty(coarseSizeLimit, CoarseSizeLimit, size_t, 1000)
+		MakeProperty(strengthThreshold, StrengthThreshold, double, 0.08)
+		MakeProperty(maxCoarseningRatio, MaximumCoarseningRatio, double, 0.8)
+		MakeProperty(powerIterationCount, PowerIterationCount, size_t, 10)
+		MakeProperty(reuseHierarchy, ReuseHierarchy, bool, true)
+	};
+
+	template<typename ProblemType>
+	[[nodiscard]] auto MakeSmoothedAggregation(const ProblemType& problem)
+	{
+		return std::make_unique<SmoothedAggregation<typename ProblemType::JacobianMatrixType>>(
+			problem.GetDescriptor().ContinuousEquationCount(), problem.GetDescriptor().DiscreteEquationCount());
+	}
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "Math/Array.h"
+#include "Math/Concepts.h"
+#include "Utils/Parallelism/Parallelism.h"
+#include "Utils/Utils.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace CESDSOL::Native
+{
+	// Sparse matrix in block CSR format with square dense blocks stored row by row. Pattern is taken from CSR matrix
+	// with row and column counts divisible by block size, entries missing in blocks are stored as zeros.
+	template<typename ScalarType>
+	class BSRMatrix
+	{
+	public:
+		using value_type = ScalarType;
+		using size_type = size_t;
+
+		BSRMatrix() noexcept = default;
+
+		template<Concepts::CSRMatrix MatrixType>
+		BSRMatrix(const MatrixType& A, size_t aBlockSize) noexcept
+			: blockSize(aBlockSize)
+			, blockRowCount(A.RowCount() / aBlockSize)
+			, blockColumnCount(A.ColumnCount() / aBlockSize)
+		{
+			AssertE(blockSize > 0 && A.RowCount() % blockSize == 0 && A.ColumnCount() % blockSize == 0, MessageTag::Math,
+				"Matrix size is not divisible by block size.");
+			std::vector<size_t> columns;
+			std::vector<size_t> rowColumns;
+			rowStarts = Array<size_t>(blockRowCount + 1);
+			for (size_t blockRow = 0; blockRow < blockRowCount; ++blockRow)
+			{
+				rowColumns.clear();
+				for (size_t row = blockRow * blockSize; row < (blockRow + 1) * blockSize; ++row)
+				{
+					for (size_t k = A.GetRowCount(row); k < A.GetRowCount(row + 1); ++k)
+					{
+						rowColumns.push_back(A.GetColumnIndex(k) / blockSize);
+					}
+				}
+				std::sort(rowColumns.begin(), rowColumns.end());
+				rowColumns.erase(std::unique(rowColumns.begin(), rowColumns.end()), rowColumns.end());
+				columns.insert(columns.end(), rowColumns.begin(), rowColumns.end());
+				rowStarts[blockRow + 1] = columns.size();
+			}
+			blockColumns = Array<size_t>(columns.size(), columns.data());
+			values = Array<ScalarType>(columns.size() * blockSize * blockSize);
+
+			entryPositions = Array<size_t>(A.NonZeroCount());
+			ParallelFor(0, blockRowCount,
+				[&](int64_t blockRow)
+				{
+					const auto* rowBegin = blockColumns.data() + rowStarts[blockRow];
+					const auto* rowEnd = blockColumns.data() + rowStarts[blockRow + 1];
+					for (size_t row = blockRow * blockSize; row < (blockRow + 1) * blockSize; ++row)
+					{
+						for (size_t k = A.GetRowCount(row); k < A.GetRowCount(row + 1); ++k)
+						{
+							const size_t column = A.GetColumnIndex(k);
+							const size_t block = std::lower_bound(rowBegin, rowEnd, column / blockSize) - blockColumns.data();
+							entryPositions[k] = (block * blockSize + row % blockSize) * blockSize + column % blockSize;
+						}
+					}
+				});
+			UpdateValues(A);
+		}
+
+		[[nodiscard]] size_t RowCount() const noexcept
+		{
+			return blockRowCount * blockSize;
+		}
+
+		[[nodiscard]] size_t ColumnCount() const noexcept
+		{
+			return blockColumnCount * blockSize;
+		}
+
+		[[nodiscard]] size_t BlockSize() const noexcept
+		{
+			return blockSize;
+		}
+
+		[[nodiscard]] size_t BlockRowCount() const noexcept
+		{
+			return blockRowCount;
+		}
+
+		[[nodiscard]] size_t BlockCount() const noexcept
+		{
+			return blockColumns.size();
+		}
+
+		[[nodiscard]] size_t GetBlockRowStart(size_t blockRow) const noexcept
+		{
+			return rowStarts[blockRow];
+		}
+
+		[[nodiscard]] size_t GetBlockColumn(size_t block) const noexcept
+		{
+			return blockColumns[block];
+		}
+
+		[[nodiscard]] const ScalarType* GetBlock(size_t block) const noexcept
+		{
+			return values.data() + block * blockSize * blockSize;
+		}
+
+		[[nodiscard]] ScalarType* GetBlock(size_t block) noexcept
+		{
+			return values.data() + block * blockSize * blockSize;
+		}
+
+		// Refills values from CSR matrix with the same pattern as the one BSR matrix was constructed from.
+		template<Concepts::CSRMatrix MatrixType>
+		void UpdateValues(const MatrixType& A) noexcept
+		{
+			AssertE(A.NonZeroCount() == entryPositions.size(), MessageTag::Math, "Trying to update BSR matrix with different pattern.");
+			ParallelFor(0, entryPositions.size(),
+				[&](int64_t k)
+				{
+					values[entryPositions[k]] = A.GetValue(k);
+				});
+		}
+
+		template<Concepts::Vector XVectorType, Concepts::Vector YVectorType>
+		void Apply(const XVectorType& x, YVectorType& y) const noexcept
+		{
+			AssertE(x.size() == ColumnCount() && y.size() == RowCount(), MessageTag::Math,
+				"Trying to multiply matrix and vector with incompatible sizes.");
+			const auto* xData = x.data();
+			auto* yData = y.data();
+			ParallelFor(0, blockRowCount,
+				[&](int64_t blockRow)
+				{
+					auto* target = yData + blockRow * blockSize;
+					std::fill(target, target + blockSize, typename YVectorType::value_type(0));
+					for (size_t block = rowStarts[blockRow]; block < rowStarts[blockRow + 1]; ++block)
+					{
+						const auto* blockValues = GetBlock(block);
+						const auto* source = xData + blockColumns[block] * blockSize;
+						for (size_t r = 0; r < blockSize; ++r)
+						{
+							for (size_t c = 0; c < blockSize; ++c)
+							{
+								target[r] += blockValues[r * blockSize + c] * source[c];
+							}
+						}
+					}
+				});
+		}
+
+	private:
+		size_t blockSize = 1;
+		size_t blockRowCount = 0;
+		size_t blockColumnCount = 0;
+		Array<size_t> rowStarts;
+		Array<size_t> blockColumns;
+		Array<ScalarType> values;
+		// Position of every entry of the source CSR matrix.
+		Array<size_t> entryPositions;
+	};
+}
\ No newline at end of file
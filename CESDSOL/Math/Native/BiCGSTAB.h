@@ -0,0 +1,180 @@
+#pragma once
+
+#include "Math/LinearAlgebra.h"
+#include "Math/LinearOperator.h"
+#include "Math/LinearSolver.h"
+#include "Math/Native/FusedVectorOperations.h"
+#include "Math/Preconditioner.h"
+#include "Math/TunedSparseOperator.h"
+
+#include <cmath>
+
+namespace CESDSOL::Native
+{
+	// Right preconditioned BiCGSTAB. Vector updates are fused with the reductions that follow them,
+	// so every iteration makes four passes over the vectors besides operator and preconditioner applications.
+	// Products with CSR matrices use tuned storage format.
+	template<typename OperatorType, typename ScalarType = f64>
+	class BiCGSTAB final
+		: public LinearSolver<OperatorType, Vector<ScalarType>>
+	{
+	public:
+		using VectorType = Vector<ScalarType>;
+
+		BiCGSTAB(uptr<Preconditioner<OperatorType, VectorType>> aPreconditioner = nullptr)
+			: preconditioner(std::move(aPreconditioner))
+		{}
+
+		bool Solve(const OperatorType& A, const VectorType& y, VectorType& x) override
+		{
+			const size_t size = y.size();
+			AssertE(x.size() == size, MessageTag::LinearSolver, "Solution and right hand side sizes differ in BiCGSTAB.");
+			Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::LinearSolver,
+				Format("Starting solving system of {} linear equations with native BiCGSTAB.", size));
+
+			if (preconditioner != nullptr && !preconditioner->Setup(A, y))
+			{
+				Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::LinearSolver,
+					"Failed to setup preconditioner for BiCGSTAB.");
+				return false;
+			}
+			systemOperator.Update(A, operatorTuning);
+			Allocate(size);
+
+			const ScalarType rhsNorm = ParallelNorm2(y.data(), size);
+			const ScalarType target = std::max<ScalarType>(relativeTolerance * rhsNorm, absoluteTolerance);
+
+			systemOperator.Apply(A, x, r);
+			ScalarType residualNorm = std::sqrt(AXPYZSquaredNorm(ScalarType(-1), r.data(), y.data(), r.data(), size));
+			Copy(r.data(), shadowResidual.data(), size);
+			std::fill(p.begin(), p.end(), ScalarType(0));
+			std::fill(v.begin(), v.end(), ScalarType(0));
+
+			ScalarType rho = 1;
+			ScalarType alpha = 1;
+			ScalarType omega = 1;
+			ScalarType rhoNew = residualNorm * residualNorm;
+
+			size_t iterationCount = 0;
+			while (residualNorm > target && iterationCount < iterationLimit)
+			{
+				if (std::abs(rhoNew) <= breakdownTolerance * rhsNorm * rhsNorm)
+				{
+					Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::LinearSolver,
+						"BiCGSTAB stopped due to breakdown in shadow residual!");
+					return false;
+				}
+				const ScalarType beta = (rhoNew / rho) * (alpha / omega);
+				rho = rhoNew;
+				XPAYPBZ(r.data(), beta, p.data(), -beta * omega, v.data(), size);
+
+				if (!ApplyPreconditioner(A, p, preconditionedP))
+				{
+					return false;
+				}
+				systemOperator.Apply(A, preconditionedP, v);
+				alpha = rho / ParallelDotProduct(shadowResidual.data(), v.data(), size);
+
+				const ScalarType sNorm = std::sqrt(AXPYZSquaredNorm(-alpha, v.data(), r.data(), s.data(), size));
+				++iterationCount;
+				if (sNorm <= target)
+				{
+					AXPY(alpha, preconditionedP.data(), x.data(), size);
+					residualNorm = sNorm;
+					break;
+				}
+
+				if (!ApplyPreconditioner(A, s, preconditionedS))
+				{
+					return false;
+				}
+				systemOperator.Apply(A, preconditionedS, t);
+				const auto [tt, ts] = DotProducts(t.data(), t.data(), t.data(), s.data(), size);
+				if (tt == 0)
+				{
+					Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::LinearSolver,
+						"BiCGSTAB stopped due to division by zero!");
+					return false;
+				}
+				omega = ts / tt;
+				DoubleAXPY(alpha, preconditionedP.data(), omega, preconditionedS.data(), x.data(), size);
+
+				const auto [rr, r0r] = AXPYZDotProducts(-omega, t.data(), s.data(), r.data(), shadowResidual.data(), size);
+				residualNorm = std::sqrt(rr);
+				rhoNew = r0r;
+				if (omega == 0)
+				{
+					Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::LinearSolver,
+						"BiCGSTAB stopped due to stagnation!");
+					return false;
+				}
+			}
+
+			if (residualNorm > target)
+			{
+				Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::LinearSolver,
+					"BiCGSTAB reached iteration limit, but relative tolerance was not satisfied!");
+				return true;
+			}
+			Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::LinearSolver,
+				Format("BiCGSTAB solved linear system in {} iterations.", iterationCount));
+			return true;
+		}
+
+		void SetPreconditioner(uptr<Preconditioner<OperatorType, VectorType>> aPreconditioner) noexcept
+		{
+			preconditioner = std::move(aPreconditioner);
+		}
+
+	private:
+		void Allocate(size_t size) noexcept
+		{
+			if (r.size() != size)
+			{
+				r = VectorType(size);
+				shadowResidual = VectorType(size);
+				p = VectorType(size);
+				v = VectorType(size);
+				s = VectorType(size);
+				t = VectorType(size);
+				preconditionedP = VectorType(size);
+				preconditionedS = VectorType(size);
+			}
+		}
+
+		bool ApplyPreconditioner(const OperatorType& A, const VectorType& in, VectorType& out)
+		{
+			if (preconditioner == nullptr)
+			{
+				Copy(in.data(), out.data(), in.size());
+				return true;
+			}
+			if (!preconditioner->Solve(A, in, out))
+			{
+				Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::LinearSolver,
+					"Failed to apply preconditioner in BiCGSTAB.");
+				return false;
+			}
+			return true;
+		}
+
+		uptr<Preconditioner<OperatorType, VectorType>> preconditioner;
+		IterativeSolverOperator<OperatorType, VectorType> systemOperator;
+
+		VectorType r;
+		VectorType shadowResidual;
+		VectorType p;
+		VectorType v;
+		VectorType s;
+		VectorType t;
+		VectorType preconditionedP;
+		VectorType preconditionedS;
+
+		MakeProperty(iterationLimit, IterationLimit, size_t, 500)
+		MakeProperty(relativeTolerance, RelativeTolerance, ScalarType, 1e-6)
+		MakeProperty(absoluteTolerance, AbsoluteTolerance, ScalarType, 0)
+		MakeProperty(breakdownTolerance, BreakdownTolerance, ScalarType, 1e-30)
+		// If true, CSR matrix is copied to the storage format with the fastest product, see IterativeSolverOperator.
+		MakeProperty(operatorTuning, OperatorTuning, bool, true)
+	};
+}
\ No newline at end of file
@@ -0,0 +1,239 @@
+#pragma once
+
+#include "Math/LinearAlgebra.h"
+#include "Math/Native/BSRMatrix.h"
+#include "Math/Preconditioner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace CESDSOL::Native
+{
+	// Incomplete block LU factorization without fill for matrices in block CSR format. Factors share the pattern of
+	// the matrix, dense diagonal blocks of U are stored inverted, so both triangular solves only multiply blocks.
+	// For multi-field problems in point-major ordering blocks couple all fields at a point, which makes the
+	// factorization considerably more robust than scalar ILU(0) of the same matrix.
+	template<typename ScalarType = f64>
+	class BlockILU0 final
+		: public Preconditioner<BSRMatrix<ScalarType>, Vector<ScalarType>>
+	{
+	public:
+		using MatrixType = BSRMatrix<ScalarType>;
+		using VectorType = Vector<ScalarType>;
+
+		bool Setup(const MatrixType& matrix, const VectorType& y) noexcept override
+		{
+			blockSize = matrix.BlockSize();
+			const size_t blockRowCount = matrix.BlockRowCount();
+			const size_t blockArea = blockSize * blockSize;
+			values = Array<ScalarType>(matrix.BlockCount() * blockArea, matrix.GetBlock(0));
+			diagonalPositions = Array<size_t>(blockRowCount);
+			for (size_t row = 0; row < blockRowCount; ++row)
+			{
+				const auto position = FindBlock(matrix, row, row);
+				if (position == None)
+				{
+					Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+						"Error in block ILU(0) preconditioner calculation: the matrix has no diagonal block.");
+					return false;
+				}
+				diagonalPositions[row] = position;
+			}
+
+			auto product = Array<ScalarType>(blockArea);
+			auto pivot = Array<ScalarType>(blockArea);
+			for (size_t row = 0; row < blockRowCount; ++row)
+			{
+				const size_t rowEnd = matrix.GetBlockRowStart(row + 1);
+				for (size_t k = matrix.GetBlockRowStart(row); k < diagonalPositions[row]; ++k)
+				{
+					const size_t pivotRow = matrix.GetBlockColumn(k);
+					// L_ik = A_ik * U_kk^-1.
+					std::copy(GetBlock(k), GetBlock(k) + blockArea, pivot.data());
+					MultiplyBlocks(pivot.data(), GetBlock(diagonalPositions[pivotRow]), GetBlock(k));
+					// A_ij -= L_ik * U_kj for j present in both rows.
+					size_t position = k + 1;
+					for (size_t l = diagonalPositions[pivotRow] + 1; l < matrix.GetBlockRowStart(pivotRow + 1); ++l)
+					{
+						const size_t column = matrix.GetBlockColumn(l);
+						while (position < rowEnd && matrix.GetBlockColumn(position) < column)
+						{
+							++position;
+						}
+						if (position == rowEnd)
+						{
+							break;
+						}
+						if (matrix.GetBlockColumn(position) == column)
+						{
+							MultiplyBlocks(GetBlock(k), GetBlock(l), product.data());
+							auto* target = GetBlock(position);
+							for (size_t i = 0; i < blockArea; ++i)
+							{
+								target[i] -= product[i];
+							}
+						}
+					}
+				}
+				if (!InvertBlock(GetBlock(diagonalPositions[row])))
+				{
+					Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+						Format("Error in block ILU(0) preconditioner calculation: diagonal block {} is singular.", row));
+					return false;
+				}
+			}
+			Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::Preconditioner,
+				Format("Block ILU(0) preconditioner with {}x{} blocks was successfully calculated.", blockSize, blockSize));
+			return true;
+		}
+
+		bool Solve(const MatrixType& matrix, const VectorType& y, VectorType& x) override
+		{
+			const size_t blockRowCount = matrix.BlockRowCount();
+			auto sum = Array<ScalarType>(blockSize);
+			for (size_t row = 0; row < blockRowCount; ++row)
+			{
+				auto* target = x.data() + row * blockSize;
+				std::copy(y.data() + row * blockSize, y.data() + (row + 1) * blockSize, target);
+				for (size_t k = matrix.GetBlockRowStart(row); k < diagonalPositions[row]; ++k)
+				{
+					SubtractProduct(GetBlock(k), x.data() + matrix.GetBlockColumn(k) * blockSize, target);
+				}
+			}
+			for (size_t row = blockRowCount; row-- > 0;)
+			{
+				auto* target = x.data() + row * blockSize;
+				for (size_t k = diagonalPositions[row] + 1; k < matrix.GetBlockRowStart(row + 1); ++k)
+				{
+					SubtractProduct(GetBlock(k), x.data() + matrix.GetBlockColumn(k) * blockSize, target);
+				}
+				std::fill(sum.begin(), sum.end(), ScalarType(0));
+				const auto* inverse = GetBlock(diagonalPositions[row]);
+				for (size_t i = 0; i < blockSize; ++i)
+				{
+					for (size_t j = 0; j < blockSize; ++j)
+					{
+						sum[i] += inverse[i * blockSize + j] * target[j];
+					}
+				}
+				std::copy(sum.begin(), sum.end(), target);
+			}
+			return true;
+		}
+
+	private:
+		static constexpr size_t None = std::numeric_limits<size_t>::max();
+
+		[[nodiscard]] static size_t FindBlock(const MatrixType& matrix, size_t row, size_t column) noexcept
+		{
+			for (size_t k = matrix.GetBlockRowStart(row); k < matrix.GetBlockRowStart(row + 1); ++k)
+			{
+				if (matrix.GetBlockColumn(k) == column)
+				{
+					return k;
+				}
+			}
+			return None;
+		}
+
+		[[nodiscard]] ScalarType* GetBlock(size_t block) noexcept
+		{
+			return values.data() + block * blockSize * blockSize;
+		}
+
+		// result = left * right for row-major blocks.
+		void MultiplyBlocks(const ScalarType* left, const ScalarType* right, ScalarType* result) const noexcept
+		{
+			for (size_t i = 0; i < blockSize; ++i)
+			{
+				auto* resultRow = result + i * blockSize;
+				std::fill(resultRow, resultRow + blockSize, ScalarType(0));
+				for (size_t k = 0; k < blockSize; ++k)
+				{
+					const auto factor = left[i * blockSize + k];
+					for (size_t j = 0; j < blockSize; ++j)
+					{
+						resultRow[j] += factor * right[k * blockSize + j];
+					}
+				}
+			}
+		}
+
+		// target -= block * x.
+		void SubtractProduct(const ScalarType* block, const ScalarType* x, ScalarType* target) const noexcept
+		{
+			for (size_t i = 0; i < blockSize; ++i)
+			{
+				for (size_t j = 0; j < blockSize; ++j)
+				{
+					target[i] -= block[i * blockSize + j] * x[j];
+				}
+			}
+		}
+
+		// Inverts block in place by Gauss-Jordan elimination with partial pivoting.
+		bool InvertBlock(ScalarType* block) const noexcept
+		{
+			auto columns = Array<size_t>(blockSize);
+			for (size_t step = 0; step < blockSize; ++step)
+			{
+				size_t pivotRow = step;
+				for (size_t i = step + 1; i < blockSize; ++i)
+				{
+					if (std::abs(block[i * blockSize + step]) > std::abs(block[pivotRow * blockSize + step]))
+					{
+						pivotRow = i;
+					}
+				}
+				if (std::abs(block[pivotRow * blockSize + step]) <= zeroPivotThreshold)
+				{
+					return false;
+				}
+				columns[step] = pivotRow;
+				if (pivotRow != step)
+				{
+					std::swap_ranges(block + step * blockSize, block + (step + 1) * blockSize, block + pivotRow * blockSize);
+				}
+				const auto pivotInverse = ScalarType(1) / block[step * blockSize + step];
+				block[step * blockSize + step] = ScalarType(1);
+				for (size_t j = 0; j < blockSize; ++j)
+				{
+					block[step * blockSize + j] *= pivotInverse;
+				}
+				for (size_t i = 0; i < blockSize; ++i)
+				{
+					if (i != step)
+					{
+						const auto factor = block[i * blockSize + step];
+						block[i * blockSize + step] = ScalarType(0);
+						for (size_t j = 0; j < blockSize; ++j)
+						{
+							block[i * blockSize + j] -= factor * block[step * blockSize + j];
+						}
+					}
+				}
+			}
+			// Row swaps of the matrix become column swaps of the inverse, applied in reverse order.
+			for (size_t step = blockSize; step-- > 0;)
+			{
+				if (columns[step] != step)
+				{
+					for (size_t i = 0; i < blockSize; ++i)
+					{
+						std::swap(block[i * blockSize + step], block[i * blockSize + columns[step]]);
+					}
+				}
+			}
+			return true;
+		}
+
+		size_t blockSize = 1;
+		// Factors in the layout of the matrix blocks, diagonal blocks of U are inverted.
+		Array<ScalarType> values;
+		Array<size_t> diagonalPositions;
+
+		MakeProperty(zeroPivotThreshold, ZeroPivotThreshold, double, 1e-300)
+	};
+}
\ No newline at end of file
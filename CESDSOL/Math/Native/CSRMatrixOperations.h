@@ -0,0 +1,265 @@
+#pragma once
+
+#include "Math/Concepts.h"
+#include "Math/CSRMatrix.h"
+#include "Utils/Aliases.h"
+#include "Utils/Parallelism/Parallelism.h"
+#include "Utils/Utils.h"
+
+#include <algorithm>
+#include <concepts>
+#include <limits>
+
+namespace CESDSOL::Native
+{
+	template<typename MatrixType>
+	concept NativeCSRMatrix = std::same_as<MatrixType, 
+		CSRMatrix<typename MatrixType::value_type, typename MatrixType::index_type, MatrixType::StartingIndex>>;
+
+	// y = alpha * A * x + beta * y over raw CSR arrays, rows are distributed between threads.
+	template<typename ScalarType, typename IndexType, typename XScalarType, typename YScalarType, typename AlphaType>
+	void CSRMVMultiply(const IndexType* rowCounts, const IndexType* columnIndices, const ScalarType* values, 
+		IndexType startingIndex, size_t rowCount, const XScalarType* x, YScalarType* y, AlphaType alpha, AlphaType beta) noexcept
+	{
+		ParallelFor(0, rowCount, [&](int64_t row)
+			{
+				YScalarType sum = 0;
+				for (auto index = rowCounts[row] - startingIndex; index < rowCounts[row + 1] - startingIndex; ++index)
+				{
+					sum += values[index] * x[columnIndices[index] - startingIndex];
+				}
+				y[row] = beta == AlphaType(0) ? alpha * sum : alpha * sum + beta * y[row];
+			});
+	}
+
+	// Returns A^T in arbitrary CSR format.
+	template<Concepts::CSRMatrix ResultMatrixType, Concepts::CSRMatrix MatrixType>
+	[[nodiscard]] ResultMatrixType TransposeCSR(const MatrixType& A) noexcept
+	{
+		const size_t rowCount = A.RowCount();
+		const size_t columnCount = A.ColumnCount();
+		auto offsets = Array<size_t>(columnCount + 1);
+		for (size_t k = 0; k < A.NonZeroCount(); ++k)
+		{
+			++offsets[A.GetColumnIndex(k) + 1];
+		}
+		for (size_t i = 0; i < columnCount; ++i)
+		{
+			offsets[i + 1] += offsets[i];
+		}
+
+		auto result = ResultMatrixType(columnCount, rowCount, A.NonZeroCount());
+		for (size_t i = 0; i < columnCount; ++i)
+		{
+			result.SetRowCount(i, offsets[i]);
+		}
+		for (size_t i = 0; i < rowCount; ++i)
+		{
+			for (size_t k = A.GetRowCount(i); k < A.GetRowCount(i + 1); ++k)
+			{
+				const auto position = offsets[A.GetColumnIndex(k)]++;
+				result.SetColumnIndex(position, i);
+				result.SetValue(position, A.GetValue(k));
+			}
+		}
+		return result;
+	}
+
+	// Returns A * B in arbitrary CSR format. Column indices of the result are sorted within each row.
+	template<Concepts::CSRMatrix ResultMatrixType, Concepts::CSRMatrix AMatrixType, Concepts::CSRMatrix BMatrixType>
+	[[nodiscard]] ResultMatrixType MultiplyCSR(const AMatrixType& A, const BMatrixType& B) noexcept
+	{
+		AssertE(A.ColumnCount() == B.RowCount(), MessageTag::Math, "Trying to multiply matrices with incompatible sizes.");
+
+		using ScalarType = typename ResultMatrixType::value_type;
+		const size_t rowCount = A.RowCount();
+		const size_t columnCount = B.ColumnCount();
+		auto rowLengths = Array<size_t>(rowCount + 1);
+
+		ParallelBlock([&]()
+			{
+				auto marker = Array<size_t>(std::numeric_limits<size_t>::max(), columnCount);
+				ForInParallelBlock(0, rowCount, [&](int64_t i)
+					{
+						size_t length = 0;
+						for (size_t ka = A.GetRowCount(i); ka < A.GetRowCount(i + 1); ++ka)
+						{
+							const size_t j = A.GetColumnIndex(ka);
+							for (size_t kb = B.GetRowCount(j); kb < B.GetRowCount(j + 1); ++kb)
+							{
+								const size_t column = B.GetColumnIndex(kb);
+								if (marker[column] != static_cast<size_t>(i))
+								{
+									marker[column] = i;
+									++length;
+								}
+							}
+						}
+						rowLengths[i + 1] = length;
+					});
+			});
+		for (size_t i = 0; i < rowCount; ++i)
+		{
+			rowLengths[i + 1] += rowLengths[i];
+		}
+
+		auto result = ResultMatrixType(rowCount, columnCount, rowLengths[rowCount]);
+		for (size_t i = 0; i < rowCount; ++i)
+		{
+			result.SetRowCount(i, rowLengths[i]);
+		}
+		ParallelBlock([&]()
+			{
+				auto accumulator = Array<ScalarType>(columnCount);
+				auto marker = Array<size_t>(std::numeric_limits<size_t>::max(), columnCount);
+				auto columns = Array<size_t>();
+				ForInParallelBlock(0, rowCount, [&](int64_t i)
+					{
+						const size_t rowStart = rowLengths[i];
+						const size_t length = rowLengths[i + 1] - rowStart;
+						if (columns.size() < length)
+						{
+							columns = Array<size_t>(length);
+						}
+						size_t current = 0;
+						for (size_t ka = A.GetRowCount(i); ka < A.GetRowCount(i + 1); ++ka)
+						{
+							const size_t j = A.GetColumnIndex(ka);
+							const auto aValue = A.GetValue(ka);
+							for (size_t kb = B.GetRowCount(j); kb < B.GetRowCount(j + 1); ++kb)
+							{
+								const size_t column = B.GetColumnIndex(kb);
+								if (marker[column] != static_cast<size_t>(i))
+								{
+									marker[column] = i;
+									accumulator[column] = 0;
+									columns[current++] = column;
+								}
+								accumulator[column] += aValue * B.GetValue(kb);
+							}
+						}
+						std::sort(columns.begin(), columns.begin() + length);
+						for (size_t k = 0; k < length; ++k)
+						{
+							result.SetColumnIndex(rowStart + k, columns[k]);
+							result.SetValue(rowStart + k, accumulator[columns[k]]);
+						}
+					});
+			});
+		return result;
+	}
+
+	// Returns submatrix of A formed by the given rows and columns, columnMap maps column of A to the column of the
+	// result or to a value not less than result column count if column is not taken. Order of entries in rows is kept.
+	template<Concepts::CSRMatrix ResultMatrixType, Concepts::CSRMatrix MatrixType>
+	[[nodiscard]] ResultMatrixType ExtractSubmatrixCSR(const MatrixType& A, const Array<size_t>& rows,
+		const Array<size_t>& columnMap, size_t columnCount) noexcept
+	{
+		auto rowLengths = Array<size_t>(rows.size() + 1);
+		ParallelFor(0, rows.size(), [&](int64_t i)
+			{
+				size_t length = 0;
+				for (size_t k = A.GetRowCount(rows[i]); k < A.GetRowCount(rows[i] + 1); ++k)
+				{
+					if (columnMap[A.GetColumnIndex(k)] < columnCount)
+					{
+						++length;
+					}
+				}
+				rowLengths[i + 1] = length;
+			});
+		for (size_t i = 0; i < rows.size(); ++i)
+		{
+			rowLengths[i + 1] += rowLengths[i];
+		}
+
+		auto result = ResultMatrixType(rows.size(), columnCount, rowLengths[rows.size()]);
+		ParallelFor(0, rows.size(), [&](int64_t i)
+			{
+				size_t position = rowLengths[i];
+				result.SetRowCount(i, position);
+				for (size_t k = A.GetRowCount(rows[i]); k < A.GetRowCount(rows[i] + 1); ++k)
+				{
+					const auto column = columnMap[A.GetColumnIndex(k)];
+					if (column < columnCount)
+					{
+						result.SetColumnIndex(position, column);
+						result.SetValue(position++, A.GetValue(k));
+					}
+				}
+			});
+		return result;
+	}
+
+	// Returns A + alpha * B for matrices with sorted column indices in rows.
+	template<Concepts::CSRMatrix ResultMatrixType, Concepts::CSRMatrix AMatrixType, Concepts::CSRMatrix BMatrixType>
+	[[nodiscard]] ResultMatrixType AddCSR(const AMatrixType& A, const BMatrixType& B, double alpha = 1.) noexcept
+	{
+		AssertE(A.RowCount() == B.RowCount() && A.ColumnCount() == B.ColumnCount(), MessageTag::Math,
+			"Trying to add matrices with incompatible sizes.");
+
+		const size_t rowCount = A.RowCount();
+		const auto forEachMerged = [&](size_t row, auto&& body)
+		{
+			size_t ka = A.GetRowCount(row);
+			size_t kb = B.GetRowCount(row);
+			const size_t endA = A.GetRowCount(row + 1);
+			const size_t endB = B.GetRowCount(row + 1);
+			while (ka < endA || kb < endB)
+			{
+				const size_t columnA = ka < endA ? A.GetColumnIndex(ka) : std::numeric_limits<size_t>::max();
+				const size_t columnB = kb < endB ? B.GetColumnIndex(kb) : std::numeric_limits<size_t>::max();
+				if (columnA == columnB)
+				{
+					body(columnA, A.GetValue(ka++) + alpha * B.GetValue(kb++));
+				}
+				else if (columnA < columnB)
+				{
+					body(columnA, A.GetValue(ka++));
+				}
+				else
+				{
+					body(columnB, alpha * B.GetValue(kb++));
+				}
+			}
+		};
+
+		auto rowLengths = Array<size_t>(rowCount + 1);
+		ParallelFor(0, rowCount, [&](int64_t row)
+			{
+				size_t length = 0;
+				forEachMerged(row, [&](size_t, double) { ++length; });
+				rowLengths[row + 1] = length;
+			});
+		for (size_t i = 0; i < rowCount; ++i)
+		{
+			rowLengths[i + 1] += rowLengths[i];
+		}
+
+		auto result = ResultMatrixType(rowCount, A.ColumnCount(), rowLengths[rowCount]);
+		ParallelFor(0, rowCount, [&](int64_t row)
+			{
+				size_t position = rowLengths[row];
+				result.SetRowCount(row, position);
+				forEachMerged(row, [&](size_t column, double value)
+					{
+						result.SetColumnIndex(position, column);
+						result.SetValue(position++, value);
+					});
+			});
+		return result;
+	}
+}
+
+namespace CESDSOL
+{
+	template<Native::NativeCSRMatrix MatrixType, Concepts::Vector XVectorType, Concepts::Vector YVectorType, typename ScalarType = f64>
+	void MVMultiply(const MatrixType& A, const XVectorType& x, YVectorType& y, ScalarType alpha = 1., ScalarType beta = 0.)
+	{
+		AssertE(A.ColumnCount() == x.size(), MessageTag::Math, "Trying to multiply matrix and vector with incompatible sizes.");
+		AssertE(A.RowCount() == y.size(), MessageTag::Math, "Trying to assign vectors with incompatible sizes.");
+
+		Native::CSRMVMultiply(A.GetRowCounts().data(), A.GetColumnIndices().data(), A.GetValues().data(), 
+			MatrixType::StartingIndex, A.RowCount(), x.data(), y.data(), alpha, beta);
+	}
+}
\ No newline at end of file
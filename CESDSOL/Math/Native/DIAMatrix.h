@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Math/Array.h"
+#include "Math/Concepts.h"
+#include "Utils/Parallelism/Parallelism.h"
+#include "Utils/Utils.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace CESDSOL::Native
+{
+	// Sparse matrix in diagonal format: every diagonal containing a nonzero is stored in full, so matrix-vector
+	// product runs over contiguous diagonals without column indices. Efficient for banded matrices with few diagonals,
+	// e.g. differentiation matrices on direct product grids.
+	template<typename ScalarType>
+	class DIAMatrix
+	{
+	public:
+		using value_type = ScalarType;
+		using size_type = size_t;
+
+		DIAMatrix() noexcept = default;
+
+		template<Concepts::CSRMatrix MatrixType>
+		explicit DIAMatrix(const MatrixType& A) noexcept
+			: rowCount(A.RowCount())
+			, columnCount(A.ColumnCount())
+		{
+			offsets = GetOffsets(A);
+			auto diagonals = Array<size_t>(columnCount + rowCount);
+			for (size_t d = 0; d < offsets.size(); ++d)
+			{
+				diagonals[offsets[d] + rowCount] = d;
+			}
+			values = Array<ScalarType>(offsets.size() * rowCount);
+			entryPositions = Array<size_t>(A.NonZeroCount());
+			ParallelFor(0, rowCount,
+				[&](int64_t row)
+				{
+					for (size_t k = A.GetRowCount(row); k < A.GetRowCount(row + 1); ++k)
+					{
+						const auto position = diagonals[A.GetColumnIndex(k) + rowCount - row] * rowCount + row;
+						values[position] = A.GetValue(k);
+						entryPositions[k] = position;
+					}
+				});
+		}
+
+		// Returns sorted offsets of diagonals containing nonzeros, column minus row.
+		template<Concepts::CSRMatrix MatrixType>
+		[[nodiscard]] static Array<int64_t> GetOffsets(const MatrixType& A) noexcept
+		{
+			auto isPresent = Array<bool>(A.ColumnCount() + A.RowCount());
+			for (size_t row = 0; row < A.RowCount(); ++row)
+			{
+				for (size_t k = A.GetRowCount(row); k < A.GetRowCount(row + 1); ++k)
+				{
+					isPresent[A.GetColumnIndex(k) + A.RowCount() - row] = true;
+				}
+			}
+			auto result = Array<int64_t>(static_cast<size_t>(std::count(isPresent.begin(), isPresent.end(), true)));
+			size_t count = 0;
+			for (size_t i = 0; i < isPresent.size(); ++i)
+			{
+				if (isPresent[i])
+				{
+					result[count++] = static_cast<int64_t>(i) - static_cast<int64_t>(A.RowCount());
+				}
+			}
+			return result;
+		}
+
+		[[nodiscard]] size_t RowCount() const noexcept
+		{
+			return rowCount;
+		}
+
+		[[nodiscard]] size_t ColumnCount() const noexcept
+		{
+			return columnCount;
+		}
+
+		// Number of stored elements including zeros on diagonals.
+		[[nodiscard]] size_t StoredCount() const noexcept
+		{
+			return values.size();
+		}
+
+		// Refills values from matrix with the same pattern as the one DIA matrix was constructed from.
+		template<Concepts::CSRMatrix MatrixType>
+		void UpdateValues(const MatrixType& A) noexcept
+		{
+			AssertE(A.NonZeroCount() == entryPositions.size(), MessageTag::Math, "Trying to update DIA matrix with different pattern.");
+			ParallelFor(0, entryPositions.size(),
+				[&](int64_t k)
+				{
+					values[entryPositions[k]] = A.GetValue(k);
+				});
+		}
+
+		template<Concepts::Vector XVectorType, Concepts::Vector YVectorType>
+		void Apply(const XVectorType& x, YVectorType& y) const noexcept
+		{
+			AssertE(x.size() == columnCount && y.size() == rowCount, MessageTag::Math,
+				"Trying to multiply matrix and vector with incompatible sizes.");
+			const auto* xData = x.data();
+			auto* yData = y.data();
+			const auto blockCount = (rowCount + BlockSize - 1) / BlockSize;
+			ParallelFor(0, blockCount,
+				[&](int64_t block)
+				{
+					const auto blockStart = static_cast<int64_t>(block * BlockSize);
+					const auto blockEnd = static_cast<int64_t>(std::min((block + 1) * BlockSize, rowCount));
+					std::fill(yData + blockStart, yData + blockEnd, typename YVectorType::value_type(0));
+					for (size_t d = 0; d < offsets.size(); ++d)
+					{
+						const auto offset = offsets[d];
+						const auto start = std::max(blockStart, -offset);
+						const auto end = std::min(blockEnd, static_cast<int64_t>(columnCount) - offset);
+						const auto* diagonal = values.data() + d * rowCount;
+						for (auto row = start; row < end; ++row)
+						{
+							yData[row] += diagonal[row] * xData[row + offset];
+						}
+					}
+				});
+		}
+
+	private:
+		// Number of rows processed by single task, diagonals are swept over block of rows while it stays in cache.
+		static constexpr size_t BlockSize = 1024;
+
+		size_t rowCount = 0;
+		size_t columnCount = 0;
+		Array<int64_t> offsets;
+		Array<ScalarType> values;
+		// Position of every entry of the source CSR matrix.
+		Array<size_t> entryPositions;
+	};
+}
\ No newline at end of file
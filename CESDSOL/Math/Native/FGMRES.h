@@ -0,0 +1,251 @@
+#pragma once
+
+#include "Math/LinearAlgebra.h"
+#include "Math/LinearOperator.h"
+#include "Math/LinearSolver.h"
+#include "Math/Native/FusedVectorOperations.h"
+#include "Math/Preconditioner.h"
+#include "Math/TunedSparseOperator.h"
+
+#include <cmath>
+
+namespace CESDSOL::Native
+{
+	// Restarted flexible GMRES with right preconditioning. Arnoldi basis is orthogonalized with
+	// classical Gram-Schmidt applied twice (CGS2), so each step costs two block reductions instead of
+	// j sequential ones in modified Gram-Schmidt. Products with CSR matrices use tuned storage format.
+	template<typename OperatorType, typename ScalarType = f64>
+	class FGMRES final
+		: public LinearSolver<OperatorType, Vector<ScalarType>>
+	{
+	public:
+		using VectorType = Vector<ScalarType>;
+
+		FGMRES(uptr<Preconditioner<OperatorType, VectorType>> aPreconditioner = nullptr)
+			: preconditioner(std::move(aPreconditioner))
+		{}
+
+		bool Solve(const OperatorType& A, const VectorType& y, VectorType& x) override
+		{
+			const size_t size = y.size();
+			AssertE(x.size() == size, MessageTag::LinearSolver, "Solution and right hand side sizes differ in FGMRES.");
+			Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::LinearSolver,
+				Format("Starting solving system of {} linear equations with native FGMRES.", size));
+
+			if (preconditioner != nullptr && !preconditioner->Setup(A, y))
+			{
+				Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::LinearSolver,
+					"Failed to setup preconditioner for FGMRES.");
+				return false;
+			}
+			systemOperator.Update(A, operatorTuning);
+
+			const size_t restart = std::max<size_t>(restartIterationLimit, 1);
+			Allocate(size, restart);
+
+			const ScalarType rhsNorm = ParallelNorm2(y.data(), size);
+			const ScalarType target = std::max<ScalarType>(relativeTolerance * rhsNorm, absoluteTolerance);
+			ScalarType residualNorm = ComputeResidual(A, y, x, basis[0]);
+
+			size_t iterationCount = 0;
+			bool converged = residualNorm <= target;
+			while (!converged && iterationCount < iterationLimit)
+			{
+				if (residualNorm == 0)
+				{
+					converged = true;
+					break;
+				}
+				ParallelScale(ScalarType(1) / residualNorm, basis[0].data(), size);
+				std::fill(g.begin(), g.end(), ScalarType(0));
+				g[0] = residualNorm;
+
+				size_t columnCount = 0;
+				for (size_t j = 0; j < restart; ++j)
+				{
+					auto& direction = preconditioner != nullptr ? preconditionedBasis[j] : basis[j];
+					if (preconditioner != nullptr)
+					{
+						if (!preconditioner->Solve(A, basis[j], direction))
+						{
+							Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::LinearSolver,
+								"Failed to apply preconditioner in FGMRES.");
+							return false;
+						}
+					}
+					systemOperator.Apply(A, direction, basis[j + 1]);
+
+					const auto nextNorm = Orthogonalize(j, size);
+					hessenberg[j][j + 1] = nextNorm;
+					ApplyGivensRotations(j);
+
+					++columnCount;
+					++iterationCount;
+					residualNorm = std::abs(g[j + 1]);
+					if (residualNorm <= target)
+					{
+						converged = true;
+						break;
+					}
+					if (nextNorm <= breakdownTolerance * std::abs(hessenberg[j][j]) || iterationCount >= iterationLimit)
+					{
+						break;
+					}
+					ParallelScale(ScalarType(1) / nextNorm, basis[j + 1].data(), size);
+				}
+
+				UpdateSolution(x, columnCount, size);
+				if (converged || iterationCount >= iterationLimit)
+				{
+					break;
+				}
+				residualNorm = ComputeResidual(A, y, x, basis[0]);
+				converged = residualNorm <= target;
+			}
+
+			if (!converged)
+			{
+				Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::LinearSolver,
+					"FGMRES reached iteration limit, but relative tolerance was not satisfied!");
+				return true;
+			}
+			Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::LinearSolver,
+				Format("FGMRES solved linear system in {} iterations.", iterationCount));
+			return true;
+		}
+
+		void SetPreconditioner(uptr<Preconditioner<OperatorType, VectorType>> aPreconditioner) noexcept
+		{
+			preconditioner = std::move(aPreconditioner);
+		}
+
+	private:
+		void Allocate(size_t size, size_t restart) noexcept
+		{
+			const size_t directionCount = preconditioner != nullptr ? restart : 0;
+			if (basis.size() == restart + 1 && basis[0].size() == size && preconditionedBasis.size() == directionCount)
+			{
+				return;
+			}
+
+			basis = Array<VectorType>(restart + 1);
+			preconditionedBasis = Array<VectorType>(directionCount);
+			basisPointers = Array<const ScalarType*>(restart + 1);
+			directionPointers = Array<const ScalarType*>(restart);
+			hessenberg = Array<VectorType>(restart);
+			for (size_t i = 0; i <= restart; ++i)
+			{
+				basis[i] = VectorType(size);
+				basisPointers[i] = basis[i].data();
+			}
+			for (size_t i = 0; i < restart; ++i)
+			{
+				if (directionCount > 0)
+				{
+					preconditionedBasis[i] = VectorType(size);
+				}
+				directionPointers[i] = directionCount > 0 ? preconditionedBasis[i].data() : basis[i].data();
+				hessenberg[i] = VectorType(restart + 1);
+			}
+			projection = VectorType(restart + 1);
+			correction = VectorType(restart + 1);
+			cosines = VectorType(restart);
+			sines = VectorType(restart);
+			g = VectorType(restart + 1);
+		}
+
+		ScalarType ComputeResidual(const OperatorType& A, const VectorType& y, const VectorType& x, VectorType& r)
+		{
+			systemOperator.Apply(A, x, r);
+			return std::sqrt(AXPYZSquaredNorm(ScalarType(-1), r.data(), y.data(), r.data(), y.size()));
+		}
+
+		// Orthogonalizes basis[j + 1] against basis[0..j], stores coefficients into hessenberg[j] and returns the
+		// norm of the orthogonalized vector.
+		ScalarType Orthogonalize(size_t j, size_t size) noexcept
+		{
+			auto& column = hessenberg[j];
+			auto* w = basis[j + 1].data();
+			const size_t vectorCount = j + 1;
+
+			MultiDotProduct(basisPointers.data(), vectorCount, w, column.data(), size);
+			for (size_t i = 0; i < vectorCount; ++i)
+			{
+				correction[i] = -column[i];
+			}
+			MultiAXPY(basisPointers.data(), vectorCount, correction.data(), w, size);
+
+			MultiDotProduct(basisPointers.data(), vectorCount, w, projection.data(), size);
+			for (size_t i = 0; i < vectorCount; ++i)
+			{
+				column[i] += projection[i];
+				correction[i] = -projection[i];
+			}
+			return std::sqrt(MultiAXPYSquaredNorm(basisPointers.data(), vectorCount, correction.data(), w, size));
+		}
+
+		void ApplyGivensRotations(size_t j) noexcept
+		{
+			auto& column = hessenberg[j];
+			for (size_t i = 0; i < j; ++i)
+			{
+				const auto temp = cosines[i] * column[i] + sines[i] * column[i + 1];
+				column[i + 1] = -sines[i] * column[i] + cosines[i] * column[i + 1];
+				column[i] = temp;
+			}
+			const auto radius = std::hypot(column[j], column[j + 1]);
+			if (radius == 0)
+			{
+				cosines[j] = 1;
+				sines[j] = 0;
+			}
+			else
+			{
+				cosines[j] = column[j] / radius;
+				sines[j] = column[j + 1] / radius;
+			}
+			column[j] = radius;
+			column[j + 1] = 0;
+			g[j + 1] = -sines[j] * g[j];
+			g[j] = cosines[j] * g[j];
+		}
+
+		void UpdateSolution(VectorType& x, size_t columnCount, size_t size) noexcept
+		{
+			for (size_t i = columnCount; i-- > 0;)
+			{
+				auto value = g[i];
+				for (size_t k = i + 1; k < columnCount; ++k)
+				{
+					value -= hessenberg[k][i] * correction[k];
+				}
+				correction[i] = hessenberg[i][i] != 0 ? value / hessenberg[i][i] : 0;
+			}
+			MultiAXPY(directionPointers.data(), columnCount, correction.data(), x.data(), size);
+		}
+
+		uptr<Preconditioner<OperatorType, VectorType>> preconditioner;
+		IterativeSolverOperator<OperatorType, VectorType> systemOperator;
+
+		Array<VectorType> basis;
+		Array<VectorType> preconditionedBasis;
+		Array<const ScalarType*> basisPointers;
+		// Vectors the solution is assembled from: preconditioned basis if preconditioner is set, basis otherwise.
+		Array<const ScalarType*> directionPointers;
+		// Columns of upper Hessenberg matrix, column j has j + 2 meaningful entries.
+		Array<VectorType> hessenberg;
+		VectorType projection;
+		VectorType correction;
+		VectorType cosines;
+		VectorType sines;
+		VectorType g;
+
+		MakeProperty(iterationLimit, IterationLimit, size_t, 150)
+		MakeProperty(restartIterationLimit, RestartIterationLimit, size_t, 30)
+		MakeProperty(relativeTolerance, RelativeTolerance, ScalarType, 1e-6)
+		MakeProperty(absoluteTolerance, AbsoluteTolerance, ScalarType, 0)
+		MakeProperty(breakdownTolerance, BreakdownTolerance, ScalarType, 1e-14)
+		// If true, CSR matrix is copied to the storage format with the fastest product, see IterativeSolverOperator.
+		MakeProperty(operatorTuning, OperatorTuning, bool, true)
+	};
+}
\ No newline at end of file
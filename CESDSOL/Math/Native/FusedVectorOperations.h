@@ -0,0 +1,248 @@
+#pragma once
+
+#include "Math/Array.h"
+#include "Utils/Parallelism/Parallelism.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+namespace CESDSOL::Native
+{
+	// Parallel kernels used by Krylov solvers. Each kernel makes a single pass over its vectors,
+	// so several BLAS1 operations and reductions are fused into one memory sweep.
+	constexpr size_t FusedKernelChunkSize = 4096;
+
+	namespace Detail
+	{
+		[[nodiscard]] constexpr int64_t ChunkCount(size_t count) noexcept
+		{
+			return static_cast<int64_t>((count + FusedKernelChunkSize - 1) / FusedKernelChunkSize);
+		}
+
+		template<typename BodyType>
+		void ForEachChunk(size_t count, BodyType&& body) noexcept
+		{
+			ForInParallelBlock(0, ChunkCount(count), [&](int64_t chunk)
+				{
+					const size_t begin = chunk * FusedKernelChunkSize;
+					const size_t end = std::min(begin + FusedKernelChunkSize, count);
+					body(begin, end);
+				});
+		}
+
+		template<typename ScalarType, size_t ResultCount, typename BodyType>
+		std::array<ScalarType, ResultCount> Reduce(size_t count, BodyType&& body) noexcept
+		{
+			std::array<ScalarType, ResultCount> result{};
+			ParallelBlock([&]()
+				{
+					std::array<ScalarType, ResultCount> local{};
+					ForEachChunk(count, [&](size_t begin, size_t end)
+						{
+							body(begin, end, local);
+						});
+					CriticalSection([&]()
+						{
+							for (size_t i = 0; i < ResultCount; ++i)
+							{
+								result[i] += local[i];
+							}
+						});
+				});
+			return result;
+		}
+	}
+
+	template<typename ScalarType>
+	[[nodiscard]] ScalarType ParallelDotProduct(const ScalarType* x, const ScalarType* y, size_t count) noexcept
+	{
+		return Detail::Reduce<ScalarType, 1>(count, [&](size_t begin, size_t end, auto& local)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					local[0] += x[i] * y[i];
+				}
+			})[0];
+	}
+
+	template<typename ScalarType>
+	[[nodiscard]] ScalarType ParallelNorm2(const ScalarType* x, size_t count) noexcept
+	{
+		return std::sqrt(ParallelDotProduct(x, x, count));
+	}
+
+	// Returns (<a, b>, <c, d>).
+	template<typename ScalarType>
+	[[nodiscard]] std::pair<ScalarType, ScalarType> DotProducts(const ScalarType* a, const ScalarType* b,
+		const ScalarType* c, const ScalarType* d, size_t count) noexcept
+	{
+		const auto result = Detail::Reduce<ScalarType, 2>(count, [&](size_t begin, size_t end, auto& local)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					local[0] += a[i] * b[i];
+					local[1] += c[i] * d[i];
+				}
+			});
+		return { result[0], result[1] };
+	}
+
+	// z = y + a * x, returns <z, z>.
+	template<typename ScalarType>
+	[[nodiscard]] ScalarType AXPYZSquaredNorm(ScalarType a, const ScalarType* x, const ScalarType* y, ScalarType* z,
+		size_t count) noexcept
+	{
+		return Detail::Reduce<ScalarType, 1>(count, [&](size_t begin, size_t end, auto& local)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					z[i] = y[i] + a * x[i];
+					local[0] += z[i] * z[i];
+				}
+			})[0];
+	}
+
+	// z = y + a * x, returns (<z, z>, <w, z>).
+	template<typename ScalarType>
+	[[nodiscard]] std::pair<ScalarType, ScalarType> AXPYZDotProducts(ScalarType a, const ScalarType* x, const ScalarType* y,
+		ScalarType* z, const ScalarType* w, size_t count) noexcept
+	{
+		const auto result = Detail::Reduce<ScalarType, 2>(count, [&](size_t begin, size_t end, auto& local)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					z[i] = y[i] + a * x[i];
+					local[0] += z[i] * z[i];
+					local[1] += w[i] * z[i];
+				}
+			});
+		return { result[0], result[1] };
+	}
+
+	// z += a * x + b * y.
+	template<typename ScalarType>
+	void DoubleAXPY(ScalarType a, const ScalarType* x, ScalarType b, const ScalarType* y, ScalarType* z, size_t count) noexcept
+	{
+		ParallelBlock([&]()
+			{
+				Detail::ForEachChunk(count, [&](size_t begin, size_t end)
+					{
+						for (size_t i = begin; i < end; ++i)
+						{
+							z[i] += a * x[i] + b * y[i];
+						}
+					});
+			});
+	}
+
+	// y = x + a * y + b * z.
+	template<typename ScalarType>
+	void XPAYPBZ(const ScalarType* x, ScalarType a, ScalarType* y, ScalarType b, const ScalarType* z, size_t count) noexcept
+	{
+		ParallelBlock([&]()
+			{
+				Detail::ForEachChunk(count, [&](size_t begin, size_t end)
+					{
+						for (size_t i = begin; i < end; ++i)
+						{
+							y[i] = x[i] + a * y[i] + b * z[i];
+						}
+					});
+			});
+	}
+
+	// result[j] = <vectors[j], x> for j < vectorCount.
+	template<typename ScalarType>
+	void MultiDotProduct(const ScalarType* const* vectors, size_t vectorCount, const ScalarType* x, ScalarType* result,
+		size_t count) noexcept
+	{
+		std::fill_n(result, vectorCount, ScalarType(0));
+		ParallelBlock([&]()
+			{
+				auto local = Array<ScalarType>(vectorCount);
+				Detail::ForEachChunk(count, [&](size_t begin, size_t end)
+					{
+						for (size_t j = 0; j < vectorCount; ++j)
+						{
+							const auto* vector = vectors[j];
+							ScalarType sum = 0;
+							for (size_t i = begin; i < end; ++i)
+							{
+								sum += vector[i] * x[i];
+							}
+							local[j] += sum;
+						}
+					});
+				CriticalSection([&]()
+					{
+						for (size_t j = 0; j < vectorCount; ++j)
+						{
+							result[j] += local[j];
+						}
+					});
+			});
+	}
+
+	// x += sum(coefficients[j] * vectors[j]) for j < vectorCount.
+	template<typename ScalarType>
+	void MultiAXPY(const ScalarType* const* vectors, size_t vectorCount, const ScalarType* coefficients, ScalarType* x,
+		size_t count) noexcept
+	{
+		ParallelBlock([&]()
+			{
+				Detail::ForEachChunk(count, [&](size_t begin, size_t end)
+					{
+						for (size_t j = 0; j < vectorCount; ++j)
+						{
+							const auto* vector = vectors[j];
+							const auto coefficient = coefficients[j];
+							for (size_t i = begin; i < end; ++i)
+							{
+								x[i] += coefficient * vector[i];
+							}
+						}
+					});
+			});
+	}
+
+	// x += sum(coefficients[j] * vectors[j]) for j < vectorCount, returns <x, x>.
+	template<typename ScalarType>
+	[[nodiscard]] ScalarType MultiAXPYSquaredNorm(const ScalarType* const* vectors, size_t vectorCount,
+		const ScalarType* coefficients, ScalarType* x, size_t count) noexcept
+	{
+		return Detail::Reduce<ScalarType, 1>(count, [&](size_t begin, size_t end, auto& local)
+			{
+				for (size_t j = 0; j < vectorCount; ++j)
+				{
+					const auto* vector = vectors[j];
+					const auto coefficient = coefficients[j];
+					for (size_t i = begin; i < end; ++i)
+					{
+						x[i] += coefficient * vector[i];
+					}
+				}
+				for (size_t i = begin; i < end; ++i)
+				{
+					local[0] += x[i] * x[i];
+				}
+			})[0];
+	}
+
+	template<typename ScalarType>
+	void ParallelScale(ScalarType a, ScalarType* x, size_t count) noexcept
+	{
+		ParallelBlock([&]()
+			{
+				Detail::ForEachChunk(count, [&](size_t begin, size_t end)
+					{
+						for (size_t i = begin; i < end; ++i)
+						{
+							x[i] *= a;
+						}
+					});
+			});
+	}
+}
\ No newline at end of file
@@ -0,0 +1,315 @@
+#pragma once
+
+#include "Math/CSRMatrixOperations.h"
+#include "Math/LinearAlgebra.h"
+#include "Math/Preconditioner.h"
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace CESDSOL::Native
+{
+	// Incomplete LU factorization with level of fill k. Symbolic phase (fill pattern and level schedules) depends
+	// only on the matrix pattern and is recomputed only when the pattern changes, so repeated setups with Jacobians
+	// of the same structure only redo numeric factorization. Rows are grouped into levels such that rows of the same
+	// level do not depend on each other, numeric factorization and both triangular solves process each level in
+	// parallel.
+	template<typename MatrixType>
+	class ILUK final
+		: public Preconditioner<MatrixType, Vector<double>>
+	{
+	public:
+		using VectorType = Vector<double>;
+
+		ILUK(size_t aFillLevel = 0) noexcept
+			: fillLevel(aFillLevel)
+		{}
+
+		bool Setup(const MatrixType& matrix, const VectorType& y) noexcept override
+		{
+			const auto hash = ComputePatternHash(matrix);
+			if (!isSymbolicActual || hash != patternHash || factorFillLevel != fillLevel)
+			{
+				Analyze(matrix);
+				patternHash = hash;
+				factorFillLevel = fillLevel;
+				isSymbolicActual = true;
+				Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::Preconditioner,
+					Format("ILU({}) symbolic phase computed: {} nonzeros, {} factorization levels.", fillLevel,
+						columns.size(), factorLevelStarts.size() - 1));
+			}
+			if (!Factorize(matrix))
+			{
+				return false;
+			}
+			Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::Preconditioner,
+				Format("ILU({}) preconditioner was successfully calculated.", fillLevel));
+			return true;
+		}
+
+		bool Solve(const MatrixType& matrix, const VectorType& y, VectorType& x) override
+		{
+			const size_t* const rowStartsData = rowStarts.data();
+			const size_t* const columnsData = columns.data();
+			const size_t* const diagonalData = diagonalPositions.data();
+			const double* const valuesData = values.data();
+			ParallelBlock([&]()
+				{
+					for (size_t level = 0; level + 1 < factorLevelStarts.size(); ++level)
+					{
+						ForInParallelBlock(factorLevelStarts[level], factorLevelStarts[level + 1], [&](int64_t index)
+							{
+								const size_t row = factorLevelRows[index];
+								double value = y[row];
+								for (size_t k = rowStartsData[row]; k < diagonalData[row]; ++k)
+								{
+									value -= valuesData[k] * x[columnsData[k]];
+								}
+								x[row] = value;
+							});
+					}
+					for (size_t level = 0; level + 1 < backwardLevelStarts.size(); ++level)
+					{
+						ForInParallelBlock(backwardLevelStarts[level], backwardLevelStarts[level + 1], [&](int64_t index)
+							{
+								const size_t row = backwardLevelRows[index];
+								double value = x[row];
+								for (size_t k = diagonalData[row] + 1; k < rowStartsData[row + 1]; ++k)
+								{
+									value -= valuesData[k] * x[columnsData[k]];
+								}
+								x[row] = value / valuesData[diagonalData[row]];
+							});
+					}
+				});
+			return true;
+		}
+
+	private:
+		static constexpr size_t None = std::numeric_limits<size_t>::max();
+
+		// Computes pattern of ILU(k) factors row by row, keeping columns of the current row in sorted linked list.
+		void Analyze(const MatrixType& matrix) noexcept
+		{
+			const size_t size = matrix.RowCount();
+			std::vector<size_t> factorColumns;
+			std::vector<size_t> factorLevels;
+			factorColumns.reserve(matrix.NonZeroCount());
+			factorLevels.reserve(matrix.NonZeroCount());
+			rowStarts = Array<size_t>(size + 1);
+			diagonalPositions = Array<size_t>(size);
+			matrixPositions = Array<size_t>(matrix.NonZeroCount());
+
+			auto next = Array<size_t>(size + 1);
+			auto rowLevels = Array<size_t>(None, size);
+			auto positions = Array<size_t>(size);
+			const size_t head = size;
+			for (size_t row = 0; row < size; ++row)
+			{
+				next[head] = None;
+				const auto insert = [&](size_t from, size_t column, size_t level)
+				{
+					if (rowLevels[column] != None)
+					{
+						rowLevels[column] = std::min(rowLevels[column], level);
+						return;
+					}
+					size_t current = from;
+					while (next[current] != None && next[current] < column)
+					{
+						current = next[current];
+					}
+					next[column] = next[current];
+					next[current] = column;
+					rowLevels[column] = level;
+				};
+
+				for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+				{
+					insert(head, matrix.GetColumnIndex(k), 0);
+				}
+				insert(head, row, 0);
+
+				for (size_t pivot = next[head]; pivot != None && pivot < row; pivot = next[pivot])
+				{
+					const size_t pivotLevel = rowLevels[pivot];
+					for (size_t k = diagonalPositions[pivot] + 1; k < rowStarts[pivot + 1]; ++k)
+					{
+						const size_t level = pivotLevel + factorLevels[k] + 1;
+						if (level <= fillLevel)
+						{
+							insert(pivot, factorColumns[k], level);
+						}
+					}
+				}
+
+				rowStarts[row] = factorColumns.size();
+				for (size_t column = next[head]; column != None; column = next[column])
+				{
+					if (column == row)
+					{
+						diagonalPositions[row] = factorColumns.size();
+					}
+					positions[column] = factorColumns.size();
+					factorColumns.push_back(column);
+					factorLevels.push_back(rowLevels[column]);
+					rowLevels[column] = None;
+				}
+				rowStarts[row + 1] = factorColumns.size();
+				for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+				{
+					matrixPositions[k] = positions[matrix.GetColumnIndex(k)];
+				}
+			}
+
+			columns = Array<size_t>(factorColumns.size(), factorColumns.data());
+			values = Array<double>(factorColumns.size());
+
+			auto levels = Array<size_t>(size);
+			for (size_t row = 0; row < size; ++row)
+			{
+				size_t level = 0;
+				for (size_t k = rowStarts[row]; k < diagonalPositions[row]; ++k)
+				{
+					level = std::max(level, levels[columns[k]] + 1);
+				}
+				levels[row] = level;
+			}
+			MakeSchedule(levels, factorLevelStarts, factorLevelRows);
+
+			for (size_t row = size; row-- > 0;)
+			{
+				size_t level = 0;
+				for (size_t k = diagonalPositions[row] + 1; k < rowStarts[row + 1]; ++k)
+				{
+					level = std::max(level, levels[columns[k]] + 1);
+				}
+				levels[row] = level;
+			}
+			MakeSchedule(levels, backwardLevelStarts, backwardLevelRows);
+		}
+
+		// Sorts rows by levels with counting sort.
+		static void MakeSchedule(const Array<size_t>& levels, Array<size_t>& levelStarts, Array<size_t>& rows) noexcept
+		{
+			size_t levelCount = 0;
+			for (const auto level : levels)
+			{
+				levelCount = std::max(levelCount, level + 1);
+			}
+			levelStarts = Array<size_t>(levelCount + 1);
+			for (const auto level : levels)
+			{
+				++levelStarts[level + 1];
+			}
+			for (size_t i = 0; i < levelCount; ++i)
+			{
+				levelStarts[i + 1] += levelStarts[i];
+			}
+			rows = Array<size_t>(levels.size());
+			auto positions = Array<size_t>(levelCount);
+			for (size_t row = 0; row < levels.size(); ++row)
+			{
+				rows[levelStarts[levels[row]] + positions[levels[row]]++] = row;
+			}
+		}
+
+		bool Factorize(const MatrixType& matrix) noexcept
+		{
+			const size_t size = matrix.RowCount();
+			std::atomic<size_t> replacedPivotCount = 0;
+			std::atomic<bool> failed = false;
+			ParallelBlock([&]()
+				{
+					auto marker = Array<size_t>(None, size);
+					for (size_t level = 0; level + 1 < factorLevelStarts.size(); ++level)
+					{
+						ForInParallelBlock(factorLevelStarts[level], factorLevelStarts[level + 1], [&](int64_t index)
+							{
+								const size_t row = factorLevelRows[index];
+								for (size_t k = rowStarts[row]; k < rowStarts[row + 1]; ++k)
+								{
+									values[k] = 0;
+									marker[columns[k]] = k;
+								}
+								for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+								{
+									values[matrixPositions[k]] += matrix.GetValue(k);
+								}
+
+								for (size_t k = rowStarts[row]; k < diagonalPositions[row]; ++k)
+								{
+									const size_t pivot = columns[k];
+									const double factor = values[k] / values[diagonalPositions[pivot]];
+									values[k] = factor;
+									for (size_t l = diagonalPositions[pivot] + 1; l < rowStarts[pivot + 1]; ++l)
+									{
+										const size_t position = marker[columns[l]];
+										if (position != None)
+										{
+											values[position] -= factor * values[l];
+										}
+									}
+								}
+
+								auto& diagonal = values[diagonalPositions[row]];
+								if (std::abs(diagonal) <= zeroDiagonalThreshold)
+								{
+									if (normalizeZeroDiagonal)
+									{
+										diagonal = diagonal < 0 ? -zeroDiagonalNormalizer : zeroDiagonalNormalizer;
+										++replacedPivotCount;
+									}
+									else
+									{
+										failed = true;
+									}
+								}
+
+								for (size_t k = rowStarts[row]; k < rowStarts[row + 1]; ++k)
+								{
+									marker[columns[k]] = None;
+								}
+							});
+					}
+				});
+
+			if (failed)
+			{
+				Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::Preconditioner,
+					"Error in ILU(k) preconditioner calculation: the matrix contains a diagonal element which is too small.");
+				return false;
+			}
+			if (replacedPivotCount > 0)
+			{
+				Logger::Log(MessageType::Warning, MessagePriority::Medium, MessageTag::Preconditioner,
+					Format("ILU({}) replaced {} small pivots.", fillLevel, replacedPivotCount.load()));
+			}
+			return true;
+		}
+
+		// Factors L and U share one pattern with sorted columns, unit diagonal of L is not stored.
+		Array<size_t> rowStarts;
+		Array<size_t> columns;
+		Array<size_t> diagonalPositions;
+		Array<double> values;
+		// Position in the factor of every entry of the matrix.
+		Array<size_t> matrixPositions;
+
+		Array<size_t> factorLevelStarts;
+		Array<size_t> factorLevelRows;
+		Array<size_t> backwardLevelStarts;
+		Array<size_t> backwardLevelRows;
+
+		uint64_t patternHash = 0;
+		size_t factorFillLevel = 0;
+		bool isSymbolicActual = false;
+
+		MakeProperty(fillLevel, FillLevel, size_t, 0)
+		MakeProperty(normalizeZeroDiagonal, NormalizeZeroDiagonal, bool, true)
+		MakeProperty(zeroDiagonalThreshold, ZeroDiagonalThreshold, double, 1e-16)
+		MakeProperty(zeroDiagonalNormalizer, ZeroDiagonalNormalizer, double, 1e-10)
+	};
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Math/Array.h"
+#include "Math/Concepts.h"
+#include "Utils/Parallelism/Parallelism.h"
+#include "Utils/Utils.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace CESDSOL::Native
+{
+	// Sparse matrix in SELL-C-sigma format. Rows are sorted by length inside windows of SortingScope rows and grouped
+	// into chunks of ChunkHeight rows, each chunk is padded to its longest row and stored column by column, so that
+	// matrix-vector product processes ChunkHeight rows at once with unit stride.
+	template<typename ScalarType, size_t ChunkHeight = 8, typename IndexType = uint32_t>
+	class SELLMatrix
+	{
+	public:
+		using value_type = ScalarType;
+		using size_type = size_t;
+		using index_type = IndexType;
+
+		SELLMatrix() noexcept = default;
+
+		template<Concepts::CSRMatrix MatrixType>
+		explicit SELLMatrix(const MatrixType& A, size_t sortingScope = 256) noexcept
+			: rowCount(A.RowCount())
+			, columnCount(A.ColumnCount())
+		{
+			AssertE(A.ColumnCount() <= std::numeric_limits<IndexType>::max(), MessageTag::Math,
+				"Matrix is too large for SELL index type.");
+			const auto scope = std::max<size_t>(sortingScope / ChunkHeight, 1) * ChunkHeight;
+			const auto chunkCount = (rowCount + ChunkHeight - 1) / ChunkHeight;
+			const auto rowLength = [&](size_t row) { return static_cast<size_t>(A.GetRowCount(row + 1) - A.GetRowCount(row)); };
+
+			rows = Array<size_t>(rowCount);
+			for (size_t i = 0; i < rowCount; ++i)
+			{
+				rows[i] = i;
+			}
+			for (size_t start = 0; start < rowCount; start += scope)
+			{
+				std::stable_sort(rows.begin() + start, rows.begin() + std::min(start + scope, rowCount),
+					[&](size_t left, size_t right) { return rowLength(left) > rowLength(right); });
+			}
+
+			chunkStarts = Array<size_t>(chunkCount + 1);
+			for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+			{
+				chunkStarts[chunk + 1] = chunkStarts[chunk] + ChunkHeight * rowLength(rows[chunk * ChunkHeight]);
+			}
+
+			values = Array<ScalarType>(chunkStarts[chunkCount]);
+			columnIndices = Array<IndexType>(chunkStarts[chunkCount]);
+			entryPositions = Array<size_t>(A.NonZeroCount());
+			ParallelFor(0, chunkCount,
+				[&](int64_t chunk)
+				{
+					for (size_t r = 0; r < ChunkHeight && chunk * ChunkHeight + r < rowCount; ++r)
+					{
+						const auto row = rows[chunk * ChunkHeight + r];
+						auto position = chunkStarts[chunk] + r;
+						for (size_t k = A.GetRowCount(row); k < A.GetRowCount(row + 1); ++k)
+						{
+							values[position] = A.GetValue(k);
+							columnIndices[position] = static_cast<IndexType>(A.GetColumnIndex(k));
+							entryPositions[k] = position;
+							position += ChunkHeight;
+						}
+					}
+				});
+		}
+
+		[[nodiscard]] size_t RowCount() const noexcept
+		{
+			return rowCount;
+		}
+
+		[[nodiscard]] size_t ColumnCount() const noexcept
+		{
+			return columnCount;
+		}
+
+		// Number of stored elements including padding.
+		[[nodiscard]] size_t StoredCount() const noexcept
+		{
+			return values.size();
+		}
+
+		// Refills values from matrix with the same pattern as the one SELL matrix was constructed from.
+		template<Concepts::CSRMatrix MatrixType>
+		void UpdateValues(const MatrixType& A) noexcept
+		{
+			AssertE(A.NonZeroCount() == entryPositions.size(), MessageTag::Math, "Trying to update SELL matrix with different pattern.");
+			ParallelFor(0, entryPositions.size(),
+				[&](int64_t k)
+				{
+					values[entryPositions[k]] = A.GetValue(k);
+				});
+		}
+
+		template<Concepts::Vector XVectorType, Concepts::Vector YVectorType>
+		void Apply(const XVectorType& x, YVectorType& y) const noexcept
+		{
+			AssertE(x.size() == columnCount && y.size() == rowCount, MessageTag::Math,
+				"Trying to multiply matrix and vector with incompatible sizes.");
+			using ResultType = typename YVectorType::value_type;
+			const auto* xData = x.data();
+			auto* yData = y.data();
+			ParallelFor(0, chunkStarts.size() - 1,
+				[&](int64_t chunk)
+				{
+					ResultType sums[ChunkHeight] = {};
+					for (size_t position = chunkStarts[chunk]; position < chunkStarts[chunk + 1]; position += ChunkHeight)
+					{
+						for (size_t r = 0; r < ChunkHeight; ++r)
+						{
+							sums[r] += values[position + r] * xData[columnIndices[position + r]];
+						}
+					}
+					for (size_t r = 0; r < ChunkHeight && chunk * ChunkHeight + r < rowCount; ++r)
+					{
+						yData[rows[chunk * ChunkHeight + r]] = sums[r];
+					}
+				});
+		}
+
+	private:
+		size_t rowCount = 0;
+		size_t columnCount = 0;
+		// Original row of each sorted row.
+		Array<size_t> rows;
+		Array<size_t> chunkStarts;
+		Array<ScalarType> values;
+		Array<IndexType> columnIndices;
+		// Position of every entry of the source CSR matrix.
+		Array<size_t> entryPositions;
+	};
+}
\ No newline at end of file
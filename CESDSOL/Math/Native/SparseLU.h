@@ -0,0 +1,450 @@
+#pragma once
+
+#include "Math/CSRMatrixOperations.h"
+#include "Math/LinearAlgebra.h"
+#include "Math/LinearSolver.h"
+#include "Math/Reordering.h"
+
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace CESDSOL::Native
+{
+	enum class SparseLUOrdering
+	{
+		Natural,
+		ReverseCuthillMcKee
+	};
+
+	// Sparse direct solver based on left-looking LU factorization with threshold partial pivoting (Gilbert-Peierls
+	// algorithm, as in KLU). Columns are preordered symmetrically to reduce fill, column k of the factors is found by
+	// sparse triangular solve with already computed columns of L over the reach of column k of the matrix, with
+	// diagonal preferred as pivot while it is not too small. Ordering is computed only when the pattern of the matrix
+	// changes. Subsequent matrices with the same pattern are refactorized numerically with the patterns of L and U
+	// and the pivot sequence of the last full factorization, which is much cheaper; if some pivot becomes too small,
+	// full factorization with pivoting is repeated. Factors can be stored in single precision, which halves their
+	// memory and the cost of substitutions, columns are still eliminated in double precision; accuracy is then
+	// recovered by MixedPrecisionSolver.
+	template<Concepts::CSRMatrix MatrixType, typename FactorScalarType = double>
+	class SparseLU final
+		: public LinearSolver<MatrixType, Vector<double>>
+	{
+	public:
+		using VectorType = Vector<double>;
+
+		SparseLU(SparseLUOrdering aOrdering = SparseLUOrdering::ReverseCuthillMcKee) noexcept
+			: ordering(aOrdering)
+		{}
+
+		// Number of nonzeros in L and U factors including diagonals.
+		[[nodiscard]] size_t FactorNonZeroCount() const noexcept
+		{
+			return lowerRows.size() + upperRows.size();
+		}
+
+		bool Solve(const MatrixType& matrix, const VectorType& y, VectorType& x) override
+		{
+			return SolveMultiple(matrix, y, x, 1);
+		}
+
+		// Substitutions process all right hand sides together while traversing every column of factors once.
+		bool SolveMultiple(const MatrixType& matrix, const VectorType& y, VectorType& x, size_t rhsCount) override
+		{
+			Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+				Format("Starting solving system of {} linear equations with {} right hand sides with sparse LU.",
+					matrix.RowCount(), rhsCount));
+			std::chrono::high_resolution_clock clock;
+			const auto solutionStartTime = clock.now();
+			if (!Factorize(matrix))
+			{
+				return false;
+			}
+			Substitute(y, x, rhsCount);
+			Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+				Format("Linear system is solved by sparse LU in {}", clock.now() - solutionStartTime));
+			return true;
+		}
+
+		bool Factorize(const MatrixType& matrix) override
+		{
+			AssertE(matrix.RowCount() == matrix.ColumnCount(), MessageTag::LinearSolver, "Sparse LU requires square matrix.");
+			const auto hash = ComputePatternHash(matrix);
+			bool isFactorized = false;
+			if (!isPatternActual || hash != patternHash)
+			{
+				Analyze(matrix);
+				patternHash = hash;
+				isPatternActual = true;
+			}
+			else if (isFactorActual)
+			{
+				isFactorized = Refactorize(matrix);
+				if (!isFactorized)
+				{
+					Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+						"Sparse LU refactorization met too small pivot, factorizing with pivoting.");
+				}
+			}
+			if (!isFactorized)
+			{
+				isFactorActual = FactorizeWithPivoting(matrix);
+				if (!isFactorActual)
+				{
+					Logger::Log(MessageType::Error, MessagePriority::High, MessageTag::LinearSolver,
+						"Sparse LU failed: the matrix is singular.");
+					return false;
+				}
+				Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+					Format("Sparse LU factorization computed with {} nonzeros in factors.", FactorNonZeroCount()));
+			}
+			return true;
+		}
+
+		bool SolveFactorized(const VectorType& y, VectorType& x) override
+		{
+			Substitute(y, x, 1);
+			return true;
+		}
+
+	private:
+		static constexpr size_t None = std::numeric_limits<size_t>::max();
+
+		// Computes column ordering and column-wise copy of the pattern with positions of entries in the matrix.
+		void Analyze(const MatrixType& matrix) noexcept
+		{
+			size = matrix.RowCount();
+			columnOrder = Array<size_t>(size);
+			if (ordering == SparseLUOrdering::ReverseCuthillMcKee)
+			{
+				const auto positions = GetReverseCuthillMcKeeOrdering(matrix);
+				for (size_t i = 0; i < size; ++i)
+				{
+					columnOrder[positions[i]] = i;
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < size; ++i)
+				{
+					columnOrder[i] = i;
+				}
+			}
+
+			columnStarts = Array<size_t>(size + 1);
+			for (size_t k = 0; k < matrix.NonZeroCount(); ++k)
+			{
+				++columnStarts[matrix.GetColumnIndex(k) + 1];
+			}
+			for (size_t i = 0; i < size; ++i)
+			{
+				columnStarts[i + 1] += columnStarts[i];
+			}
+			columnRows = Array<size_t>(matrix.NonZeroCount());
+			matrixPositions = Array<size_t>(matrix.NonZeroCount());
+			auto positions = Array<size_t>(size, columnStarts.data());
+			for (size_t row = 0; row < size; ++row)
+			{
+				for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+				{
+					const auto position = positions[matrix.GetColumnIndex(k)]++;
+					columnRows[position] = row;
+					matrixPositions[position] = k;
+				}
+			}
+
+			rowSteps = Array<size_t>(size);
+			work = Array<double>(size);
+			reach = Array<size_t>(size);
+			stack = Array<size_t>(size);
+			stackPositions = Array<size_t>(size);
+			isMarked = Array<bool>(size);
+			isFactorActual = false;
+		}
+
+		// Appends rows reachable from row through the graph of already computed columns of L to reach array from the
+		// end, so that reach[top, size) is in topological order.
+		size_t DepthFirstSearch(size_t row, size_t top) noexcept
+		{
+			size_t head = 0;
+			stack[0] = row;
+			while (true)
+			{
+				const size_t current = stack[head];
+				const size_t step = rowSteps[current];
+				if (!isMarked[current])
+				{
+					isMarked[current] = true;
+					stackPositions[head] = step == None ? 0 : lowerStarts[step];
+				}
+				const size_t end = step == None ? 0 : lowerStarts[step + 1];
+				bool isDone = true;
+				for (size_t p = stackPositions[head]; p < end; ++p)
+				{
+					const size_t next = lowerRows[p];
+					if (!isMarked[next])
+					{
+						stackPositions[head] = p + 1;
+						stack[++head] = next;
+						isDone = false;
+						break;
+					}
+				}
+				if (isDone)
+				{
+					reach[--top] = current;
+					if (head == 0)
+					{
+						return top;
+					}
+					--head;
+				}
+			}
+		}
+
+		bool FactorizeWithPivoting(const MatrixType& matrix) noexcept
+		{
+			lowerStarts.assign(size + 1, 0);
+			upperStarts.assign(size + 1, 0);
+			lowerRows.clear();
+			lowerValues.clear();
+			upperRows.clear();
+			upperValues.clear();
+			std::fill(rowSteps.begin(), rowSteps.end(), None);
+
+			for (size_t step = 0; step < size; ++step)
+			{
+				lowerStarts[step] = lowerRows.size();
+				upperStarts[step] = upperRows.size();
+				const size_t column = columnOrder[step];
+
+				size_t top = size;
+				for (size_t p = columnStarts[column]; p < columnStarts[column + 1]; ++p)
+				{
+					if (!isMarked[columnRows[p]])
+					{
+						top = DepthFirstSearch(columnRows[p], top);
+					}
+				}
+				for (size_t p = top; p < size; ++p)
+				{
+					isMarked[reach[p]] = false;
+				}
+
+				// x = L \ A(:, column) over the reach.
+				for (size_t p = columnStarts[column]; p < columnStarts[column + 1]; ++p)
+				{
+					work[columnRows[p]] = matrix.GetValue(matrixPositions[p]);
+				}
+				for (size_t p = top; p < size; ++p)
+				{
+					const size_t row = reach[p];
+					const size_t pivotStep = rowSteps[row];
+					if (pivotStep == None)
+					{
+						continue;
+					}
+					const double value = work[row];
+					for (size_t l = lowerStarts[pivotStep] + 1; l < lowerStarts[pivotStep + 1]; ++l)
+					{
+						work[lowerRows[l]] -= lowerValues[l] * value;
+					}
+				}
+
+				size_t pivotRow = None;
+				double maxValue = 0;
+				for (size_t p = top; p < size; ++p)
+				{
+					const size_t row = reach[p];
+					if (rowSteps[row] == None)
+					{
+						if (std::abs(work[row]) > maxValue)
+						{
+							maxValue = std::abs(work[row]);
+							pivotRow = row;
+						}
+					}
+					else
+					{
+						upperRows.push_back(rowSteps[row]);
+						upperValues.push_back(static_cast<FactorScalarType>(work[row]));
+					}
+				}
+				if (pivotRow == None || maxValue == 0)
+				{
+					for (size_t p = top; p < size; ++p)
+					{
+						work[reach[p]] = 0;
+					}
+					return false;
+				}
+				if (rowSteps[column] == None && std::abs(work[column]) >= pivotTolerance * maxValue && work[column] != 0)
+				{
+					pivotRow = column;
+				}
+
+				const double pivot = work[pivotRow];
+				upperRows.push_back(step);
+				upperValues.push_back(static_cast<FactorScalarType>(pivot));
+				rowSteps[pivotRow] = step;
+				lowerRows.push_back(pivotRow);
+				lowerValues.push_back(1.);
+				for (size_t p = top; p < size; ++p)
+				{
+					const size_t row = reach[p];
+					if (rowSteps[row] == None)
+					{
+						lowerRows.push_back(row);
+						lowerValues.push_back(static_cast<FactorScalarType>(work[row] / pivot));
+					}
+					work[row] = 0;
+				}
+			}
+			lowerStarts[size] = lowerRows.size();
+			upperStarts[size] = upperRows.size();
+
+			// Rows of L are renumbered by pivot steps, so L becomes unit lower triangular.
+			for (auto& row : lowerRows)
+			{
+				row = rowSteps[row];
+			}
+			return true;
+		}
+
+		// Recomputes values of factors with patterns and pivot sequence of the last factorization. Entries of every
+		// column of U are stored in topological order of the reach, so they can be eliminated in that order.
+		bool Refactorize(const MatrixType& matrix) noexcept
+		{
+			for (size_t step = 0; step < size; ++step)
+			{
+				const size_t column = columnOrder[step];
+				for (size_t p = columnStarts[column]; p < columnStarts[column + 1]; ++p)
+				{
+					work[rowSteps[columnRows[p]]] = matrix.GetValue(matrixPositions[p]);
+				}
+				const size_t diagonal = upperStarts[step + 1] - 1;
+				for (size_t p = upperStarts[step]; p < diagonal; ++p)
+				{
+					const size_t pivotStep = upperRows[p];
+					const double value = work[pivotStep];
+					upperValues[p] = static_cast<FactorScalarType>(value);
+					for (size_t l = lowerStarts[pivotStep] + 1; l < lowerStarts[pivotStep + 1]; ++l)
+					{
+						work[lowerRows[l]] -= lowerValues[l] * value;
+					}
+					work[pivotStep] = 0;
+				}
+
+				const double pivot = work[step];
+				work[step] = 0;
+				double maxValue = std::abs(pivot);
+				for (size_t l = lowerStarts[step] + 1; l < lowerStarts[step + 1]; ++l)
+				{
+					maxValue = std::max(maxValue, std::abs(work[lowerRows[l]]));
+				}
+				const bool isPivotValid = pivot != 0 && std::abs(pivot) >= pivotTolerance * maxValue;
+				upperValues[diagonal] = static_cast<FactorScalarType>(pivot);
+				for (size_t l = lowerStarts[step] + 1; l < lowerStarts[step + 1]; ++l)
+				{
+					lowerValues[l] = static_cast<FactorScalarType>(work[lowerRows[l]] / pivot);
+					work[lowerRows[l]] = 0;
+				}
+				if (!isPivotValid)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Right hand sides are interleaved in the work block, so that every factor entry updates all of them at once.
+		void Substitute(const VectorType& y, VectorType& x, size_t rhsCount) noexcept
+		{
+			if (rhsWork.size() != size * rhsCount)
+			{
+				rhsWork = Array<double>(size * rhsCount);
+			}
+			auto* block = rhsWork.data();
+			for (size_t row = 0; row < size; ++row)
+			{
+				for (size_t r = 0; r < rhsCount; ++r)
+				{
+					block[rowSteps[row] * rhsCount + r] = y[r * size + row];
+				}
+			}
+			for (size_t step = 0; step < size; ++step)
+			{
+				const auto* value = block + step * rhsCount;
+				for (size_t l = lowerStarts[step] + 1; l < lowerStarts[step + 1]; ++l)
+				{
+					auto* target = block + lowerRows[l] * rhsCount;
+					const double factor = lowerValues[l];
+					for (size_t r = 0; r < rhsCount; ++r)
+					{
+						target[r] -= factor * value[r];
+					}
+				}
+			}
+			for (size_t step = size; step-- > 0;)
+			{
+				const size_t diagonal = upperStarts[step + 1] - 1;
+				auto* value = block + step * rhsCount;
+				const double inverse = 1. / upperValues[diagonal];
+				for (size_t r = 0; r < rhsCount; ++r)
+				{
+					value[r] *= inverse;
+				}
+				for (size_t p = upperStarts[step]; p < diagonal; ++p)
+				{
+					auto* target = block + upperRows[p] * rhsCount;
+					const double factor = upperValues[p];
+					for (size_t r = 0; r < rhsCount; ++r)
+					{
+						target[r] -= factor * value[r];
+					}
+				}
+			}
+			for (size_t step = 0; step < size; ++step)
+			{
+				for (size_t r = 0; r < rhsCount; ++r)
+				{
+					x[r * size + columnOrder[step]] = block[step * rhsCount + r];
+				}
+			}
+		}
+
+		SparseLUOrdering ordering;
+		size_t size = 0;
+		// Column k of the factors corresponds to column columnOrder[k] of the matrix.
+		Array<size_t> columnOrder;
+		// Pattern of the matrix by columns with positions of entries in the matrix.
+		Array<size_t> columnStarts;
+		Array<size_t> columnRows;
+		Array<size_t> matrixPositions;
+		// Pivot step of every row of the matrix.
+		Array<size_t> rowSteps;
+
+		// Factors by columns, diagonal is the first entry in columns of L and the last one in columns of U.
+		std::vector<size_t> lowerStarts;
+		std::vector<size_t> lowerRows;
+		std::vector<FactorScalarType> lowerValues;
+		std::vector<size_t> upperStarts;
+		std::vector<size_t> upperRows;
+		std::vector<FactorScalarType> upperValues;
+
+		Array<double> work;
+		Array<double> rhsWork;
+		Array<size_t> reach;
+		Array<size_t> stack;
+		Array<size_t> stackPositions;
+		Array<bool> isMarked;
+
+		uint64_t patternHash = 0;
+		bool isPatternActual = false;
+		bool isFactorActual = false;
+
+		// Diagonal is kept as pivot while it is at least this fraction of the largest candidate.
+		MakeProperty(pivotTolerance, PivotTolerance, double, 1e-3)
+	};
+}
\ No newline at end of file
@@ -0,0 +1,624 @@
+#pragma once
+
+#include "Math/CSRMatrixOperations.h"
+#include "Math/LinearAlgebra.h"
+#include "Math/LinearSolver.h"
+#include "Math/ODE/RungeKuttaSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+
+namespace CESDSOL
+{
+	// Adaptive solver for stiff transient problems y' = E(t, y) + I(t, y). Explicit part E is given by equations of the
+	// transient problem, which also keeps the solution, time and cache, implicit part I by equations of stationary
+	// problem with the same variables, whose analytic Jacobian J gives iteration matrix M = 1 - h * gamma * J. M is
+	// factorized once per step, all stages and Newton iterations reuse the factorization. Method descriptors are:
+	// - DIRK, SDIRK or ESDIRK methods: stages are solved by simplified Newton iterations with M, E is treated implicitly
+	// together with I, which converges while E is not stiff;
+	// - IMEX methods (IsIMEX): E is integrated with the explicit tableau, Newton iterations solve only for I;
+	// - Rosenbrock-W methods (IsLinearlyImplicit): every stage is one linear solve with M, J does not need to be the
+	// Jacobian of E + I. If I depends on time through TimeParameterIndex, its time derivative is computed by finite
+	// difference once per step and added to the stages, as for the autonomous system with time as a variable.
+	// Embedded errors of DIRK and IMEX methods are multiplied by M^-1, so that stiff components do not limit the step.
+	template<typename MethodDescriptor, typename ImplicitProblemType>
+	class ImplicitRungeKuttaSolver
+		: public RKOptions<typename ImplicitProblemType::CoordinateType, typename ImplicitProblemType::FieldType, true, false>
+	{
+	public:
+		using ParameterType = typename ImplicitProblemType::CoordinateType;
+		using ValueType = typename ImplicitProblemType::FieldType;
+		using MatrixType = typename ImplicitProblemType::JacobianMatrixType;
+		using VectorType = Vector<ValueType>;
+		using CurrentLinearSolver = LinearSolver<MatrixType, VectorType>;
+
+		MakeProperty(exitConditions, ExitConditions, RKExitConditions, RKExitConditions::Everything)
+		MakeProperty(initialStep, InitialStep, ParameterType, 1e-3);
+		MakeProperty(stepCountLimit, StepCountLimit, size_t, 50000);
+		MakeProperty(maxSolutionNorm, MaxSolutionNorm, ValueType, 1e20);
+		// If false, equations of the transient problem are not evaluated and the right hand side is I alone.
+		MakeProperty(useExplicitPart, UseExplicitPart, bool, true);
+		// Parameter of the implicit problem which is set to time, none by default.
+		MakeProperty(timeParameterIndex, TimeParameterIndex, size_t, std::numeric_limits<size_t>::max());
+		// Newton iterations stop when the estimated error of the stage is below this fraction of the tolerance.
+		MakeProperty(newtonTolerance, NewtonTolerance, ValueType, 0.03);
+		MakeProperty(newtonIterationLimit, NewtonIterationLimit, size_t, 10);
+
+		struct OutputInfo
+		{
+			enum class OutputReason
+			{
+				Success,
+				StepUnderflow,
+				StepCountLimitReached,
+				SolutionNormOverflow
+			};
+
+			bool success;
+			OutputReason reason;
+			size_t stepCount;
+		};
+
+		ImplicitRungeKuttaSolver(uptr<CurrentLinearSolver> aLinearSolver) noexcept
+			: linearSolver(std::move(aLinearSolver))
+		{}
+
+	private:
+		static constexpr size_t StepCount = MethodDescriptor::StepCount;
+		static constexpr ValueType Gamma = MethodDescriptor::DiagonalCoefficient;
+
+		[[nodiscard]] static constexpr bool CheckDiagonal() noexcept
+		{
+			if constexpr (!MethodDescriptor::IsLinearlyImplicit)
+			{
+				for (size_t i = 0; i < StepCount; ++i)
+				{
+					const auto value = MethodDescriptor::ButcherTableauMainPart[i][i];
+					if (value != 0 && value != MethodDescriptor::DiagonalCoefficient)
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		// Time components of stage derivatives of Rosenbrock-W method applied to the system with time as a variable,
+		// they multiply h * gamma * dI/dt in the stages.
+		[[nodiscard]] static constexpr std::array<double, StepCount> GetTimeDerivativeCoefficients() noexcept
+		{
+			std::array<double, StepCount> result{};
+			if constexpr (MethodDescriptor::IsLinearlyImplicit)
+			{
+				for (size_t i = 0; i < StepCount; ++i)
+				{
+					result[i] = 1;
+					for (size_t k = 0; k < i; ++k)
+					{
+						result[i] += MethodDescriptor::StageCouplingCoefficients[i][k] * result[k];
+					}
+				}
+			}
+			return result;
+		}
+
+		// Stage derivatives not used by any row are not evaluated, e.g. the first stage of ARS methods.
+		template<const auto& Table, const auto& ErrorTable>
+		[[nodiscard]] static constexpr bool IsColumnUsed(size_t column) noexcept
+		{
+			for (size_t row = column + 1; row <= StepCount; ++row)
+			{
+				if (Table[row][column] != 0)
+				{
+					return true;
+				}
+			}
+			return ErrorTable.front()[column] != 0;
+		}
+
+		uptr<CurrentLinearSolver> linearSolver;
+
+		struct SolutionTemporaries
+		{
+			size_t stepCount = 0;
+
+			ParameterType currentX;
+			ParameterType currentStep;
+			ValueType currentError = 1;
+
+			// Stage derivatives, of I or of the whole right hand side if E is not integrated separately.
+			std::array<VectorType, StepCount> implicitStages;
+			std::array<VectorType, MethodDescriptor::IsIMEX ? StepCount : 0> explicitStages;
+			VectorType stage;
+			VectorType base;
+			VectorType residual;
+			VectorType correction;
+			VectorType evaluation;
+			VectorType nextY;
+			// Time derivative of I at the beginning of the step, used only by Rosenbrock-W methods.
+			VectorType timeDerivative;
+
+			// Kept in optional since MKL matrices release their handles only on destruction.
+			std::optional<MatrixType> iterationMatrix;
+			uint64_t patternHash = 0;
+			Array<size_t> valuePositions;
+			Array<size_t> diagonalPositions;
+			Array<ValueType> jacobianValues;
+			bool isJacobianActual = false;
+
+			SolutionTemporaries(ParameterType firstX, size_t dofCount, ParameterType aInitialStep)
+				: currentX(firstX)
+				, currentStep(aInitialStep)
+				, stage(dofCount)
+				, base(dofCount)
+				, residual(dofCount)
+				, correction(dofCount)
+				, evaluation(dofCount)
+				, nextY(dofCount)
+			{
+				for (auto& item : implicitStages)
+				{
+					item = VectorType(dofCount);
+				}
+				for (auto& item : explicitStages)
+				{
+					item = VectorType(ValueType(0), dofCount);
+				}
+			}
+		};
+
+		void SetImplicitTime(ImplicitProblemType& implicitProblem, ParameterType time) const noexcept
+		{
+			if (timeParameterIndex != std::numeric_limits<size_t>::max())
+			{
+				implicitProblem.SetParameter(timeParameterIndex, time);
+			}
+		}
+
+		// Evaluates I at the state, plus E unless it is integrated separately.
+		template<typename TransientProblemType>
+		void Evaluate(SolutionTemporaries& tmp, ParameterType time, VectorType& state, VectorType& output,
+			TransientProblemType& problem, ImplicitProblemType& implicitProblem) const noexcept
+		{
+			SetImplicitTime(implicitProblem, time);
+			implicitProblem.SwapVariables(state);
+			implicitProblem.TakeEquations(output);
+			implicitProblem.SwapVariables(state);
+			if constexpr (!MethodDescriptor::IsIMEX)
+			{
+				if (useExplicitPart)
+				{
+					problem.EvaluateEquations(time, state, tmp.evaluation);
+					LinearAlgebra::AXPY(ValueType(1), tmp.evaluation.data(), output.data(), output.size());
+				}
+			}
+		}
+
+		// Pattern of M is the pattern of J with diagonal added, it is rebuilt only when the pattern of J changes.
+		void UpdatePattern(SolutionTemporaries& tmp, const MatrixType& jacobian) const noexcept
+		{
+			const auto hash = ComputePatternHash(jacobian);
+			if (tmp.iterationMatrix && hash == tmp.patternHash)
+			{
+				return;
+			}
+			const size_t size = jacobian.RowCount();
+			size_t nonZeroCount = jacobian.NonZeroCount();
+			for (size_t row = 0; row < size; ++row)
+			{
+				const auto begin = jacobian.GetRowCount(row);
+				const auto end = jacobian.GetRowCount(row + 1);
+				bool hasDiagonal = false;
+				for (size_t k = begin; k < end; ++k)
+				{
+					hasDiagonal |= jacobian.GetColumnIndex(k) == row;
+				}
+				nonZeroCount += !hasDiagonal;
+			}
+
+			tmp.iterationMatrix.reset();
+			tmp.iterationMatrix.emplace(size, size, nonZeroCount);
+			tmp.valuePositions = Array<size_t>(jacobian.NonZeroCount());
+			tmp.diagonalPositions = Array<size_t>(size);
+			auto& matrix = *tmp.iterationMatrix;
+			size_t position = 0;
+			for (size_t row = 0; row < size; ++row)
+			{
+				matrix.SetRowCount(row, position);
+				bool isDiagonalSet = false;
+				for (size_t k = jacobian.GetRowCount(row); k < jacobian.GetRowCount(row + 1); ++k)
+				{
+					const size_t column = jacobian.GetColumnIndex(k);
+					if (!isDiagonalSet && column >= row)
+					{
+						if (column > row)
+						{
+							matrix.SetColumnIndex(position, row);
+							tmp.diagonalPositions[row] = position++;
+						}
+						else
+						{
+							tmp.diagonalPositions[row] = position;
+						}
+						isDiagonalSet = true;
+					}
+					matrix.SetColumnIndex(position, column);
+					tmp.valuePositions[k] = position++;
+				}
+				if (!isDiagonalSet)
+				{
+					matrix.SetColumnIndex(position, row);
+					tmp.diagonalPositions[row] = position++;
+				}
+			}
+			tmp.patternHash = hash;
+		}
+
+		// Computes J at the current solution unless it is kept from rejected attempt of the step, then factorizes
+		// M = 1 - h * gamma * J. Time derivative of I for Rosenbrock-W methods is computed together with J.
+		template<typename TransientProblemType>
+		bool UpdateIterationMatrix(SolutionTemporaries& tmp, const VectorType& currentY, TransientProblemType& problem,
+			ImplicitProblemType& implicitProblem) const noexcept
+		{
+			if (!tmp.isJacobianActual)
+			{
+				LinearAlgebra::Copy(currentY.data(), tmp.stage.data(), currentY.size());
+				SetImplicitTime(implicitProblem, tmp.currentX);
+				implicitProblem.SwapVariables(tmp.stage);
+				const auto& jacobian = implicitProblem.GetJacobian();
+				UpdatePattern(tmp, jacobian);
+				if (tmp.jacobianValues.size() != jacobian.NonZeroCount())
+				{
+					tmp.jacobianValues = Array<ValueType>(jacobian.NonZeroCount());
+				}
+				ParallelFor(0, jacobian.NonZeroCount(), [&](int64_t k)
+					{
+						tmp.jacobianValues[k] = jacobian.GetValue(k);
+					});
+				if constexpr (MethodDescriptor::IsLinearlyImplicit)
+				{
+					if (timeParameterIndex != std::numeric_limits<size_t>::max())
+					{
+						ComputeTimeDerivative(tmp, implicitProblem);
+					}
+				}
+				implicitProblem.SwapVariables(tmp.stage);
+				tmp.isJacobianActual = true;
+			}
+
+			auto& matrix = *tmp.iterationMatrix;
+			const ValueType scale = -Gamma * static_cast<ValueType>(tmp.currentStep);
+			ParallelFor(0, matrix.NonZeroCount(), [&](int64_t k)
+				{
+					matrix.SetValue(k, 0);
+				});
+			ParallelFor(0, tmp.jacobianValues.size(), [&](int64_t k)
+				{
+					matrix.SetValue(tmp.valuePositions[k], scale * tmp.jacobianValues[k]);
+				});
+			ParallelFor(0, matrix.RowCount(), [&](int64_t row)
+				{
+					const auto position = tmp.diagonalPositions[row];
+					matrix.SetValue(position, matrix.GetValue(position) + 1);
+				});
+			return linearSolver->Factorize(matrix);
+		}
+
+		// Forward difference of I in time at the current solution, which is already set to the implicit problem.
+		void ComputeTimeDerivative(SolutionTemporaries& tmp, ImplicitProblemType& implicitProblem) const noexcept
+		{
+			const size_t size = tmp.stage.size();
+			if (tmp.timeDerivative.size() != size)
+			{
+				tmp.timeDerivative = VectorType(size);
+			}
+			const auto scale = std::max(std::abs(tmp.currentX), std::abs(tmp.currentStep));
+			const ParameterType shiftedX = tmp.currentX + std::sqrt(std::numeric_limits<ParameterType>::epsilon()) * scale;
+			const auto delta = static_cast<ValueType>(shiftedX - tmp.currentX);
+			implicitProblem.TakeEquations(tmp.evaluation);
+			SetImplicitTime(implicitProblem, shiftedX);
+			implicitProblem.TakeEquations(tmp.timeDerivative);
+			SetImplicitTime(implicitProblem, tmp.currentX);
+			ParallelFor(0, size, [&](int64_t i)
+				{
+					tmp.timeDerivative[i] = (tmp.timeDerivative[i] - tmp.evaluation[i]) / delta;
+				});
+		}
+
+		// Root mean square of x weighted by absoluteTolerance + relativeTolerance * max(|a|, |b|).
+		[[nodiscard]] ValueType WeightedNorm(const VectorType& x, const VectorType& a, const VectorType& b) const noexcept
+		{
+			const ValueType absoluteTolerance = this->GetAbsoluteTolerance();
+			const ValueType relativeTolerance = this->GetRelativeTolerance();
+			const auto sum = Native::Detail::Reduce<ValueType, 1>(x.size(), [&](size_t begin, size_t end, auto& local)
+				{
+					for (size_t i = begin; i < end; ++i)
+					{
+						const ValueType weight = absoluteTolerance + relativeTolerance * std::max(std::abs(a[i]), std::abs(b[i]));
+						local[0] += x[i] * x[i] / (weight * weight);
+					}
+				})[0];
+			return std::sqrt(sum / x.size());
+		}
+
+		// Solves Y = base + h * gamma * F(t, Y) by simplified Newton iterations, stores (Y - base) / (h * gamma) as the
+		// stage derivative. Convergence is tested with the estimated contraction rate of the iterations.
+		template<typename TransientProblemType>
+		bool SolveStage(SolutionTemporaries& tmp, ParameterType time, VectorType& derivative, TransientProblemType& problem,
+			ImplicitProblemType& implicitProblem) const noexcept
+		{
+			const size_t size = tmp.stage.size();
+			const ValueType scale = Gamma * static_cast<ValueType>(tmp.currentStep);
+			LinearAlgebra::Copy(tmp.base.data(), tmp.stage.data(), size);
+			ValueType previousNorm = 0;
+			for (size_t iteration = 0; iteration < newtonIterationLimit; ++iteration)
+			{
+				Evaluate(tmp, time, tmp.stage, derivative, problem, implicitProblem);
+				ParallelFor(0, size, [&](int64_t i)
+					{
+						tmp.residual[i] = tmp.base[i] + scale * derivative[i] - tmp.stage[i];
+						tmp.correction[i] = 0;
+					});
+				if (!linearSolver->SolveFactorized(tmp.residual, tmp.correction))
+				{
+					return false;
+				}
+				LinearAlgebra::AXPY(ValueType(1), tmp.correction.data(), tmp.stage.data(), size);
+				const ValueType norm = WeightedNorm(tmp.correction, tmp.stage, tmp.base);
+				bool isConverged = norm == 0;
+				if (iteration > 0 && !isConverged)
+				{
+					const ValueType rate = norm / previousNorm;
+					if (rate >= 1)
+					{
+						return false;
+					}
+					isConverged = rate / (1 - rate) * norm <= newtonTolerance;
+				}
+				if (isConverged)
+				{
+					ParallelFor(0, size, [&](int64_t i)
+						{
+							derivative[i] = (tmp.stage[i] - tmp.base[i]) / scale;
+						});
+					return true;
+				}
+				previousNorm = norm;
+			}
+			return false;
+		}
+
+		// Stages of DIRK and IMEX methods, returns false if Newton iterations or linear solver fail.
+		template<typename TransientProblemType>
+		bool ComputeStages(SolutionTemporaries& tmp, VectorType& currentY, TransientProblemType& problem,
+			ImplicitProblemType& implicitProblem) const noexcept
+		{
+			const size_t size = currentY.size();
+			for (size_t i = 0; i < StepCount; ++i)
+			{
+				const ParameterType time = tmp.currentX + MethodDescriptor::ButcherTableauFirstColumn[i] * tmp.currentStep;
+				LinearAlgebra::Copy(currentY.data(), tmp.base.data(), size);
+				for (size_t k = 0; k < i; ++k)
+				{
+					if (MethodDescriptor::ButcherTableauMainPart[i][k] != 0)
+					{
+						LinearAlgebra::AXPY(static_cast<ValueType>(tmp.currentStep * MethodDescriptor::ButcherTableauMainPart[i][k]),
+							tmp.implicitStages[k].data(), tmp.base.data(), size);
+					}
+					if constexpr (MethodDescriptor::IsIMEX)
+					{
+						if (MethodDescriptor::ExplicitButcherTableauMainPart[i][k] != 0)
+						{
+							LinearAlgebra::AXPY(static_cast<ValueType>(tmp.currentStep * MethodDescriptor::ExplicitButcherTableauMainPart[i][k]),
+								tmp.explicitStages[k].data(), tmp.base.data(), size);
+						}
+					}
+				}
+
+				if (MethodDescriptor::ButcherTableauMainPart[i][i] != 0)
+				{
+					if (!SolveStage(tmp, time, tmp.implicitStages[i], problem, implicitProblem))
+					{
+						return false;
+					}
+				}
+				else
+				{
+					LinearAlgebra::Copy(tmp.base.data(), tmp.stage.data(), size);
+					if (IsColumnUsed<MethodDescriptor::ButcherTableauMainPart, MethodDescriptor::ButcherTableauErrorRow>(i))
+					{
+						Evaluate(tmp, time, tmp.stage, tmp.implicitStages[i], problem, implicitProblem);
+					}
+				}
+				if constexpr (MethodDescriptor::IsIMEX)
+				{
+					if (useExplicitPart && IsColumnUsed<MethodDescriptor::ExplicitButcherTableauMainPart, MethodDescriptor::ExplicitButcherTableauErrorRow>(i))
+					{
+						problem.EvaluateEquations(time, tmp.stage, tmp.explicitStages[i]);
+					}
+				}
+			}
+			return true;
+		}
+
+		// Stages of Rosenbrock-W methods: M k_i = F(t + c_i * h, y + h * sum(a_ij * k_j)) + sum(c_ij * k_j).
+		template<typename TransientProblemType>
+		bool ComputeRosenbrockStages(SolutionTemporaries& tmp, VectorType& currentY, TransientProblemType& problem,
+			ImplicitProblemType& implicitProblem) const noexcept
+		{
+			constexpr auto timeDerivativeCoefficients = GetTimeDerivativeCoefficients();
+			const size_t size = currentY.size();
+			for (size_t i = 0; i < StepCount; ++i)
+			{
+				const ParameterType time = tmp.currentX + MethodDescriptor::ButcherTableauFirstColumn[i] * tmp.currentStep;
+				LinearAlgebra::Copy(currentY.data(), tmp.stage.data(), size);
+				for (size_t k = 0; k < i; ++k)
+				{
+					if (MethodDescriptor::ButcherTableauMainPart[i][k] != 0)
+					{
+						LinearAlgebra::AXPY(static_cast<ValueType>(tmp.currentStep * MethodDescriptor::ButcherTableauMainPart[i][k]),
+							tmp.implicitStages[k].data(), tmp.stage.data(), size);
+					}
+				}
+				Evaluate(tmp, time, tmp.stage, tmp.residual, problem, implicitProblem);
+				if (tmp.timeDerivative.size() != 0 && timeDerivativeCoefficients[i] != 0)
+				{
+					LinearAlgebra::AXPY(static_cast<ValueType>(Gamma * tmp.currentStep * timeDerivativeCoefficients[i]),
+						tmp.timeDerivative.data(), tmp.residual.data(), size);
+				}
+				for (size_t k = 0; k < i; ++k)
+				{
+					if (MethodDescriptor::StageCouplingCoefficients[i][k] != 0)
+					{
+						LinearAlgebra::AXPY(static_cast<ValueType>(MethodDescriptor::StageCouplingCoefficients[i][k]),
+							tmp.implicitStages[k].data(), tmp.residual.data(), size);
+					}
+				}
+				LinearAlgebra::Fill(tmp.implicitStages[i].data(), size, ValueType(0));
+				if (!linearSolver->SolveFactorized(tmp.residual, tmp.implicitStages[i]))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Computes the next solution and returns the weighted norm of the embedded error.
+		[[nodiscard]] ValueType ComputeSolution(SolutionTemporaries& tmp, const VectorType& currentY) const noexcept
+		{
+			const size_t size = currentY.size();
+			const auto step = static_cast<ValueType>(tmp.currentStep);
+			LinearAlgebra::Copy(currentY.data(), tmp.nextY.data(), size);
+			LinearAlgebra::Fill(tmp.residual.data(), size, ValueType(0));
+			for (size_t k = 0; k < StepCount; ++k)
+			{
+				LinearAlgebra::AXPY(static_cast<ValueType>(step * MethodDescriptor::ButcherTableauMainPart[StepCount][k]),
+					tmp.implicitStages[k].data(), tmp.nextY.data(), size);
+				LinearAlgebra::AXPY(static_cast<ValueType>(step * MethodDescriptor::ButcherTableauErrorRow[0][k]),
+					tmp.implicitStages[k].data(), tmp.residual.data(), size);
+				if constexpr (MethodDescriptor::IsIMEX)
+				{
+					LinearAlgebra::AXPY(static_cast<ValueType>(step * MethodDescriptor::ExplicitButcherTableauMainPart[StepCount][k]),
+						tmp.explicitStages[k].data(), tmp.nextY.data(), size);
+					LinearAlgebra::AXPY(static_cast<ValueType>(step * MethodDescriptor::ExplicitButcherTableauErrorRow[0][k]),
+						tmp.explicitStages[k].data(), tmp.residual.data(), size);
+				}
+			}
+			if constexpr (!MethodDescriptor::IsLinearlyImplicit)
+			{
+				LinearAlgebra::Fill(tmp.correction.data(), size, ValueType(0));
+				if (linearSolver->SolveFactorized(tmp.residual, tmp.correction))
+				{
+					return WeightedNorm(tmp.correction, currentY, tmp.nextY);
+				}
+			}
+			return WeightedNorm(tmp.residual, currentY, tmp.nextY);
+		}
+
+	public:
+		template<typename TransientProblemType>
+		[[nodiscard]] OutputInfo Solve(ParameterType firstX, ParameterType lastX, TransientProblemType& problem,
+			ImplicitProblemType& implicitProblem) const noexcept
+		{
+			static_assert(CheckDiagonal(), "Diagonal coefficients of implicit tableau must be zero or equal to DiagonalCoefficient.");
+			AssertE(problem.DOFCount() == implicitProblem.DOFCount(), MessageTag::TransientSolver,
+				"Transient and implicit problems must have the same variables.");
+			problem.SetTime(firstX);
+			problem.CacheCurrent();
+
+			SolutionTemporaries tmp{ firstX, problem.DOFCount(), initialStep };
+			constexpr auto errorOrder = std::min(MethodDescriptor::AccuracyOrder, MethodDescriptor::CorrectionMethodsAccuracyOrders[0]);
+
+			std::chrono::high_resolution_clock clock;
+			Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::TransientSolver,
+				"Starting solution of transient problem using implicit Runge-Kutta method.\n");
+			const auto solutionStartTime = clock.now();
+
+			while (tmp.currentX < lastX)
+			{
+				Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::TransientSolver,
+					Format("Starting calculation of new step at time {}:", tmp.currentX));
+				const auto iterationStartTime = clock.now();
+				auto& currentY = problem.GetVariables().Flatten();
+
+				bool isSolved = UpdateIterationMatrix(tmp, currentY, problem, implicitProblem);
+				if (isSolved)
+				{
+					if constexpr (MethodDescriptor::IsLinearlyImplicit)
+					{
+						isSolved = ComputeRosenbrockStages(tmp, currentY, problem, implicitProblem);
+					}
+					else
+					{
+						isSolved = ComputeStages(tmp, currentY, problem, implicitProblem);
+					}
+				}
+
+				const auto step = tmp.currentStep;
+				ValueType stepScale = this->GetMinStepScale();
+				if (isSolved)
+				{
+					tmp.currentError = ComputeSolution(tmp, currentY);
+					stepScale = std::clamp(this->GetStepScaleFactor() * std::pow(tmp.currentError, ValueType(-1) / (errorOrder + 1)),
+						this->GetMinStepScale(), this->GetMaxStepScale());
+				}
+				tmp.currentStep *= stepScale;
+
+				if (!isSolved || tmp.currentError > this->GetMaxError())
+				{
+					Logger::Log(MessageType::Info, MessagePriority::Low, MessageTag::TransientSolver,
+						isSolved
+							? "Error overflow on implicit Runge-Kutta step, trying again with lower step..."
+							: "Stage equations are not solved on implicit Runge-Kutta step, trying again with lower step...");
+					if (exitConditions & RKExitConditions::StepUnderflow && std::abs(tmp.currentStep) <= std::abs(this->GetMinStep()))
+					{
+						Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::TransientSolver,
+							Format("Stopping implicit Runge-Kutta solver due to step {} decreased below limit {} at time {}.", tmp.currentStep, this->GetMinStep(), tmp.currentX));
+						return OutputInfo{ false, OutputInfo::OutputReason::StepUnderflow, tmp.stepCount };
+					}
+					continue;
+				}
+
+				++tmp.stepCount;
+				tmp.isJacobianActual = false;
+				problem.SwapVariables(tmp.nextY);
+				tmp.currentX += step;
+				problem.SetTime(tmp.currentX);
+
+				if (exitConditions & RKExitConditions::StepUnderflow && std::abs(tmp.currentStep) <= std::abs(this->GetMinStep()))
+				{
+					Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::TransientSolver,
+						Format("Stopping implicit Runge-Kutta solver due to step {} decreased below limit {} at time {}.", tmp.currentStep, this->GetMinStep(), tmp.currentX));
+					return OutputInfo{ false, OutputInfo::OutputReason::StepUnderflow, tmp.stepCount };
+				}
+				if (exitConditions & RKExitConditions::SolutionNormOverflow && Norm2(problem.GetVariables().Flatten()) >= maxSolutionNorm)
+				{
+					Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::TransientSolver,
+						Format("Stopping implicit Runge-Kutta solver due to solution norm overflow at time {}.", tmp.currentX));
+					return OutputInfo{ false, OutputInfo::OutputReason::SolutionNormOverflow, tmp.stepCount };
+				}
+				if (exitConditions & RKExitConditions::StepCountLimitReached && tmp.stepCount >= stepCountLimit)
+				{
+					Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::TransientSolver,
+						Format("Stopping implicit Runge-Kutta solver due to reaching maximum number of time steps {} at time {}.", stepCountLimit, tmp.currentX));
+					return OutputInfo{ false, OutputInfo::OutputReason::StepCountLimitReached, tmp.stepCount };
+				}
+				if (std::abs(lastX - tmp.currentX) < std::abs(tmp.currentStep))
+				{
+					tmp.currentStep = lastX - tmp.currentX;
+				}
+				problem.CacheCurrent();
+
+				Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::TransientSolver,
+					Format("Finishing transient problem time step {} at time {} successfully in {}.", tmp.stepCount, tmp.currentX, clock.now() - iterationStartTime));
+			}
+
+			Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::TransientSolver,
+				Format("Finishing transient problem solution successfully after {} steps in {}.", tmp.stepCount, clock.now() - solutionStartTime));
+
+			return OutputInfo{ true, OutputInfo::OutputReason::Success, tmp.stepCount };
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,263 @@
+#pragma once
+
+#include "Math/Native/FusedVectorOperations.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace CESDSOL
+{
+	// Parallel kernels combining Runge-Kutta stages. Tableau is passed as template argument, so every row gets its own
+	// kernel with the sum over stages unrolled and terms with zero coefficients dropped at compile time. Vectors are
+	// processed by chunks in parallel, each element is loaded and stored once per kernel. Terms are not summed in the
+	// order of plain serial loops, so results may differ from them by rounding, but errors are reduced in fixed chunk
+	// order, so step sequences do not depend on the number of threads.
+	namespace Detail
+	{
+		template<const auto& Table>
+		inline constexpr size_t TableRowCount = std::tuple_size_v<std::remove_cvref_t<decltype(Table)>>;
+
+		// Indices k < Count satisfying the predicate and their number.
+		template<size_t Count, typename PredicateType>
+		[[nodiscard]] constexpr std::pair<std::array<size_t, Count>, size_t> SelectIndices(PredicateType predicate) noexcept
+		{
+			std::pair<std::array<size_t, Count>, size_t> result{};
+			for (size_t k = 0; k < Count; ++k)
+			{
+				if (predicate(k))
+				{
+					result.first[result.second++] = k;
+				}
+			}
+			return result;
+		}
+
+		template<const auto& Table, size_t Row, size_t TermCount>
+		inline constexpr auto NonZeroCoefficients = SelectIndices<TermCount>([](size_t k)
+			{
+				return Table[Row][k] != 0;
+			});
+
+		template<const auto& Table, size_t RowCount>
+		inline constexpr auto NonZeroRows = SelectIndices<RowCount>([](size_t k)
+			{
+				return std::any_of(Table[k].begin(), Table[k].end(), [](double value) { return value != 0; });
+			});
+
+		// Sum of Table[Row][k] * terms[k][i] over k < TermCount.
+		template<const auto& Table, size_t Row, size_t TermCount, typename ValueType, size_t TermArraySize>
+		[[nodiscard]] ValueType CombineTerms(const std::array<const ValueType*, TermArraySize>& terms, size_t i) noexcept
+		{
+			constexpr auto& selection = NonZeroCoefficients<Table, Row, TermCount>;
+			return[&]<size_t... I>(std::index_sequence<I...>)
+			{
+				if constexpr (sizeof...(I) == 0)
+				{
+					return ValueType(0);
+				}
+				else
+				{
+					return (... + (static_cast<ValueType>(Table[Row][selection.first[I]]) * terms[selection.first[I]][i]));
+				}
+			}(std::make_index_sequence<selection.second>());
+		}
+
+		template<typename ValueType>
+		[[nodiscard]] constexpr ValueType Square(ValueType value) noexcept
+		{
+			return value * value;
+		}
+
+		// Squared weighted errors of embedded methods at element i.
+		template<const auto& ErrorTable, size_t ErrorTermCount, typename ValueType, size_t TermArraySize>
+		void AccumulateErrors(const std::array<const ValueType*, TermArraySize>& terms, ValueType weight, size_t i,
+			std::array<ValueType, TableRowCount<ErrorTable>>& errors) noexcept
+		{
+			[&]<size_t... E>(std::index_sequence<E...>)
+			{
+				((errors[E] += Square(CombineTerms<ErrorTable, E, ErrorTermCount>(terms, i) / weight)), ...);
+			}(std::make_index_sequence<TableRowCount<ErrorTable>>());
+		}
+
+		// Reduction which keeps partial results of every chunk and sums them in chunk order, unlike
+		// Native::Detail::Reduce, so that the result does not depend on the number of threads and scheduling.
+		template<typename ValueType, size_t ResultCount, typename BodyType>
+		[[nodiscard]] std::array<ValueType, ResultCount> OrderedReduce(size_t count, BodyType&& body) noexcept
+		{
+			auto partials = std::vector<std::array<ValueType, ResultCount>>(Native::Detail::ChunkCount(count));
+			ParallelBlock([&]()
+				{
+					Native::Detail::ForEachChunk(count, [&](size_t begin, size_t end)
+						{
+							body(begin, end, partials[begin / Native::FusedKernelChunkSize]);
+						});
+				});
+			std::array<ValueType, ResultCount> result{};
+			for (const auto& partial : partials)
+			{
+				for (size_t i = 0; i < ResultCount; ++i)
+				{
+					result[i] += partial[i];
+				}
+			}
+			return result;
+		}
+
+		// Register of low-storage scheme after the stage, it is overwritten on the first stage, so its previous content
+		// is never read.
+		template<size_t Stage, typename ValueType>
+		[[nodiscard]] ValueType LowStorageAccumulate(ValueType coefficient, ValueType value, ValueType term) noexcept
+		{
+			if constexpr (Stage == 0)
+			{
+				return term;
+			}
+			else
+			{
+				return coefficient * value + term;
+			}
+		}
+	}
+
+	// y = x + step * sum(Table[Row][k] * terms[k]) for k < TermCount.
+	template<const auto& Table, size_t Row, size_t TermCount, typename ValueType, size_t TermArraySize>
+	void RungeKuttaStageUpdate(const std::array<const ValueType*, TermArraySize>& terms, const ValueType* x,
+		ValueType step, ValueType* y, size_t count) noexcept
+	{
+		ParallelBlock([&]()
+			{
+				Native::Detail::ForEachChunk(count, [&](size_t begin, size_t end)
+					{
+						for (size_t i = begin; i < end; ++i)
+						{
+							y[i] = x[i] + step * Detail::CombineTerms<Table, Row, TermCount>(terms, i);
+						}
+					});
+			});
+	}
+
+	// Returns sums of squared errors of embedded methods sum(ErrorTable[e][k] * terms[k]) for k < ErrorTermCount,
+	// weighted by absoluteTolerance + relativeTolerance * max(|x|, |y|).
+	template<const auto& ErrorTable, size_t ErrorTermCount, typename ValueType, size_t TermArraySize>
+	[[nodiscard]] auto RungeKuttaErrors(const std::array<const ValueType*, TermArraySize>& terms, const ValueType* x,
+		const ValueType* y, ValueType absoluteTolerance, ValueType relativeTolerance, size_t count) noexcept
+	{
+		return Detail::OrderedReduce<ValueType, Detail::TableRowCount<ErrorTable>>(count, [&](size_t begin, size_t end, auto& local)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const ValueType weight = absoluteTolerance + relativeTolerance * std::max(std::abs(x[i]), std::abs(y[i]));
+					Detail::AccumulateErrors<ErrorTable, ErrorTermCount>(terms, weight, i, local);
+				}
+			});
+	}
+
+	// Stage update fused with RungeKuttaErrors, for error estimates which do not use the derivative at the new point.
+	template<const auto& Table, size_t Row, const auto& ErrorTable, typename ValueType, size_t TermArraySize>
+	[[nodiscard]] auto RungeKuttaStageUpdateWithErrors(const std::array<const ValueType*, TermArraySize>& terms,
+		const ValueType* x, ValueType step, ValueType* y, ValueType absoluteTolerance, ValueType relativeTolerance,
+		size_t count) noexcept
+	{
+		static_assert(ErrorTable.front().size() == TermArraySize, "Error estimate must use only the given stages.");
+		return Detail::OrderedReduce<ValueType, Detail::TableRowCount<ErrorTable>>(count, [&](size_t begin, size_t end, auto& local)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					y[i] = x[i] + step * Detail::CombineTerms<Table, Row, TermArraySize>(terms, i);
+					const ValueType weight = absoluteTolerance + relativeTolerance * std::max(std::abs(x[i]), std::abs(y[i]));
+					Detail::AccumulateErrors<ErrorTable, TermArraySize>(terms, weight, i, local);
+				}
+			});
+	}
+
+	// y = x + step * sum(coefficients[k] * terms[k]) over rows k of Table which are not identically zero.
+	template<const auto& Table, typename ValueType, typename CoefficientType, size_t TermArraySize>
+	void RungeKuttaInterpolation(const std::array<const ValueType*, TermArraySize>& terms,
+		const std::array<CoefficientType, TermArraySize>& coefficients, const ValueType* x, ValueType step, ValueType* y,
+		size_t count) noexcept
+	{
+		constexpr auto& selection = Detail::NonZeroRows<Table, TermArraySize>;
+		ParallelBlock([&]()
+			{
+				Native::Detail::ForEachChunk(count, [&](size_t begin, size_t end)
+					{
+						for (size_t i = begin; i < end; ++i)
+						{
+							const ValueType sum = [&]<size_t... I>(std::index_sequence<I...>)
+							{
+								return (ValueType(0) + ... + (static_cast<ValueType>(coefficients[selection.first[I]]) * terms[selection.first[I]][i]));
+							}(std::make_index_sequence<selection.second>());
+							y[i] = x[i] + step * sum;
+						}
+					});
+			});
+	}
+
+	// Stage of low-storage scheme in 2N form: dq = A[Stage] * dq + step * f, y = x + B[Stage] * dq. x may coincide
+	// with y.
+	template<const auto& A, const auto& B, size_t Stage, typename ValueType>
+	void RungeKuttaLowStorageStage(const ValueType* f, ValueType step, ValueType* dq, const ValueType* x, ValueType* y,
+		size_t count) noexcept
+	{
+		ParallelBlock([&]()
+			{
+				Native::Detail::ForEachChunk(count, [&](size_t begin, size_t end)
+					{
+						for (size_t i = begin; i < end; ++i)
+						{
+							dq[i] = Detail::LowStorageAccumulate<Stage>(static_cast<ValueType>(A[Stage]), dq[i], step * f[i]);
+							y[i] = x[i] + static_cast<ValueType>(B[Stage]) * dq[i];
+						}
+					});
+			});
+	}
+
+	// RungeKuttaLowStorageStage accumulating the error of embedded method e += step * ErrorTable[0][Stage] * f in the
+	// third register. On the last stage returns its squared norm weighted as in RungeKuttaErrors with initial solution
+	// given separately, zero is returned on other stages.
+	template<const auto& A, const auto& B, const auto& ErrorTable, size_t Stage, typename ValueType>
+	[[nodiscard]] std::array<ValueType, 1> RungeKuttaLowStorageStageWithErrors(const ValueType* f, ValueType step,
+		ValueType* dq, ValueType* e, const ValueType* x, ValueType* y, const ValueType* initial,
+		ValueType absoluteTolerance, ValueType relativeTolerance, size_t count) noexcept
+	{
+		static_assert(Detail::TableRowCount<ErrorTable> == 1, "Low-storage schemes support only one embedded method.");
+		const auto update = [&](size_t i)
+		{
+			const ValueType term = step * f[i];
+			dq[i] = Detail::LowStorageAccumulate<Stage>(static_cast<ValueType>(A[Stage]), dq[i], term);
+			y[i] = x[i] + static_cast<ValueType>(B[Stage]) * dq[i];
+			e[i] = Detail::LowStorageAccumulate<Stage>(ValueType(1), e[i], static_cast<ValueType>(ErrorTable[0][Stage]) * term);
+		};
+		if constexpr (Stage + 1 < B.size())
+		{
+			ParallelBlock([&]()
+				{
+					Native::Detail::ForEachChunk(count, [&](size_t begin, size_t end)
+						{
+							for (size_t i = begin; i < end; ++i)
+							{
+								update(i);
+							}
+						});
+				});
+			return {};
+		}
+		else
+		{
+			return Detail::OrderedReduce<ValueType, 1>(count, [&](size_t begin, size_t end, auto& local)
+				{
+					for (size_t i = begin; i < end; ++i)
+					{
+						update(i);
+						const ValueType weight = absoluteTolerance + relativeTolerance * std::max(std::abs(initial[i]), std::abs(y[i]));
+						local[0] += Detail::Square(e[i] / weight);
+					}
+				});
+		}
+	}
+}
\ No newline at end of file
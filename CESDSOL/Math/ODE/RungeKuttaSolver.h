@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Math/LinearAlgebra.h"
+#include "Math/ODE/RungeKuttaKernels.h"
 
 namespace CESDSOL
 {
@@ -63,6 +64,22 @@ namespace CESDSOL
 		};
 
 	private:
+		// Low-storage schemes are given by coefficients of 2N form instead of Butcher tableau, they keep the solution, the
+		// increment and the error of embedded method instead of all stages.
+		[[nodiscard]] static constexpr bool CheckLowStorage() noexcept
+		{
+			if constexpr (requires { MethodDescriptor::IsLowStorage; })
+			{
+				return MethodDescriptor::IsLowStorage;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		static constexpr bool IsLowStorage = CheckLowStorage();
+
 		struct SolutionTemporaries
 		{
 			size_t stepCount = 0;
@@ -71,24 +88,39 @@ namespace CESDSOL
 			ParameterType previousX;
 			ParameterType currentStep;
 			ParameterType previousStep;
-			Vector<ValueType> currentY;
+			// Current solution is kept in variables of the problem, buffers are exchanged with it and with its equations
+			// in O(1), so stages are computed without copying.
 			Vector<ValueType> previousY;
 			ValueType currentError = 1;
 			ValueType previousError;
 			Vector<ValueType> currentEquations;
-			Vector<ValueType> previousEquations;
 
 			std::array<Vector<ValueType>, MethodDescriptor::StepCount> stepArrays;
 
-			SolutionTemporaries(ParameterType firstX, const Vector<ValueType>& firstY, ParameterType aInitialStep)
+			// Registers of low-storage schemes, stages and equations above are not allocated for them.
+			Vector<ValueType> increment;
+			Vector<ValueType> errorRegister;
+
+			SolutionTemporaries(ParameterType firstX, size_t dofCount, ParameterType aInitialStep)
 				: currentX(firstX)
 				, currentStep(aInitialStep)
-				, currentY(firstY)
-				, previousEquations(firstY.size())
+				, previousY(dofCount)
 			{
-				for (auto& stepArray : stepArrays)
+				if constexpr (IsLowStorage)
 				{
-					stepArray = Vector<ValueType>(currentY.size());
+					increment = Vector<ValueType>(dofCount);
+					if constexpr (ActualUseAdaptive)
+					{
+						errorRegister = Vector<ValueType>(dofCount);
+					}
+				}
+				else
+				{
+					currentEquations = Vector<ValueType>(dofCount);
+					for (auto& stepArray : stepArrays)
+					{
+						stepArray = Vector<ValueType>(dofCount);
+					}
 				}
 			}
 		};
@@ -119,16 +151,48 @@ namespace CESDSOL
 				return result;
 			}
 
+			static constexpr size_t TermCount = MethodDescriptor::StepCount + MethodDescriptor::DenseOutputStepCount + 1;
+
 			std::array<Vector<ValueType>, MethodDescriptor::DenseOutputStepCount> additionalSteps;
+			// Holds the current solution while variables of the problem are used for interpolation.
+			Vector<ValueType> currentY;
 			size_t currentGridIndex = 0;
 
+			// Stages, derivative at the new point and additional stages in the order of dense output tableau columns.
+			[[nodiscard]] auto GetTerms(const SolutionTemporaries& tmp) const noexcept
+			{
+				std::array<const ValueType*, TermCount> result;
+				for (size_t k = 0; k < MethodDescriptor::StepCount; ++k)
+				{
+					result[k] = tmp.stepArrays[k].data();
+				}
+				result[MethodDescriptor::StepCount] = tmp.currentEquations.data();
+				for (size_t k = 0; k < MethodDescriptor::DenseOutputStepCount; ++k)
+				{
+					result[MethodDescriptor::StepCount + 1 + k] = additionalSteps[k].data();
+				}
+				return result;
+			}
+
+			template<size_t Step>
+			void ComputeAdditionalStep(const SolutionTemporaries& tmp, ProblemType& problem)
+			{
+				RungeKuttaStageUpdate<MethodDescriptor::DenseOutputButcherTableauMainPart, Step, MethodDescriptor::StepCount + 1 + Step>(
+					GetTerms(tmp), tmp.previousY.data(), static_cast<ValueType>(tmp.previousStep),
+					problem.GetVariables().Flatten().data(), problem.DOFCount());
+				problem.SetTime(tmp.previousX + MethodDescriptor::DenseOutputButcherTableauFirstColumn[Step] * tmp.previousStep);
+				problem.SetVariablesUpdated();
+				problem.TakeEquations(additionalSteps[Step]);
+			}
+
 		public:
 			DenseOutputImpl(const SolutionTemporaries& tmp)
 			{
 				for (auto& step : additionalSteps)
 				{
-					step = Vector<typename ProblemType::FieldType>(tmp.currentY.size());
+					step = Vector<typename ProblemType::FieldType>(tmp.previousY.size());
 				}
+				currentY = Vector<ValueType>(tmp.previousY.size());
 			}
 
 			void Process(SolutionTemporaries& tmp, ParameterType denseOutputStep, ParameterType firstX,
@@ -138,52 +202,29 @@ namespace CESDSOL
 
 				if (nextGridIndex > currentGridIndex)
 				{
+					problem.SwapVariables(currentY);
 					if constexpr (MethodDescriptor::DenseOutputStepCount > 0)
 					{
-						for (size_t i = 0; i < MethodDescriptor::DenseOutputStepCount; i++)
+						[&]<size_t... I>(std::index_sequence<I...>)
 						{
-							for (size_t j = 0; j < problem.DOFCount(); j++)
-							{
-								ValueType sum = MethodDescriptor::DenseOutputButcherTableauMainPart[i][MethodDescriptor::StepCount] * tmp.currentEquations[j];
-								for (size_t k = 0; k < MethodDescriptor::StepCount; k++)
-								{
-									sum += MethodDescriptor::DenseOutputButcherTableauMainPart[i][k] * tmp.stepArrays[k][j];
-								}
-								for (size_t k = 0; k < i; ++k)
-								{
-									sum += MethodDescriptor::DenseOutputButcherTableauMainPart[i][k + MethodDescriptor::StepCount + 1] * additionalSteps[k][j];
-								}
-								problem.GetVariables().Flatten()[j] = tmp.previousY[j] + tmp.previousStep * sum;
-							}
-							problem.SetTime(tmp.previousX + MethodDescriptor::DenseOutputButcherTableauFirstColumn[i] * tmp.previousStep);
-							problem.SetVariablesUpdated();
-							additionalSteps[i] = problem.GetEquations().Flatten();
-						}
+							(ComputeAdditionalStep<I>(tmp, problem), ...);
+						}(std::make_index_sequence<MethodDescriptor::DenseOutputStepCount>());
 					}
 					
+					auto& variables = problem.GetVariables().Flatten();
+					const auto terms = GetTerms(tmp);
 					while (currentGridIndex < nextGridIndex)
 					{
 						currentGridIndex++;
 						const auto theta = (firstX + denseOutputStep * currentGridIndex - tmp.previousX) / tmp.previousStep;
-						const auto coefficients = ComputePolynomialCoefficients(theta);
-						for (size_t equationIndex = 0; equationIndex < problem.DOFCount(); ++equationIndex)
-						{
-							ValueType sum = tmp.currentEquations[equationIndex] * coefficients[MethodDescriptor::StepCount];
-							for (size_t stepIndex = 0; stepIndex < MethodDescriptor::StepCount; ++stepIndex)
-							{
-								sum += tmp.stepArrays[stepIndex][equationIndex] * coefficients[stepIndex];
-							}
-							for (size_t stepIndex = 0; stepIndex < MethodDescriptor::DenseOutputStepCount; ++stepIndex)
-							{
-								sum += additionalSteps[stepIndex][equationIndex] * coefficients[stepIndex + MethodDescriptor::StepCount + 1];
-							}
-							problem.GetVariables().Flatten()[equationIndex] = tmp.previousY[equationIndex] + tmp.previousStep * sum;
-						}
+						RungeKuttaInterpolation<MethodDescriptor::DenseOutputCoefficients>(terms, ComputePolynomialCoefficients(theta),
+							tmp.previousY.data(), static_cast<ValueType>(tmp.previousStep), variables.data(), problem.DOFCount());
 						problem.SetTime(firstX + denseOutputStep * currentGridIndex);
 						problem.CacheCurrent();
 					}
 
 					problem.SetTime(tmp.currentX);
+					problem.SwapVariables(currentY);
 				}					
 			}
 		};
@@ -191,6 +232,110 @@ namespace CESDSOL
 		template<typename ProblemType>
 		using DenseOutput = DenseOutputImpl<ProblemType, ActualUseDenseOutput>;
 
+		[[nodiscard]] static constexpr size_t GetErrorEstimateCount() noexcept
+		{
+			if constexpr (ActualUseAdaptive)
+			{
+				return MethodDescriptor::CorrectionMethodsCount;
+			}
+			else
+			{
+				return 0;
+			}
+		}
+
+		// Error estimates not using the derivative at the new point are computed in the pass of the last stage.
+		[[nodiscard]] static constexpr bool CheckErrorFused() noexcept
+		{
+			if constexpr (ActualUseAdaptive)
+			{
+				return MethodDescriptor::ButcherTableauErrorRow.front().size() == MethodDescriptor::StepCount;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		static constexpr size_t ErrorEstimateCount = GetErrorEstimateCount();
+		static constexpr bool IsErrorFused = CheckErrorFused();
+
+		// Stage index is a template argument, so each stage uses its own kernel with tableau row fused in.
+		template<size_t Stage, typename ProblemType>
+		void ComputeStage(SolutionTemporaries& tmp, ProblemType& problem, std::array<ValueType, ErrorEstimateCount>& error) const noexcept
+		{
+			std::array<const ValueType*, MethodDescriptor::StepCount> terms;
+			for (size_t k = 0; k < MethodDescriptor::StepCount; ++k)
+			{
+				terms[k] = tmp.stepArrays[k].data();
+			}
+			auto& variables = problem.GetVariables().Flatten();
+			const auto step = static_cast<ValueType>(tmp.currentStep);
+			if constexpr (Stage == MethodDescriptor::StepCount && IsErrorFused)
+			{
+				error = RungeKuttaStageUpdateWithErrors<MethodDescriptor::ButcherTableauMainPart, Stage, MethodDescriptor::ButcherTableauErrorRow>(
+					terms, tmp.previousY.data(), step, variables.data(), this->GetAbsoluteTolerance(), this->GetRelativeTolerance(),
+					problem.DOFCount());
+			}
+			else
+			{
+				RungeKuttaStageUpdate<MethodDescriptor::ButcherTableauMainPart, Stage, Stage>(terms, tmp.previousY.data(), step,
+					variables.data(), problem.DOFCount());
+			}
+			problem.SetVariablesUpdated();
+			if constexpr (Stage != MethodDescriptor::StepCount)
+			{
+				problem.SetTime(tmp.currentX + MethodDescriptor::ButcherTableauFirstColumn[Stage] * tmp.currentStep);
+				problem.TakeEquations(tmp.stepArrays[Stage]);
+			}
+			else
+			{
+				problem.SetTime(tmp.currentX + tmp.currentStep);
+				problem.TakeEquations(tmp.currentEquations);
+			}
+		}
+
+		// Stages of low-storage schemes update the solution in the variables of the problem in place. The first one
+		// writes to previousY, which is then exchanged with the variables, so the solution at the beginning of the step
+		// is kept there for the error estimate and rejection.
+		template<size_t Stage, typename ProblemType>
+		void ComputeLowStorageStage(SolutionTemporaries& tmp, ProblemType& problem, std::array<ValueType, ErrorEstimateCount>& error) const noexcept
+		{
+			problem.SetTime(tmp.currentX + MethodDescriptor::ButcherTableauFirstColumn[Stage] * tmp.currentStep);
+			const auto& equations = problem.GetEquations().Flatten();
+			auto& variables = problem.GetVariables().Flatten();
+			const auto step = static_cast<ValueType>(tmp.currentStep);
+			auto* const y = Stage == 0 ? tmp.previousY.data() : variables.data();
+			if constexpr (ActualUseAdaptive)
+			{
+				const auto stageError = RungeKuttaLowStorageStageWithErrors<MethodDescriptor::LowStorageA, MethodDescriptor::LowStorageB,
+					MethodDescriptor::ButcherTableauErrorRow, Stage>(equations.data(), step, tmp.increment.data(), tmp.errorRegister.data(),
+					variables.data(), y, Stage == 0 ? variables.data() : tmp.previousY.data(), static_cast<ValueType>(this->GetAbsoluteTolerance()),
+					static_cast<ValueType>(this->GetRelativeTolerance()), problem.DOFCount());
+				if constexpr (Stage + 1 == MethodDescriptor::StepCount)
+				{
+					error = stageError;
+				}
+			}
+			else
+			{
+				RungeKuttaLowStorageStage<MethodDescriptor::LowStorageA, MethodDescriptor::LowStorageB, Stage>(equations.data(), step,
+					tmp.increment.data(), variables.data(), y, problem.DOFCount());
+			}
+			if constexpr (Stage == 0)
+			{
+				problem.SwapVariables(tmp.previousY);
+			}
+			else
+			{
+				problem.SetVariablesUpdated();
+			}
+			if constexpr (Stage + 1 == MethodDescriptor::StepCount)
+			{
+				problem.SetTime(tmp.currentX + tmp.currentStep);
+			}
+		}
+
 	public:
 		template<typename ProblemType>
 		[[nodiscard]] OutputInfo Solve(ParameterType firstX, ParameterType lastX, ProblemType& problem) const noexcept
@@ -198,7 +343,7 @@ namespace CESDSOL
 			problem.SetTime(firstX);
 			problem.CacheCurrent();
 
-			SolutionTemporaries tmp{ firstX, problem.GetVariables().Flatten(), initialStep };
+			SolutionTemporaries tmp{ firstX, problem.DOFCount(), initialStep };
 			DenseOutput<ProblemType> denseOutput{ tmp };
 
 			std::chrono::high_resolution_clock clock;
@@ -206,61 +351,49 @@ namespace CESDSOL
 				"Starting solution of transient problem using Runge-Kutta method.\n");
 			const auto solutionStartTime = clock.now();
 
-			tmp.currentEquations = problem.GetEquations().Flatten();
+			if constexpr (!IsLowStorage)
+			{
+				problem.TakeEquations(tmp.currentEquations);
+			}
 			while (tmp.currentX < lastX)
 			{
 				Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::TransientSolver,
 					Format("Starting calculation of new step at time {}:", tmp.currentX));
 				const auto iterationStartTime = clock.now();
-				tmp.stepArrays[0] = tmp.currentEquations;
-				tmp.previousY = std::move(tmp.currentY);
 				tmp.previousError = tmp.currentError;
 				tmp.previousStep = tmp.currentStep;
-				for (size_t i = 1; i <= MethodDescriptor::StepCount; i++)
+				std::array<ValueType, ErrorEstimateCount> error{};
+				if constexpr (IsLowStorage)
 				{
-					for (size_t j = 0; j < problem.DOFCount(); j++)
+					[&]<size_t... I>(std::index_sequence<I...>)
 					{
-						ValueType sum = 0;
-						for (size_t k = 0; k < i; k++)
-						{
-							sum += MethodDescriptor::ButcherTableauMainPart[i][k] * tmp.stepArrays[k][j];
-						}
-						problem.GetVariables().Flatten()[j] = tmp.previousY[j] + tmp.currentStep * sum;
-					}
-					problem.SetVariablesUpdated();
-					if (i != MethodDescriptor::StepCount)
-					{
-						problem.SetTime(tmp.currentX + MethodDescriptor::ButcherTableauFirstColumn[i] * tmp.currentStep);
-						tmp.stepArrays[i] = problem.GetEquations().Flatten();
-					}
-					else
+						(ComputeLowStorageStage<I>(tmp, problem, error), ...);
+					}(std::make_index_sequence<MethodDescriptor::StepCount>());
+				}
+				else
+				{
+					std::swap(tmp.stepArrays[0], tmp.currentEquations);
+					problem.SwapVariables(tmp.previousY);
+					[&]<size_t... I>(std::index_sequence<I...>)
 					{
-						problem.SetTime(tmp.currentX + tmp.currentStep);
-						tmp.currentEquations = problem.GetEquations().Flatten();
-					}
+						(ComputeStage<I + 1>(tmp, problem, error), ...);
+					}(std::make_index_sequence<MethodDescriptor::StepCount>());
 				}
-				tmp.currentY = problem.GetVariables().Flatten();
 
 				bool canContinue = true;
 				if constexpr (ActualUseAdaptive)
 				{
-					std::array<ValueType, MethodDescriptor::CorrectionMethodsCount> error{};
-					for (size_t j = 0; j < problem.DOFCount(); j++)
+					if constexpr (!IsErrorFused)
 					{
-						ValueType errorTemp = this->GetAbsoluteTolerance() + this->GetRelativeTolerance() * std::max(std::abs(tmp.currentY[j]), std::abs(tmp.previousY[j]));
-						for (size_t i = 0; i < MethodDescriptor::CorrectionMethodsCount; i++)
+						std::array<const ValueType*, MethodDescriptor::StepCount + 1> terms;
+						for (size_t k = 0; k < MethodDescriptor::StepCount; ++k)
 						{
-							ValueType sum = 0;
-							for (size_t k = 0; k < MethodDescriptor::StepCount; k++)
-							{
-								sum += MethodDescriptor::ButcherTableauErrorRow[i][k] * tmp.stepArrays[k][j];
-							}
-							if constexpr (MethodDescriptor::ButcherTableauErrorRow.front().size() > MethodDescriptor::StepCount)
-							{
-								sum += MethodDescriptor::ButcherTableauErrorRow[i][MethodDescriptor::StepCount] * tmp.currentEquations[j];
-							}
-							error[i] += std::pow(sum / errorTemp, 2);
+							terms[k] = tmp.stepArrays[k].data();
 						}
+						terms[MethodDescriptor::StepCount] = tmp.currentEquations.data();
+						error = RungeKuttaErrors<MethodDescriptor::ButcherTableauErrorRow, MethodDescriptor::ButcherTableauErrorRow.front().size()>(
+							terms, tmp.previousY.data(), problem.GetVariables().Flatten().data(), this->GetAbsoluteTolerance(), this->GetRelativeTolerance(),
+							problem.DOFCount());
 					}
 					for (auto& item : error)
 					{
@@ -292,9 +425,12 @@ namespace CESDSOL
 					{
 						Logger::Log(MessageType::Info, MessagePriority::Low, MessageTag::TransientSolver,
 							"Error overflow on Runge-Kutta step, trying again with lower step...");
-						tmp.currentY = std::move(tmp.previousY);
+						problem.SwapVariables(tmp.previousY);
 						tmp.currentError = tmp.previousError;
-						tmp.currentEquations = std::move(tmp.previousEquations);
+						if constexpr (!IsLowStorage)
+						{
+							std::swap(tmp.currentEquations, tmp.stepArrays[0]);
+						}
 						canContinue = false;
 					}
 				}
@@ -312,7 +448,7 @@ namespace CESDSOL
 							return OutputInfo{ false, OutputInfo::OutputReason::StepUnderflow, tmp.stepCount };
 						}
 					}
-					if (exitConditions & RKExitConditions::SolutionNormOverflow && Norm2(tmp.currentY) >= maxSolutionNorm)
+					if (exitConditions & RKExitConditions::SolutionNormOverflow && Norm2(problem.GetVariables().Flatten()) >= maxSolutionNorm)
 					{
 						Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::TransientSolver,
 							Format("Stopping Runge-Kutta solver due to solution norm overflow at time {}.", tmp.currentX));
@@ -325,7 +461,6 @@ namespace CESDSOL
 						return OutputInfo{ false, OutputInfo::OutputReason::StepCountLimitReached, tmp.stepCount };
 					}
 					tmp.previousX = tmp.currentX;
-					tmp.previousEquations = tmp.currentEquations;
 					tmp.currentX += tmp.previousStep;
 
 					if (std::abs(lastX - tmp.currentX) < std::abs(tmp.currentStep))
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "Math/LinearAlgebra.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace CESDSOL
+{
+	// Symplectic splitting solver for equations of second order in time, reduced to the first order as f' = v,
+	// v' = F(t, f). Fields are given by pairs of position f and velocity v, equations of positions are not evaluated,
+	// positions are advanced by velocities directly, and equations of velocities must not depend on velocities. The step
+	// alternates kicks v += KickCoefficients[i] * h * F and drifts f += DriftCoefficients[i] * h * v, so methods are
+	// Runge-Kutta-Nystrom methods which preserve the symplectic structure. Force at the end of the step is reused at
+	// the beginning of the next one, so the step takes StepCount evaluations of equations instead of twice the number of
+	// stages for the first order system. The step is fixed, since variable step destroys symplecticity and with it
+	// bounded energy error on long runs.
+	template<typename MethodDescriptor, typename ParameterType = double, typename ValueType = double>
+	class SymplecticSolver
+	{
+	public:
+		MakeProperty(step, Step, ParameterType, 1e-3);
+		// Every cacheInterval-th step is cached, the last step is always cached.
+		MakeProperty(cacheInterval, CacheInterval, size_t, 1);
+		MakeProperty(maxSolutionNorm, MaxSolutionNorm, ValueType, 1e20);
+
+		struct OutputInfo
+		{
+			enum class OutputReason
+			{
+				Success,
+				SolutionNormOverflow
+			};
+
+			bool success;
+			OutputReason reason;
+			size_t stepCount;
+		};
+
+		// Pairs are indices of position and velocity fields.
+		SymplecticSolver(Array<std::pair<size_t, size_t>> aFieldPairs) noexcept
+			: fieldPairs(std::move(aFieldPairs))
+		{}
+
+	private:
+		Array<std::pair<size_t, size_t>> fieldPairs;
+
+		// Velocities += coefficient * forces.
+		void Kick(const ValueType* forces, ValueType* variables, ValueType coefficient, size_t pointCount) const noexcept
+		{
+			for (const auto& [position, velocity] : fieldPairs)
+			{
+				const size_t offset = velocity * pointCount;
+				ParallelFor(0, pointCount, [&](int64_t i)
+					{
+						variables[offset + i] += coefficient * forces[offset + i];
+					});
+			}
+		}
+
+		// Positions += coefficient * velocities.
+		void Drift(ValueType* variables, ValueType coefficient, size_t pointCount) const noexcept
+		{
+			for (const auto& [position, velocity] : fieldPairs)
+			{
+				const size_t positionOffset = position * pointCount;
+				const size_t velocityOffset = velocity * pointCount;
+				ParallelFor(0, pointCount, [&](int64_t i)
+					{
+						variables[positionOffset + i] += coefficient * variables[velocityOffset + i];
+					});
+			}
+		}
+
+	public:
+		template<typename ProblemType>
+		[[nodiscard]] OutputInfo Solve(ParameterType firstX, ParameterType lastX, ProblemType& problem) const noexcept
+		{
+			const size_t pointCount = problem.GetGrid().GetSize();
+			AssertE(2 * fieldPairs.size() * pointCount == problem.DOFCount(), MessageTag::TransientSolver,
+				"Every variable of the problem must be position or velocity of one field pair.");
+
+			problem.SetTime(firstX);
+			problem.CacheCurrent();
+
+			auto forces = Vector<ValueType>(problem.DOFCount());
+			bool isForceActual = false;
+			ParameterType currentX = firstX;
+			size_t stepCount = 0;
+			// Times of steps are computed from their number instead of accumulated, and the step which ends within
+			// rounding tolerance of lastX is the last one, so that rounding does not add a tiny step at the end.
+			const ParameterType timeTolerance = 8 * std::numeric_limits<ParameterType>::epsilon()
+				* std::max(std::abs(firstX), std::abs(lastX));
+
+			std::chrono::high_resolution_clock clock;
+			Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::TransientSolver,
+				"Starting solution of transient problem using symplectic method.\n");
+			const auto solutionStartTime = clock.now();
+
+			while (currentX < lastX)
+			{
+				Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::TransientSolver,
+					Format("Starting calculation of new step at time {}:", currentX));
+				const auto iterationStartTime = clock.now();
+				const ParameterType nextX = firstX + static_cast<ParameterType>(stepCount + 1) * step;
+				const bool isLastStep = nextX >= lastX - timeTolerance;
+				const ParameterType currentStep = isLastStep ? lastX - currentX : step;
+				ParameterType stageX = currentX;
+				auto& variables = problem.GetVariables().Flatten();
+				for (size_t stage = 0; stage <= MethodDescriptor::StepCount; ++stage)
+				{
+					if (MethodDescriptor::KickCoefficients[stage] != 0)
+					{
+						if (!isForceActual)
+						{
+							problem.SetTime(stageX);
+							problem.TakeEquations(forces);
+							isForceActual = true;
+						}
+						Kick(forces.data(), variables.data(), static_cast<ValueType>(MethodDescriptor::KickCoefficients[stage] * currentStep),
+							pointCount);
+						problem.SetVariablesUpdated();
+					}
+					if (stage < MethodDescriptor::StepCount)
+					{
+						const auto driftStep = MethodDescriptor::DriftCoefficients[stage] * currentStep;
+						Drift(variables.data(), static_cast<ValueType>(driftStep), pointCount);
+						problem.SetVariablesUpdated();
+						stageX += driftStep;
+						isForceActual = false;
+					}
+				}
+				currentX = isLastStep ? lastX : nextX;
+				problem.SetTime(currentX);
+				++stepCount;
+
+				if (Norm2(variables) >= maxSolutionNorm)
+				{
+					Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::TransientSolver,
+						Format("Stopping symplectic solver due to solution norm overflow at time {}.", currentX));
+					return OutputInfo{ false, OutputInfo::OutputReason::SolutionNormOverflow, stepCount };
+				}
+				if (stepCount % cacheInterval == 0 || currentX >= lastX)
+				{
+					problem.CacheCurrent();
+				}
+
+				Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::TransientSolver,
+					Format("Finishing transient problem time step {} at time {} successfully in {}.", stepCount, currentX, clock.now() - iterationStartTime));
+			}
+
+			Logger::Log(MessageType::Info, MessagePriority::High, MessageTag::TransientSolver,
+				Format("Finishing transient problem solution successfully after {} steps in {}.", stepCount, clock.now() - solutionStartTime));
+
+			return OutputInfo{ true, OutputInfo::OutputReason::Success, stepCount };
+		}
+	};
+}
\ No newline at end of file
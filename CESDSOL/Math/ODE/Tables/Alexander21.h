@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+
+namespace CESDSOL
+{
+	// Two-stage L-stable SDIRK method of R. Alexander, Diagonally implicit Runge-Kutta methods for stiff ODEs, 1977,
+	// with diagonal coefficient 1 - 1 / sqrt(2). Embedded method is the implicit Euler step from the first stage.
+	struct Alexander21
+	{
+		static constexpr size_t AccuracyOrder = 2;
+		static constexpr bool IsLinearlyImplicit = false;
+		static constexpr bool IsIMEX = false;
+
+		static constexpr size_t StepCount = 2;
+		static constexpr double DiagonalCoefficient = 0.29289321881345248;
+		static constexpr std::array<double, StepCount> ButcherTableauFirstColumn =
+		{
+			0.29289321881345248,
+			1.
+		};
+		static constexpr std::array<std::array<double, StepCount>, StepCount + 1> ButcherTableauMainPart =
+		{ {
+			{ 0.29289321881345248 },
+			{ 0.70710678118654752, 0.29289321881345248 },
+			{ 0.70710678118654752, 0.29289321881345248 }
+		} };
+
+		static constexpr size_t CorrectionMethodsCount = 1;
+		static constexpr std::array<size_t, CorrectionMethodsCount> CorrectionMethodsAccuracyOrders = { 1 };
+		static constexpr std::array<std::array<double, StepCount>, CorrectionMethodsCount> ButcherTableauErrorRow =
+		{ {
+			{
+				-0.29289321881345248,
+				0.29289321881345248
+			}
+		} };
+	};
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+
+namespace CESDSOL
+{
+	// IMEX method ARS(2,2,2) of U. M. Ascher, S. J. Ruuth, R. J. Spiteri, Implicit-explicit Runge-Kutta methods for
+	// time-dependent partial differential equations, 1997: L-stable SDIRK for the implicit part and second order
+	// explicit method for the explicit part. Embedded methods take both parts from the second stage.
+	struct AscherRuuthSpiteri21
+	{
+		static constexpr size_t AccuracyOrder = 2;
+		static constexpr bool IsLinearlyImplicit = false;
+		static constexpr bool IsIMEX = true;
+
+		static constexpr size_t StepCount = 3;
+		static constexpr double DiagonalCoefficient = 0.29289321881345248;
+		static constexpr std::array<double, StepCount> ButcherTableauFirstColumn =
+		{
+			0.,
+			0.29289321881345248,
+			1.
+		};
+		static constexpr std::array<std::array<double, StepCount>, StepCount + 1> ButcherTableauMainPart =
+		{ {
+			{},
+			{ 0., 0.29289321881345248 },
+			{ 0., 0.70710678118654752, 0.29289321881345248 },
+			{ 0., 0.70710678118654752, 0.29289321881345248 }
+		} };
+		static constexpr std::array<std::array<double, StepCount>, StepCount + 1> ExplicitButcherTableauMainPart =
+		{ {
+			{},
+			{ 0.29289321881345248 },
+			{ -0.70710678118654752, 1.7071067811865475 },
+			{ -0.70710678118654752, 1.7071067811865475 }
+		} };
+
+		static constexpr size_t CorrectionMethodsCount = 1;
+		static constexpr std::array<size_t, CorrectionMethodsCount> CorrectionMethodsAccuracyOrders = { 1 };
+		static constexpr std::array<std::array<double, StepCount>, CorrectionMethodsCount> ButcherTableauErrorRow =
+		{ {
+			{
+				0.,
+				-0.29289321881345248,
+				0.29289321881345248
+			}
+		} };
+		static constexpr std::array<std::array<double, StepCount>, CorrectionMethodsCount> ExplicitButcherTableauErrorRow =
+		{ {
+			{
+				-0.70710678118654752,
+				0.70710678118654752,
+				0.
+			}
+		} };
+	};
+}
\ No newline at end of file
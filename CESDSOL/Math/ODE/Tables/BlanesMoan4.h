@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+
+namespace CESDSOL
+{
+	// Symplectic Runge-Kutta-Nystrom method SRKN6b of S. Blanes, P. C. Moan, Practical symplectic partitioned
+	// Runge-Kutta and Runge-Kutta-Nystrom methods, 2002. Much more accurate than Yoshida4 for the same number of
+	// force evaluations.
+	struct BlanesMoan4
+	{
+		static constexpr size_t AccuracyOrder = 4;
+
+		static constexpr size_t StepCount = 6;
+		static constexpr std::array<double, StepCount + 1> KickCoefficients =
+		{
+			0.0829844064174052,
+			0.396309801498368,
+			-0.0390563049223486,
+			0.11952419401315084,
+			-0.0390563049223486,
+			0.396309801498368,
+			0.0829844064174052
+		};
+		static constexpr std::array<double, StepCount> DriftCoefficients =
+		{
+			0.245298957184271,
+			0.604872665711080,
+			-0.35017162289535098,
+			-0.35017162289535098,
+			0.604872665711080,
+			0.245298957184271
+		};
+	};
+}
\ No newline at end of file
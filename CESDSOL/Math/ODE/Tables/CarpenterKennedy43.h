@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+
+namespace CESDSOL
+{
+	// Five-stage fourth order low-storage scheme of M. H. Carpenter, C. A. Kennedy, Fourth-order 2N-storage
+	// Runge-Kutta schemes, 1994 (solution 3), in 2N form:
+	// dq_i = LowStorageA[i] * dq_{i-1} + h * f(x + c_i * h, y), y += LowStorageB[i] * dq_i.
+	struct CarpenterKennedy43
+	{
+		static constexpr size_t AccuracyOrder = 4;
+		static constexpr bool IsExplicit = true;
+		static constexpr bool IsLowStorage = true;
+
+		static constexpr size_t StepCount = 5;
+		static constexpr std::array<double, StepCount> ButcherTableauFirstColumn =
+		{
+			0.,
+			0.14965902199922912,
+			0.37040095736420475,
+			0.6222557631344432,
+			0.95828213067469026
+		};
+		static constexpr std::array<double, StepCount> LowStorageA =
+		{
+			0.,
+			-0.41789047449985195,
+			-1.1921516946426769,
+			-1.6977846924715279,
+			-1.5141834442571558
+		};
+		static constexpr std::array<double, StepCount> LowStorageB =
+		{
+			0.14965902199922912,
+			0.37921031299962726,
+			0.82295502938698173,
+			0.69945045594912214,
+			0.15305724796815198
+		};
+
+		// Difference with the third order method using the same stages with the weight of the second stage set to zero,
+		// all its weights are positive.
+		static constexpr bool IsAdaptive = true;
+		static constexpr size_t CorrectionMethodsCount = 1;
+		static constexpr std::array<size_t, CorrectionMethodsCount> CorrectionMethodsAccuracyOrders = { 3 };
+		static constexpr std::array<std::array<double, StepCount>, CorrectionMethodsCount> ButcherTableauErrorRow =
+		{ {
+			{
+				-0.16033435641008234,
+				0.34474304234056707,
+				-0.24407312659415953,
+				0.054651527079573693,
+				0.0050129135841011242
+			}
+		} };
+
+		static constexpr bool IsDenseOutputSupported = false;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+
+namespace CESDSOL
+{
+	// TR-BDF2 written as L-stable ESDIRK method with the third order embedded method of M. E. Hosea, L. F. Shampine,
+	// Analysis and implementation of TR-BDF2, 1996. The first stage is explicit.
+	struct HoseaShampine23
+	{
+		static constexpr size_t AccuracyOrder = 2;
+		static constexpr bool IsLinearlyImplicit = false;
+		static constexpr bool IsIMEX = false;
+
+		static constexpr size_t StepCount = 3;
+		static constexpr double DiagonalCoefficient = 0.29289321881345248;
+		static constexpr std::array<double, StepCount> ButcherTableauFirstColumn =
+		{
+			0.,
+			0.58578643762690495,
+			1.
+		};
+		static constexpr std::array<std::array<double, StepCount>, StepCount + 1> ButcherTableauMainPart =
+		{ {
+			{},
+			{ 0.29289321881345248, 0.29289321881345248 },
+			{ 0.35355339059327376, 0.35355339059327376, 0.29289321881345248 },
+			{ 0.35355339059327376, 0.35355339059327376, 0.29289321881345248 }
+		} };
+
+		static constexpr size_t CorrectionMethodsCount = 1;
+		static constexpr std::array<size_t, CorrectionMethodsCount> CorrectionMethodsAccuracyOrders = { 3 };
+		static constexpr std::array<std::array<double, StepCount>, CorrectionMethodsCount> ButcherTableauErrorRow =
+		{ {
+			{
+				0.13807118745769835,
+				-0.33333333333333333,
+				0.19526214587563498
+			}
+		} };
+	};
+}
\ No newline at end of file
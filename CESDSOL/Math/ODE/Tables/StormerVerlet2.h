@@ -0,0 +1,23 @@
+#pragma once
+
+#include <array>
+
+namespace CESDSOL
+{
+	// Velocity form of Stormer-Verlet (leapfrog) method.
+	struct StormerVerlet2
+	{
+		static constexpr size_t AccuracyOrder = 2;
+
+		static constexpr size_t StepCount = 1;
+		static constexpr std::array<double, StepCount + 1> KickCoefficients =
+		{
+			0.5,
+			0.5
+		};
+		static constexpr std::array<double, StepCount> DriftCoefficients =
+		{
+			1.
+		};
+	};
+}
\ No newline at end of file
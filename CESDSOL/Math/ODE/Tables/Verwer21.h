@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+
+namespace CESDSOL
+{
+	// Rosenbrock-W method ROS2 of J. G. Verwer, E. J. Spee, J. G. Blom, W. Hundsdorfer, A second-order Rosenbrock
+	// method applied to photochemical dispersion problems, 1999. Second order for any approximation of the Jacobian,
+	// L-stable for the exact one. Embedded method is the linearly implicit Euler step from the first stage.
+	struct Verwer21
+	{
+		static constexpr size_t AccuracyOrder = 2;
+		static constexpr bool IsLinearlyImplicit = true;
+		static constexpr bool IsIMEX = false;
+
+		static constexpr size_t StepCount = 2;
+		static constexpr double DiagonalCoefficient = 1.7071067811865475;
+		static constexpr std::array<double, StepCount> ButcherTableauFirstColumn =
+		{
+			0.,
+			1.
+		};
+		static constexpr std::array<std::array<double, StepCount>, StepCount + 1> ButcherTableauMainPart =
+		{ {
+			{},
+			{ 1. },
+			{ 1.5, 0.5 }
+		} };
+		static constexpr std::array<std::array<double, StepCount>, StepCount> StageCouplingCoefficients =
+		{ {
+			{},
+			{ -2. }
+		} };
+
+		static constexpr size_t CorrectionMethodsCount = 1;
+		static constexpr std::array<size_t, CorrectionMethodsCount> CorrectionMethodsAccuracyOrders = { 1 };
+		static constexpr std::array<std::array<double, StepCount>, CorrectionMethodsCount> ButcherTableauErrorRow =
+		{ {
+			{
+				0.5,
+				0.5
+			}
+		} };
+	};
+}
\ No newline at end of file
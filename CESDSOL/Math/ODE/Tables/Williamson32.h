@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+
+namespace CESDSOL
+{
+	// Low-storage scheme of J. H. Williamson, Low-storage Runge-Kutta schemes, 1980, in 2N form:
+	// dq_i = LowStorageA[i] * dq_{i-1} + h * f(x + c_i * h, y), y += LowStorageB[i] * dq_i.
+	struct Williamson32
+	{
+		static constexpr size_t AccuracyOrder = 3;
+		static constexpr bool IsExplicit = true;
+		static constexpr bool IsLowStorage = true;
+
+		static constexpr size_t StepCount = 3;
+		static constexpr std::array<double, StepCount> ButcherTableauFirstColumn =
+		{
+			0.,
+			0.3333333333333333,
+			0.75
+		};
+		static constexpr std::array<double, StepCount> LowStorageA =
+		{
+			0.,
+			-0.5555555555555556,
+			-1.1953125
+		};
+		static constexpr std::array<double, StepCount> LowStorageB =
+		{
+			0.3333333333333333,
+			0.9375,
+			0.5333333333333333
+		};
+
+		// Difference with the second order method with weights (0, 3/5, 2/5).
+		static constexpr bool IsAdaptive = true;
+		static constexpr size_t CorrectionMethodsCount = 1;
+		static constexpr std::array<size_t, CorrectionMethodsCount> CorrectionMethodsAccuracyOrders = { 2 };
+		static constexpr std::array<std::array<double, StepCount>, CorrectionMethodsCount> ButcherTableauErrorRow =
+		{ {
+			{
+				0.16666666666666667,
+				-0.3,
+				0.13333333333333333
+			}
+		} };
+
+		static constexpr bool IsDenseOutputSupported = false;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <array>
+
+namespace CESDSOL
+{
+	// Composition of three Stormer-Verlet steps with weights w1, w0, w1, where w1 = 1 / (2 - 2^(1/3)) and
+	// w0 = 1 - 2 w1 (H. Yoshida, Construction of higher order symplectic integrators, 1990).
+	struct Yoshida4
+	{
+		static constexpr size_t AccuracyOrder = 4;
+
+		static constexpr size_t StepCount = 3;
+		static constexpr std::array<double, StepCount + 1> KickCoefficients =
+		{
+			0.67560359597982889,
+			-0.17560359597982877,
+			-0.17560359597982877,
+			0.67560359597982889
+		};
+		static constexpr std::array<double, StepCount> DriftCoefficients =
+		{
+			1.3512071919596578,
+			-1.7024143839193153,
+			1.3512071919596578
+		};
+	};
+}
\ No newline at end of file
@@ -0,0 +1,342 @@
+#pragma once
+
+#include "Math/CSRMatrixOperations.h"
+#include "Math/LinearAlgebra.h"
+#include "Math/LinearSolver.h"
+#include "Math/Native/BSRMatrix.h"
+#include "Math/Reordering.h"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <type_traits>
+
+namespace CESDSOL
+{
+	// Linear solver which renumbers unknowns of multi-field problem from field-major ordering (all points of the
+	// first field, then all points of the second one, ...) to point-major one, where fields of every grid point are
+	// contiguous, and passes the renumbered system to the inner solver. Discrete unknowns are kept at the end.
+	// If inner solver works with block CSR matrices, the system is padded with identity rows to the multiple of
+	// field count and stored with fieldCount x fieldCount blocks, which allows block products and block ILU.
+	// Grid points themselves can be renumbered as well, either by given positions (e.g. space-filling curve) or by
+	// reverse Cuthill-McKee ordering of the point graph of the matrix, to improve locality along slow grid axes and
+	// reduce fill of direct solvers. Renumbered pattern is computed only when pattern of the matrix changes, repeated
+	// solves only move values.
+	template<Concepts::CSRMatrix MatrixType, typename InnerMatrixType = MatrixType>
+	class PointMajorSolver final
+		: public LinearSolver<MatrixType, Vector<double>>
+	{
+	public:
+		using VectorType = Vector<double>;
+		using InnerSolverType = LinearSolver<InnerMatrixType, VectorType>;
+
+		PointMajorSolver(size_t aFieldCount, size_t aPointCount, uptr<InnerSolverType> aSolver) noexcept
+			: fieldCount(aFieldCount)
+			, pointCount(aPointCount)
+			, solver(std::move(aSolver))
+		{
+			AssertE(fieldCount > 0, MessageTag::LinearSolver, "Point-major ordering requires at least one field.");
+		}
+
+		// Sets new position of every grid point, empty array keeps lexicographic order of points. Positions are used
+		// when reverse Cuthill-McKee ordering is off.
+		void SetPointPositions(Array<size_t> positions) noexcept
+		{
+			AssertE(positions.size() == 0 || positions.size() == pointCount, MessageTag::LinearSolver,
+				"Number of point positions differs from number of points.");
+			pointPositions = std::move(positions);
+			isPatternActual = false;
+		}
+
+		[[nodiscard]] const Array<size_t>& GetPointPositions() const noexcept
+		{
+			return pointPositions;
+		}
+
+		// Ordering is computed on the next solve after change, since it depends on the matrix pattern. Positions set by
+		// SetPointPositions are kept and used again when the ordering is turned off.
+		void SetUseReverseCuthillMcKee(bool value) noexcept
+		{
+			if (useReverseCuthillMcKee != value)
+			{
+				useReverseCuthillMcKee = value;
+				isPatternActual = false;
+			}
+		}
+
+		[[nodiscard]] bool GetUseReverseCuthillMcKee() const noexcept
+		{
+			return useReverseCuthillMcKee;
+		}
+
+		// Returns position of field-major unknown in point-major ordering.
+		[[nodiscard]] size_t GetPointMajorIndex(size_t index) const noexcept
+		{
+			if (index >= fieldCount * pointCount)
+			{
+				return index;
+			}
+			const size_t point = index % pointCount;
+			const auto& positions = useReverseCuthillMcKee ? reverseCuthillMcKeePositions : pointPositions;
+			return (positions.size() == 0 ? point : positions[point]) * fieldCount + index / pointCount;
+		}
+
+		bool Solve(const MatrixType& matrix, const VectorType& y, VectorType& x) override
+		{
+			return SolveMultiple(matrix, y, x, 1);
+		}
+
+		bool SolveMultiple(const MatrixType& matrix, const VectorType& y, VectorType& x, size_t rhsCount) override
+		{
+			UpdateMatrix(matrix);
+			PermuteVectors(y, x, rhsCount);
+			bool result;
+			if constexpr (IsBlockSolver)
+			{
+				result = rhsCount == 1
+					? solver->Solve(blockMatrix, rhs, solution)
+					: solver->SolveMultiple(blockMatrix, rhs, solution, rhsCount);
+			}
+			else
+			{
+				result = rhsCount == 1
+					? solver->Solve(*permutedMatrix, rhs, solution)
+					: solver->SolveMultiple(*permutedMatrix, rhs, solution, rhsCount);
+			}
+			UnpermuteSolution(x, rhsCount);
+			return result;
+		}
+
+		bool Factorize(const MatrixType& matrix) override
+		{
+			UpdateMatrix(matrix);
+			if constexpr (IsBlockSolver)
+			{
+				return solver->Factorize(blockMatrix);
+			}
+			else
+			{
+				return solver->Factorize(*permutedMatrix);
+			}
+		}
+
+		bool SolveFactorized(const VectorType& y, VectorType& x) override
+		{
+			PermuteVectors(y, x, 1);
+			const bool result = solver->SolveFactorized(rhs, solution);
+			UnpermuteSolution(x, 1);
+			return result;
+		}
+
+	private:
+		static constexpr bool IsBlockSolver = std::is_same_v<InnerMatrixType, Native::BSRMatrix<typename InnerMatrixType::value_type>>;
+		using PermutedMatrixType = std::conditional_t<IsBlockSolver, Native::CSRMatrix<double, size_t, 0>, InnerMatrixType>;
+
+		static constexpr size_t None = std::numeric_limits<size_t>::max();
+
+		// Renumbers the matrix, the pattern is renumbered only when it changes.
+		void UpdateMatrix(const MatrixType& matrix) noexcept
+		{
+			AssertE(matrix.RowCount() >= fieldCount * pointCount && matrix.RowCount() == matrix.ColumnCount(),
+				MessageTag::LinearSolver, "Matrix size is incompatible with point-major ordering.");
+			const auto hash = ComputePatternHash(matrix);
+			const bool isPatternChanged = !isPatternActual || hash != patternHash;
+			if (isPatternChanged)
+			{
+				Analyze(matrix);
+				patternHash = hash;
+				isPatternActual = true;
+				Logger::Log(MessageType::Info, MessagePriority::Medium, MessageTag::LinearSolver,
+					Format("Point-major ordering of {} fields at {} points computed.", fieldCount, pointCount));
+			}
+
+			ParallelFor(0, sourcePositions.size(), [&](int64_t k)
+				{
+					const auto source = sourcePositions[k];
+					permutedMatrix->SetValue(k, source == None ? 1. : static_cast<double>(matrix.GetValue(source)));
+				});
+			if constexpr (IsBlockSolver)
+			{
+				if (isPatternChanged)
+				{
+					blockMatrix = InnerMatrixType(*permutedMatrix, fieldCount);
+				}
+				else
+				{
+					blockMatrix.UpdateValues(*permutedMatrix);
+				}
+			}
+		}
+
+		void PermuteVectors(const VectorType& y, const VectorType& x, size_t rhsCount) noexcept
+		{
+			const size_t size = permutation.size();
+			const size_t paddedSize = permutedMatrix->RowCount();
+			if (rhs.size() != paddedSize * rhsCount)
+			{
+				rhs = VectorType(paddedSize * rhsCount);
+				solution = VectorType(paddedSize * rhsCount);
+			}
+			ParallelFor(0, size, [&](int64_t i)
+				{
+					for (size_t r = 0; r < rhsCount; ++r)
+					{
+						rhs[r * paddedSize + permutation[i]] = y[r * size + i];
+						solution[r * paddedSize + permutation[i]] = x[r * size + i];
+					}
+				});
+		}
+
+		void UnpermuteSolution(VectorType& x, size_t rhsCount) const noexcept
+		{
+			const size_t size = permutation.size();
+			const size_t paddedSize = permutedMatrix->RowCount();
+			ParallelFor(0, size, [&](int64_t i)
+				{
+					for (size_t r = 0; r < rhsCount; ++r)
+					{
+						x[r * size + i] = solution[r * paddedSize + permutation[i]];
+					}
+				});
+		}
+
+		void Analyze(const MatrixType& matrix) noexcept
+		{
+			const size_t size = matrix.RowCount();
+			const size_t paddedSize = IsBlockSolver ? (size + fieldCount - 1) / fieldCount * fieldCount : size;
+			reverseCuthillMcKeePositions = useReverseCuthillMcKee
+				? GetReverseCuthillMcKeeOrdering(MakePointGraph(matrix))
+				: Array<size_t>();
+			permutation = Array<size_t>(size);
+			auto sourceRows = Array<size_t>(None, paddedSize);
+			ParallelFor(0, size, [&](int64_t i)
+				{
+					permutation[i] = GetPointMajorIndex(i);
+					sourceRows[permutation[i]] = i;
+				});
+
+			auto rowStarts = Array<size_t>(paddedSize + 1);
+			for (size_t row = 0; row < paddedSize; ++row)
+			{
+				const auto source = sourceRows[row];
+				rowStarts[row + 1] = rowStarts[row] +
+					(source == None ? 1 : static_cast<size_t>(matrix.GetRowCount(source + 1) - matrix.GetRowCount(source)));
+			}
+
+			// Entries of every row are ordered by their new columns, padding rows only hold unit diagonal.
+			sourcePositions = Array<size_t>(rowStarts[paddedSize]);
+			permutedMatrix.reset();
+			permutedMatrix.emplace(paddedSize, paddedSize, rowStarts[paddedSize]);
+			ParallelFor(0, paddedSize, [&](int64_t row)
+				{
+					permutedMatrix->SetRowCount(row, rowStarts[row]);
+					const auto source = sourceRows[row];
+					if (source == None)
+					{
+						sourcePositions[rowStarts[row]] = None;
+						permutedMatrix->SetColumnIndex(rowStarts[row], row);
+						return;
+					}
+					auto* begin = sourcePositions.data() + rowStarts[row];
+					for (size_t k = matrix.GetRowCount(source); k < matrix.GetRowCount(source + 1); ++k)
+					{
+						*begin++ = k;
+					}
+					std::sort(sourcePositions.data() + rowStarts[row], begin, [&](size_t left, size_t right)
+						{
+							return permutation[matrix.GetColumnIndex(left)] < permutation[matrix.GetColumnIndex(right)];
+						});
+					for (size_t k = rowStarts[row]; k < rowStarts[row + 1]; ++k)
+					{
+						permutedMatrix->SetColumnIndex(k, permutation[matrix.GetColumnIndex(sourcePositions[k])]);
+					}
+				});
+
+			rhs = VectorType();
+			solution = VectorType();
+		}
+
+		// Returns matrix whose pattern couples points with coupled unknowns.
+		[[nodiscard]] Native::CSRMatrix<double, size_t, 0> MakePointGraph(const MatrixType& matrix) const noexcept
+		{
+			const size_t continuousCount = fieldCount * pointCount;
+			std::vector<size_t> columns;
+			std::vector<size_t> rowColumns;
+			auto rowStarts = Array<size_t>(pointCount + 1);
+			for (size_t point = 0; point < pointCount; ++point)
+			{
+				rowColumns.clear();
+				for (size_t row = point; row < continuousCount; row += pointCount)
+				{
+					for (size_t k = matrix.GetRowCount(row); k < matrix.GetRowCount(row + 1); ++k)
+					{
+						const size_t column = matrix.GetColumnIndex(k);
+						if (column < continuousCount)
+						{
+							rowColumns.push_back(column % pointCount);
+						}
+					}
+				}
+				std::sort(rowColumns.begin(), rowColumns.end());
+				rowColumns.erase(std::unique(rowColumns.begin(), rowColumns.end()), rowColumns.end());
+				columns.insert(columns.end(), rowColumns.begin(), rowColumns.end());
+				rowStarts[point + 1] = columns.size();
+			}
+			auto result = Native::CSRMatrix<double, size_t, 0>(pointCount, pointCount, columns.size());
+			for (size_t point = 0; point < pointCount; ++point)
+			{
+				result.SetRowCount(point, rowStarts[point]);
+			}
+			for (size_t k = 0; k < columns.size(); ++k)
+			{
+				result.SetColumnIndex(k, columns[k]);
+			}
+			return result;
+		}
+
+		size_t fieldCount;
+		size_t pointCount;
+		uptr<InnerSolverType> solver;
+		// New position of every grid point, empty for lexicographic order.
+		Array<size_t> pointPositions;
+		// Positions of points in reverse Cuthill-McKee ordering of the last analyzed pattern, empty when it is off.
+		Array<size_t> reverseCuthillMcKeePositions;
+
+		// New position of every unknown.
+		Array<size_t> permutation;
+		// Entry of the source matrix for every entry of the renumbered one, None for padding.
+		Array<size_t> sourcePositions;
+		// Kept in optional since MKL matrices release their handles only on destruction.
+		std::optional<PermutedMatrixType> permutedMatrix;
+		// Used only with block inner solvers.
+		std::conditional_t<IsBlockSolver, InnerMatrixType, std::nullptr_t> blockMatrix{};
+		VectorType rhs;
+		VectorType solution;
+
+		uint64_t patternHash = 0;
+		bool isPatternActual = false;
+
+		// Points are ordered by reverse Cuthill-McKee ordering of the point graph of the matrix.
+		bool useReverseCuthillMcKee = false;
+	};
+
+	// Creates point-major solver for the Jacobian of stationary problem. Inner matrix type is either the Jacobian
+	// matrix type or Native::BSRMatrix<double>. Space-filling curve orderings require direct product grid.
+	template<typename InnerMatrixType, typename ProblemType>
+	[[nodiscard]] auto MakePointMajorSolver(const ProblemType& problem,
+		uptr<LinearSolver<InnerMatrixType, Vector<double>>> solver, PointOrdering ordering = PointOrdering::Lexicographic) noexcept
+	{
+		using GridType = DirectProductGrid<ProblemType::Dimension, typename ProblemType::CoordinateType>;
+
+		auto result = std::make_unique<PointMajorSolver<typename ProblemType::JacobianMatrixType, InnerMatrixType>>(
+			problem.GetDescriptor().ContinuousEquationCount(), problem.GetGrid().GetSize(), std::move(solver));
+		if (ordering == PointOrdering::Morton || ordering == PointOrdering::Hilbert)
+		{
+			const auto* grid = dynamic_cast<const GridType*>(&problem.GetGrid());
+			AssertE(grid != nullptr, MessageTag::LinearSolver, "Space-filling curve ordering requires problem on direct product grid.");
+			result->SetPointPositions(ordering == PointOrdering::Morton ? GetMortonOrdering(*grid) : GetHilbertOrdering(*grid));
+		}
+		result->SetUseReverseCuthillMcKee(ordering == PointOrdering::ReverseCuthillMcKee);
+		return result;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,279 @@
+#pragma once
+
+#include "Grid/DirectProductGrid.h"
+#include "Math/Array.h"
+#include "Math/Concepts.h"
+#include "Utils/Parallelism/Parallelism.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace CESDSOL
+{
+	enum class PointOrdering
+	{
+		Lexicographic,
+		Morton,
+		Hilbert,
+		ReverseCuthillMcKee
+	};
+
+	namespace Internal
+	{
+		// Interleaves lowest bitCount bits of coordinates starting from the highest bit, the first coordinate is
+		// the most significant one at every level.
+		template<size_t Dimension>
+		[[nodiscard]] uint64_t InterleaveBits(const std::array<uint64_t, Dimension>& coordinates, size_t bitCount) noexcept
+		{
+			uint64_t result = 0;
+			for (size_t bit = bitCount; bit-- > 0;)
+			{
+				for (size_t i = 0; i < Dimension; ++i)
+				{
+					result = (result << 1) | ((coordinates[i] >> bit) & 1);
+				}
+			}
+			return result;
+		}
+
+		// Converts coordinates to transposed Hilbert index (J. Skilling, Programming the Hilbert curve, 2004).
+		template<size_t Dimension>
+		void AxesToTranspose(std::array<uint64_t, Dimension>& x, size_t bitCount) noexcept
+		{
+			const uint64_t highest = uint64_t(1) << (bitCount - 1);
+			for (uint64_t q = highest; q > 1; q >>= 1)
+			{
+				const uint64_t p = q - 1;
+				for (size_t i = 0; i < Dimension; ++i)
+				{
+					if (x[i] & q)
+					{
+						x[0] ^= p;
+					}
+					else
+					{
+						const uint64_t t = (x[0] ^ x[i]) & p;
+						x[0] ^= t;
+						x[i] ^= t;
+					}
+				}
+			}
+			for (size_t i = 1; i < Dimension; ++i)
+			{
+				x[i] ^= x[i - 1];
+			}
+			uint64_t t = 0;
+			for (uint64_t q = highest; q > 1; q >>= 1)
+			{
+				if (x[Dimension - 1] & q)
+				{
+					t ^= q - 1;
+				}
+			}
+			for (size_t i = 0; i < Dimension; ++i)
+			{
+				x[i] ^= t;
+			}
+		}
+
+		// Returns new position of every item when items are sorted by keys.
+		[[nodiscard]] inline Array<size_t> GetPositionsBySortedKeys(const Array<uint64_t>& keys) noexcept
+		{
+			auto order = Array<size_t>(keys.size());
+			for (size_t i = 0; i < keys.size(); ++i)
+			{
+				order[i] = i;
+			}
+			std::stable_sort(order.begin(), order.end(), [&](size_t left, size_t right) { return keys[left] < keys[right]; });
+			auto result = Array<size_t>(keys.size());
+			for (size_t i = 0; i < keys.size(); ++i)
+			{
+				result[order[i]] = i;
+			}
+			return result;
+		}
+
+		template<size_t Dimension, typename CoordinateType, typename KeyFunctionType>
+		[[nodiscard]] Array<size_t> GetSpaceFillingCurveOrdering(const DirectProductGrid<Dimension, CoordinateType>& grid,
+			KeyFunctionType&& getKey) noexcept
+		{
+			size_t maxSize = 1;
+			for (size_t i = 0; i < Dimension; ++i)
+			{
+				maxSize = std::max(maxSize, grid.GetDimensionSize(i));
+			}
+			const size_t bitCount = std::max<size_t>(std::bit_width(maxSize - 1), 1);
+			AssertE(bitCount * Dimension <= 64, MessageTag::Math, "Grid is too large for space-filling curve ordering.");
+
+			auto keys = Array<uint64_t>(grid.GetSize());
+			ParallelFor(0, grid.GetSize(), [&](int64_t point)
+				{
+					const auto multiIndex = grid.GetMultiIndexBySingleIndex(point);
+					std::array<uint64_t, Dimension> coordinates;
+					for (size_t i = 0; i < Dimension; ++i)
+					{
+						coordinates[i] = multiIndex[i];
+					}
+					keys[point] = getKey(coordinates, bitCount);
+				});
+			return GetPositionsBySortedKeys(keys);
+		}
+	}
+
+	// Orderings of grid points below return new position of every point.
+
+	// Z-order curve over the bounding power of two box of direct product grid: points close on the curve are close
+	// along all axes, not only along the fastest one.
+	template<size_t Dimension, typename CoordinateType>
+	[[nodiscard]] Array<size_t> GetMortonOrdering(const DirectProductGrid<Dimension, CoordinateType>& grid) noexcept
+	{
+		return Internal::GetSpaceFillingCurveOrdering(grid, [](const std::array<uint64_t, Dimension>& coordinates, size_t bitCount)
+			{
+				return Internal::InterleaveBits(coordinates, bitCount);
+			});
+	}
+
+	// Hilbert curve over the bounding power of two box of direct product grid. Unlike Morton curve consecutive points
+	// are always neighbours, which gives slightly better locality at higher cost of computing the ordering.
+	template<size_t Dimension, typename CoordinateType>
+	[[nodiscard]] Array<size_t> GetHilbertOrdering(const DirectProductGrid<Dimension, CoordinateType>& grid) noexcept
+	{
+		return Internal::GetSpaceFillingCurveOrdering(grid, [](std::array<uint64_t, Dimension> coordinates, size_t bitCount)
+			{
+				Internal::AxesToTranspose(coordinates, bitCount);
+				return Internal::InterleaveBits(coordinates, bitCount);
+			});
+	}
+
+	// Reverse Cuthill-McKee ordering of the symmetrized graph of square matrix: breadth-first search from
+	// pseudo-peripheral vertex of every connected component visiting neighbours by increasing degree, reversed.
+	// Reduces bandwidth and profile of the matrix, and with them fill of band and profile factorizations.
+	template<Concepts::CSRMatrix MatrixType>
+	[[nodiscard]] Array<size_t> GetReverseCuthillMcKeeOrdering(const MatrixType& A) noexcept
+	{
+		constexpr size_t None = std::numeric_limits<size_t>::max();
+		const size_t size = A.RowCount();
+		AssertE(size == A.ColumnCount(), MessageTag::Math, "Reverse Cuthill-McKee ordering requires square matrix.");
+
+		auto adjacencyStarts = Array<size_t>(size + 1);
+		for (size_t row = 0; row < size; ++row)
+		{
+			for (size_t k = A.GetRowCount(row); k < A.GetRowCount(row + 1); ++k)
+			{
+				const size_t column = A.GetColumnIndex(k);
+				if (column != row)
+				{
+					++adjacencyStarts[row + 1];
+					++adjacencyStarts[column + 1];
+				}
+			}
+		}
+		for (size_t i = 0; i < size; ++i)
+		{
+			adjacencyStarts[i + 1] += adjacencyStarts[i];
+		}
+		auto adjacency = Array<size_t>(adjacencyStarts[size]);
+		auto positions = Array<size_t>(size, adjacencyStarts.data());
+		for (size_t row = 0; row < size; ++row)
+		{
+			for (size_t k = A.GetRowCount(row); k < A.GetRowCount(row + 1); ++k)
+			{
+				const size_t column = A.GetColumnIndex(k);
+				if (column != row)
+				{
+					adjacency[positions[row]++] = column;
+					adjacency[positions[column]++] = row;
+				}
+			}
+		}
+		auto degrees = Array<size_t>(size);
+		for (size_t vertex = 0; vertex < size; ++vertex)
+		{
+			auto* begin = adjacency.data() + adjacencyStarts[vertex];
+			auto* end = adjacency.data() + adjacencyStarts[vertex + 1];
+			std::sort(begin, end);
+			degrees[vertex] = std::unique(begin, end) - begin;
+		}
+
+		auto levels = Array<size_t>(None, size);
+		std::vector<size_t> order;
+		order.reserve(size);
+		std::vector<size_t> neighbours;
+		// Appends component of root to order in Cuthill-McKee order, returns number of levels.
+		const auto search = [&](size_t root)
+		{
+			const size_t first = order.size();
+			order.push_back(root);
+			levels[root] = 0;
+			size_t levelCount = 1;
+			for (size_t i = first; i < order.size(); ++i)
+			{
+				const size_t vertex = order[i];
+				neighbours.clear();
+				for (size_t k = adjacencyStarts[vertex]; k < adjacencyStarts[vertex] + degrees[vertex]; ++k)
+				{
+					if (levels[adjacency[k]] == None)
+					{
+						levels[adjacency[k]] = levels[vertex] + 1;
+						levelCount = levels[vertex] + 2;
+						neighbours.push_back(adjacency[k]);
+					}
+				}
+				std::stable_sort(neighbours.begin(), neighbours.end(),
+					[&](size_t left, size_t right) { return degrees[left] < degrees[right]; });
+				order.insert(order.end(), neighbours.begin(), neighbours.end());
+			}
+			return levelCount;
+		};
+		const auto reset = [&](size_t first)
+		{
+			for (size_t i = first; i < order.size(); ++i)
+			{
+				levels[order[i]] = None;
+			}
+			order.resize(first);
+		};
+
+		for (size_t start = 0; start < size; ++start)
+		{
+			if (levels[start] != None)
+			{
+				continue;
+			}
+			// Pseudo-peripheral vertex: minimal degree vertex of the last level while eccentricity grows.
+			const size_t first = order.size();
+			size_t root = start;
+			size_t levelCount = search(root);
+			while (true)
+			{
+				size_t candidate = root;
+				for (size_t i = first; i < order.size(); ++i)
+				{
+					const size_t vertex = order[i];
+					if (levels[vertex] + 1 == levelCount && (candidate == root || degrees[vertex] < degrees[candidate]))
+					{
+						candidate = vertex;
+					}
+				}
+				reset(first);
+				const size_t candidateLevelCount = search(candidate);
+				if (candidateLevelCount <= levelCount)
+				{
+					break;
+				}
+				root = candidate;
+				levelCount = candidateLevelCount;
+			}
+		}
+
+		auto result = Array<size_t>(size);
+		for (size_t i = 0; i < size; ++i)
+		{
+			result[order[i]] = size - 1 - i;
+		}
+		return result;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,275 @@
+#pragma once
+
+#include "Math/CSRMatrixOperations.h"
+#include "Math/LinearAlgebra.h"
+#include "Math/LinearOperator.h"
+#include "Math/Native/DIAMatrix.h"
+#include "Math/Native/SELLMatrix.h"
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+namespace CESDSOL
+{
+	enum class SparseFormat
+	{
+		CSR,
+		OptimizedCSR,
+		SELL,
+		DIA
+	};
+
+	static constexpr const char* SparseFormatNames[]
+	{
+		"CSR",
+		"optimized CSR",
+		"SELL-C-sigma",
+		"DIA"
+	};
+
+	// Sparse matrix which benchmarks matrix-vector product in alternative storage formats and keeps the fastest one.
+	// CSR matrix is always kept for element access. Chosen format is preserved when values are updated with the same
+	// pattern, so the operator can be tuned once and reused for matrices refilled many times (e.g. the Jacobian in
+	// iterative linear solvers, see IterativeSolverOperator).
+	template<Concepts::CSRMatrix MatrixTypeArg>
+	class TunedSparseOperator
+	{
+	public:
+		using MatrixType = MatrixTypeArg;
+		using ScalarType = typename MatrixType::value_type;
+
+		TunedSparseOperator() noexcept = default;
+
+		explicit TunedSparseOperator(MatrixType aMatrix) noexcept
+			: matrix(std::move(aMatrix))
+		{}
+
+		[[nodiscard]] const MatrixType& GetMatrix() const noexcept
+		{
+			return matrix;
+		}
+
+		[[nodiscard]] SparseFormat GetFormat() const noexcept
+		{
+			return format;
+		}
+
+		// Measures matrix-vector product time in every applicable format and keeps the fastest one.
+		void Tune() noexcept
+		{
+			auto x = Vector<ScalarType>(ScalarType(1), matrix.ColumnCount());
+			auto y = Vector<ScalarType>(matrix.RowCount());
+			auto bestFormat = SparseFormat::CSR;
+			auto bestTime = Measure([&]() { MVMultiply(matrix, x, y, 1., 0.); });
+
+			const auto consider = [&](SparseFormat candidate, double time)
+			{
+				if (time < bestTime)
+				{
+					bestTime = time;
+					bestFormat = candidate;
+				}
+			};
+
+			if (matrix.ColumnCount() <= std::numeric_limits<uint32_t>::max())
+			{
+				sellMatrix = Native::SELLMatrix<ScalarType>(matrix);
+				if (sellMatrix.StoredCount() <= maxFillRatio * matrix.NonZeroCount())
+				{
+					consider(SparseFormat::SELL, Measure([&]() { sellMatrix.Apply(x, y); }));
+				}
+			}
+			if (Native::DIAMatrix<ScalarType>::GetOffsets(matrix).size() * matrix.RowCount() <= maxFillRatio * matrix.NonZeroCount())
+			{
+				diaMatrix = Native::DIAMatrix<ScalarType>(matrix);
+				consider(SparseFormat::DIA, Measure([&]() { diaMatrix.Apply(x, y); }));
+			}
+#if MathLibrary == MKLMath
+			if (hasConstantValues)
+			{
+				CreateOptimizedMatrix();
+				consider(SparseFormat::OptimizedCSR, Measure([&]() { MVMultiply(*optimizedMatrix, x, y, 1., 0.); }));
+			}
+#endif
+
+			format = bestFormat;
+			if (format != SparseFormat::SELL)
+			{
+				sellMatrix = Native::SELLMatrix<ScalarType>();
+			}
+			if (format != SparseFormat::DIA)
+			{
+				diaMatrix = Native::DIAMatrix<ScalarType>();
+			}
+			if (format != SparseFormat::OptimizedCSR)
+			{
+				optimizedMatrix.reset();
+			}
+			patternHash = ComputePatternHash(matrix);
+			isTuned = true;
+			Logger::Log(MessageType::Info, MessagePriority::Low, MessageTag::Math,
+				Format("{} format is chosen for sparse matrix of size {} with {} nonzeros, product takes {} us.",
+					SparseFormatNames[static_cast<size_t>(format)], matrix.RowCount(), matrix.NonZeroCount(), bestTime));
+		}
+
+		// Replaces values by values of matrix with the same pattern keeping chosen format. Values are copied in place for
+		// CSR, SELL and DIA, while optimized CSR is fully copied and optimized again on every call, so it pays off only
+		// if the operator is applied many times between updates.
+		void UpdateValues(const MatrixType& source) noexcept
+		{
+			AssertE(source.NonZeroCount() == matrix.NonZeroCount(), MessageTag::Math,
+				"Trying to update tuned sparse operator with different pattern.");
+			std::copy(source.GetValues().begin(), source.GetValues().end(), matrix.GetValues().begin());
+			switch (format)
+			{
+			case SparseFormat::SELL:
+				sellMatrix.UpdateValues(matrix);
+				break;
+			case SparseFormat::DIA:
+				diaMatrix.UpdateValues(matrix);
+				break;
+			case SparseFormat::OptimizedCSR:
+				CreateOptimizedMatrix();
+				break;
+			default:
+				break;
+			}
+		}
+
+		// Takes sizes, pattern and values of the matrix, the format is tuned again only if the pattern differs from the
+		// tuned one.
+		void Update(const MatrixType& source) noexcept
+		{
+			if (isTuned && ComputePatternHash(source) == patternHash)
+			{
+				UpdateValues(source);
+				return;
+			}
+			matrix = source;
+			Tune();
+		}
+
+		template<Concepts::Vector XVectorType, Concepts::Vector YVectorType>
+		void Apply(const XVectorType& x, YVectorType& y) const noexcept
+		{
+			switch (format)
+			{
+			case SparseFormat::SELL:
+				sellMatrix.Apply(x, y);
+				break;
+			case SparseFormat::DIA:
+				diaMatrix.Apply(x, y);
+				break;
+			case SparseFormat::OptimizedCSR:
+				MVMultiply(*optimizedMatrix, x, y, 1., 0.);
+				break;
+			default:
+				MVMultiply(matrix, x, y, 1., 0.);
+				break;
+			}
+		}
+
+	private:
+		// Optimized copy is kept separately since inspector-executor data is not updated on changes of values.
+		void CreateOptimizedMatrix() noexcept
+		{
+#if MathLibrary == MKLMath
+			optimizedMatrix.reset();
+			optimizedMatrix.emplace(matrix);
+			optimizedMatrix->Optimize(static_cast<MKL_INT>(expectedCallCount));
+#endif
+		}
+
+		// Returns average time of single call in microseconds.
+		template<typename BodyType>
+		double Measure(BodyType&& body) const noexcept
+		{
+			body();
+			std::chrono::high_resolution_clock clock;
+			const auto startTime = clock.now();
+			for (size_t i = 0; i < benchmarkRepetitionCount; ++i)
+			{
+				body();
+			}
+			return std::chrono::duration<double, std::micro>(clock.now() - startTime).count() /
+				std::max<size_t>(benchmarkRepetitionCount, 1);
+		}
+
+		MatrixType matrix;
+		SparseFormat format = SparseFormat::CSR;
+		Native::SELLMatrix<ScalarType> sellMatrix;
+		Native::DIAMatrix<ScalarType> diaMatrix;
+		std::optional<MatrixType> optimizedMatrix;
+		uint64_t patternHash = 0;
+		bool isTuned = false;
+
+		MakeProperty(benchmarkRepetitionCount, BenchmarkRepetitionCount, size_t, 10)
+		// Formats storing more than this multiple of nonzero count are not considered.
+		MakeProperty(maxFillRatio, MaxFillRatio, double, 2)
+		MakeProperty(expectedCallCount, ExpectedCallCount, size_t, 1000)
+		// If false, values are expected to be updated before every few products, and optimized CSR, which is built
+		// again on every update, is not considered.
+		MakeProperty(hasConstantValues, HasConstantValues, bool, true)
+	};
+
+	// Operator used by iterative linear solvers for products with the matrix of the system. Other operators are
+	// applied as is.
+	template<typename OperatorType, typename VectorType>
+	class IterativeSolverOperator
+	{
+	public:
+		void Update(const OperatorType&, bool) noexcept
+		{}
+
+		void Apply(const OperatorType& A, const VectorType& x, VectorType& y) const noexcept
+		{
+			ApplyOperator(A, x, y);
+		}
+	};
+
+	// Explicitly stored CSR matrices are applied through tuned copy, which is tuned again only when the pattern
+	// changes, so repeated solves with the same pattern (e.g. Newton iterations) only copy values. The copy doubles
+	// memory taken by the matrix, tuning can be turned off by solvers to avoid it.
+	template<typename OperatorType, typename VectorType>
+		requires (Concepts::CSRMatrix<OperatorType> && !Concepts::MatrixFreeOperator<OperatorType, VectorType>)
+	class IterativeSolverOperator<OperatorType, VectorType>
+	{
+	public:
+		IterativeSolverOperator() noexcept
+		{
+			tunedOperator.SetHasConstantValues(false);
+		}
+
+		void Update(const OperatorType& A, bool isTuningEnabled) noexcept
+		{
+			if (isTuningEnabled)
+			{
+				tunedOperator.Update(A);
+			}
+			else if (useTunedOperator)
+			{
+				tunedOperator = TunedSparseOperator<OperatorType>();
+				tunedOperator.SetHasConstantValues(false);
+			}
+			useTunedOperator = isTuningEnabled;
+		}
+
+		void Apply(const OperatorType& A, const VectorType& x, VectorType& y) const noexcept
+		{
+			if (useTunedOperator)
+			{
+				tunedOperator.Apply(x, y);
+			}
+			else
+			{
+				MVMultiply(A, x, y, 1., 0.);
+			}
+		}
+
+	private:
+		TunedSparseOperator<OperatorType> tunedOperator;
+		bool useTunedOperator = false;
+	};
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "Discretization/Discretization.h"
 #include "Grid/Grid.h"
+#include "Math/TunedSparseOperator.h"
 #include "Problem/BaseProblemDescriptor.h"
 #include "Problem/ProblemUtils.h"
 #include "Serialization/DataToLoad.h"
@@ -60,7 +61,10 @@ namespace CESDSOL
 		Array<FieldType> globalVDEs;
 		Array<FieldType> reductions;
 
-		Array<DifferentiationMatrixType> differentiationWeights;
+		// Differentiation matrices are constructed only if some operator has no matrix-free stencil. Jacobian is tuned
+		// by native iterative solvers which multiply by it.
+		std::vector<TunedSparseOperator<DifferentiationMatrixType>> differentiationWeights;
+		std::vector<std::optional<TensorProductStencil<Dimension, CoordinateType>>> differentiationStencils;
 		Array<CoordinateType> integrationWeights;
 
 		std::vector<std::pair<std::function<FieldType(const CurrentLocalValues&, const CurrentGlobalValues&)>, std::string>> localOutputExpressions;
@@ -133,10 +137,51 @@ namespace CESDSOL
 
 		void ConstructDifferentiationWeights() noexcept
 		{
-			differentiationWeights = Array<CSRMatrix<CoordinateType>>(derivativeOperators.size());
+			differentiationWeights.clear();
 			for (size_t i = 0; i < derivativeOperators.size(); i++)
 			{
-				differentiationWeights[i] = discretizer->GetDifferentiationMatrix(*grid, derivativeOperators[i]);
+				differentiationWeights.emplace_back(discretizer->GetDifferentiationMatrix(*grid, derivativeOperators[i]));
+				differentiationWeights.back().Tune();
+			}
+		}
+
+		void ConstructDifferentiationStencils() noexcept
+		{
+			differentiationStencils.clear();
+			bool hasAllStencils = true;
+			for (size_t i = 0; i < derivativeOperators.size(); i++)
+			{
+				differentiationStencils.push_back(discretizer->GetDifferentiationStencil(*grid, derivativeOperators[i]));
+				hasAllStencils &= differentiationStencils.back().has_value();
+			}
+			if (!hasAllStencils)
+			{
+				ConstructDifferentiationWeights();
+			}
+		}
+
+		[[nodiscard]] size_t GetDifferentiationRowLength(size_t operatorIndex, size_t pointIndex) const noexcept
+		{
+			if (differentiationStencils[operatorIndex])
+			{
+				return differentiationStencils[operatorIndex]->GetRowLength(pointIndex);
+			}
+			return differentiationWeights[operatorIndex].GetMatrix().GetRowLength(pointIndex);
+		}
+
+		// Calls body(columnIndex, weight) for every weight of differentiation operator row.
+		template<typename BodyType>
+		void ForEachDifferentiationWeight(size_t operatorIndex, size_t pointIndex, BodyType&& body) const noexcept
+		{
+			if (differentiationStencils[operatorIndex])
+			{
+				differentiationStencils[operatorIndex]->ForEachRowEntry(pointIndex, body);
+				return;
+			}
+			const auto& weightsMatrix = differentiationWeights[operatorIndex].GetMatrix();
+			for (size_t k = weightsMatrix.GetRowCount(pointIndex); k < weightsMatrix.GetRowCount(pointIndex + 1); ++k)
+			{
+				body(weightsMatrix.GetColumnIndex(k), weightsMatrix.GetValue(k));
 			}
 		}
 
@@ -276,7 +321,15 @@ namespace CESDSOL
 			{
 				for (size_t j = 0; j < descriptor.DerivativeOperatorCount(i); j++)
 				{
-					MVMultiply(differentiationWeights[fieldDerivativeOperatorMap[i][j]], variables[i], derivatives[i][j]);
+					const auto operatorIndex = fieldDerivativeOperatorMap[i][j];
+					if (differentiationStencils[operatorIndex])
+					{
+						differentiationStencils[operatorIndex]->Apply(variables[i], derivatives[i][j]);
+					}
+					else
+					{
+						differentiationWeights[operatorIndex].Apply(variables[i], derivatives[i][j]);
+					}
 				}
 			}
 		}
@@ -419,7 +472,7 @@ namespace CESDSOL
 			, reductions(descriptor.ReductionCount())
 		{
 			EnumerateDerivativeOperators();
-			ConstructDifferentiationWeights();
+			ConstructDifferentiationStencils();
 			ConstructIntegrationWeights();
 			CalculateParameterIndependentExpressions();
 		}
@@ -487,6 +540,14 @@ namespace CESDSOL
 			SetVariablesUpdated();
 		}
 
+		// Exchanges variables with the array in O(1), so several states can be kept without copying.
+		void SwapVariables(Array<FieldType>& other) noexcept
+		{
+			AssertE(other.size() == DOFCount(), MessageTag::Problem, "Trying to swap variables with array of inconsistent size!");
+			variables.Swap(other);
+			SetVariablesUpdated();
+		}
+
 		[[nodiscard]] const auto& GetVariable(size_t variableIndex) const noexcept
 		{
 			return variables[variableIndex];
@@ -513,6 +574,16 @@ namespace CESDSOL
 			return equations;
 		}
 
+		// Moves actual equations to the array in O(1) and takes its storage instead, equations are recomputed on the next
+		// access.
+		void TakeEquations(Array<FieldType>& destination) noexcept
+		{
+			AssertE(destination.size() == DOFCount(), MessageTag::Problem, "Trying to take equations to array of inconsistent size!");
+			Actualize();
+			equations.Swap(destination);
+			isActualOnVariables = false;
+		}
+
 		[[nodiscard]] const auto& GetDerivative(size_t fieldIndex, size_t derivativeIndex) const noexcept
 		{
 			return derivatives[fieldIndex][derivativeIndex];
@@ -69,6 +69,16 @@ namespace CESDSOL
 			timeCache.Add(time, variables);
 		}
 
+		// Evaluates equations at given time and state into the output without copying: both arrays are exchanged with
+		// storage of the problem in O(1), state is given back and variables of the problem are left unchanged.
+		void EvaluateEquations(CoordinateType aTime, Array<FieldType>& state, Array<FieldType>& output) noexcept
+		{
+			SetTime(aTime);
+			this->SwapVariables(state);
+			this->TakeEquations(output);
+			this->SwapVariables(state);
+		}
+
 		static constexpr Serializer::ProblemType SerializerProblemType = Serializer::ProblemType::TransientProblem;
 
 		struct SerializedData
@@ -31,7 +31,6 @@ namespace CESDSOL
 		using BaseType::descriptor;
 		using BaseType::grid;
 
-		using BaseType::differentiationWeights;
 		using BaseType::fieldDerivativeOperatorMap;
 
 		using BaseType::parameters;
@@ -298,12 +297,12 @@ namespace CESDSOL
 									{
 										if (descriptor.HasReductionJacobianComponent(j, k, l))
 										{
-											const auto& weightsMatrix = differentiationWeights[fieldDerivativeOperatorMap[k][l - 1]];
-											for (size_t n = weightsMatrix.GetRowCount(i); n < weightsMatrix.GetRowCount(i + 1); ++n)
-											{
-												reductionJacobians[j][k][l][weightsMatrix.GetColumnIndex(n)] +=
-													descriptor.CalculateReductionJacobianComponent(j, k, l, locals, globals) * weightsMatrix.GetValue(n);
-											}
+											this->ForEachDifferentiationWeight(fieldDerivativeOperatorMap[k][l - 1], i,
+												[&](size_t columnIndex, CoordinateType weight)
+												{
+													reductionJacobians[j][k][l][columnIndex] +=
+														descriptor.CalculateReductionJacobianComponent(j, k, l, locals, globals) * weight;
+												});
 										}
 									}
 								}
@@ -397,7 +396,7 @@ namespace CESDSOL
 								{
 									if (descriptor.HasJacobianComponent(i, j, l, trueRegionIndex))
 									{
-										elementCount += differentiationWeights[fieldDerivativeOperatorMap[j][l - 1]].GetRowLength(k);
+										elementCount += this->GetDifferentiationRowLength(fieldDerivativeOperatorMap[j][l - 1], k);
 									}
 								}
 								auto& row = jacobianStructure[i][k][j] = Array<JacobianElement>(elementCount);
@@ -410,11 +409,11 @@ namespace CESDSOL
 								{
 									if (descriptor.HasJacobianComponent(i, j, l, trueRegionIndex))
 									{
-										const auto& weightMatrix = differentiationWeights[fieldDerivativeOperatorMap[j][l - 1]];
-										for (size_t m = weightMatrix.GetRowCount(k); m < weightMatrix.GetRowCount(k + 1); ++m)
-										{
-											row[elementIndex++] = { j * grid->GetSize() + weightMatrix.GetColumnIndex(m), l, weightMatrix.GetValue(m) };
-										}
+										this->ForEachDifferentiationWeight(fieldDerivativeOperatorMap[j][l - 1], k,
+											[&](size_t columnIndex, CoordinateType weight)
+											{
+												row[elementIndex++] = { j * grid->GetSize() + columnIndex, l, weight };
+											});
 									}
 								}
 								std::sort(row.begin(), row.end(), [](const auto& left, const auto& right) {return left.Index < right.Index; });
@@ -635,6 +634,14 @@ namespace CESDSOL
 			return jacobianMatrix;
 		}
 
+		// Returns pointwise coefficients of the given derivative operator of the field in the equation (operator 0 is the
+		// field value), empty if the equation does not depend on it. Coefficients are actual after GetJacobian call.
+		[[nodiscard]] const Array<FieldType>& GetJacobianComponent(size_t equationIndex, size_t fieldIndex,
+			size_t operatorIndex) const noexcept
+		{
+			return jacobian[equationIndex][fieldIndex][operatorIndex];
+		}
+
 #ifdef DebugMode
 		void PrintJacobianStructure(std::ostream& stream) noexcept
 		{
@@ -28,4 +28,11 @@ namespace CESDSOL
 			body(index);
 		}
 	}
+
+	template<typename BodyType>
+	void CriticalSection(BodyType&& body) noexcept
+	{
+#pragma omp critical
+		body();
+	}
 }
\ No newline at end of file
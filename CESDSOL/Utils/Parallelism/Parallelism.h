@@ -6,6 +6,6 @@
 
 #if ParallelismBackend == OpenMPParallelism
 #include "Utils/Parallelism/OpenMP.h"
-#elif ParallelsimBackend == SequentialParallelism
+#elif ParallelismBackend == SequentialParallelism
 #include "Utils/Parallelism/Sequential.h"
 #endif 
\ No newline at end of file
@@ -1,12 +1,12 @@
 #pragma once
 namespace CESDSOL
 {
-	template<typename IndexType, typename BodyType>
-	void ParallelFor(IndexType startIndex, IndexType endIndex, BodyType&& body) noexcept
+	template<typename BodyType>
+	void ParallelFor(int64_t startIndex, int64_t endIndex, BodyType&& body) noexcept
 	{
-		for (IndexType index = startIndex; index < endIndex; ++index)
+		for (int64_t index = startIndex; index < endIndex; ++index)
 		{
-			body();
+			body(index);
 		}
 	}
 
@@ -16,12 +16,18 @@ namespace CESDSOL
 		body();
 	}
 
-	template<typename IndexType, typename BodyType>
-	void ForInParallelBlock(IndexType startIndex, IndexType endIndex, BodyType&& body) noexcept
+	template<typename BodyType>
+	void ForInParallelBlock(int64_t startIndex, int64_t endIndex, BodyType&& body) noexcept
 	{
-		for (IndexType index = startIndex; index < endIndex; ++index)
+		for (int64_t index = startIndex; index < endIndex; ++index)
 		{
-			body();
+			body(index);
 		}
 	}
+
+	template<typename BodyType>
+	void CriticalSection(BodyType&& body) noexcept
+	{
+		body();
+	}
 }
\ No newline at end of file